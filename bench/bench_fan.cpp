@@ -0,0 +1,179 @@
+// Native benchmark of the Fan environment logic.
+//
+//   pio run -e native_bench && .pio/build/native_bench/program
+//   pio run -e native_bench_fixed && .pio/build/native_bench_fixed/program
+//
+// Both envs replay the same telegram sequence, the second one with
+// FAN_FIXED_POINT. Compare the cycles per telegram of both runs. On the host
+// the FPU makes float cheap, the gap on the soft-float RP2040 is larger.
+// The module case runs the same sequence as DPT 9 telegrams through the
+// native KNX stand-in, including KO decoding and feedback encoding. The
+// shadow case adds an adaptive shadow controller on the same channel, the
+// difference to the plain module case is its cost per telegram.
+// The dpt9 cases decode the same telegrams into 1/100 units, once through
+// the generic KNX value conversion of the stand-in and once with the
+// Dpt9Decoder, the cached case sends every value twice like a cyclic sensor.
+#include "MaicoPPB30.h"
+#include "FanModule.h"
+#include "Dpt9Decoder.h"
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class NullFanHardware : public IFanHardware {
+public:
+    void init(uint8_t s1_pin, uint8_t s2_pin, uint8_t sw_pin) override {}
+    void setPWM(uint8_t pin, int16_t value) override {}
+    void setDigital(uint8_t pin, bool value) override {}
+    void startDirectionTimer(uint32_t intervalMs, std::function<void()> callback) override {}
+    void stopDirectionTimer() override {}
+    void startOneShotTimer(uint64_t delayMs, std::function<void()> callback) override {}
+    void stopOneShotTimer() override {}
+    void startOverrideTimer(uint64_t delayMs, std::function<void()> callback) override {}
+    void stopOverrideTimer() override {}
+    uint32_t getMillis() override { return nowMs; }
+
+    uint32_t nowMs = 0;
+};
+
+static uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    // no portable cycle counter, fall back to nanoseconds
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static const uint32_t Telegrams = 1000000;
+static volatile int32_t sink = 0;
+
+static void runCase(const char* name, Fan::ControlMode controlMode, Fan::HumiditySensorMode sensorMode) {
+    NullFanHardware hw;
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    fan.thresholdHumidityOn = 65;
+    fan.thresholdHumidityOff = 60;
+    fan.trendRiseRate = 1.5f;
+    fan.humiditySensorMode = sensorMode;
+    fan.setControlMode(controlMode);
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+    fan.setInsideTemperature(21.5f);
+    fan.setOutsideTemperature(8.25f);
+    fan.setOutsideHumidity(70.0f);
+
+    int32_t speedSum = 0;
+    uint64_t start = readCycles();
+    for (uint32_t i = 0; i < Telegrams; i++) {
+        // triangle between 40.00 and 89.99 %RH in DPT 9 resolution
+        uint32_t step = i % 10000;
+        float humidity = 40.0f + (step < 5000 ? step : 10000 - step) * 0.01f;
+        hw.nowMs += 1000;
+        fan.setInsideHumdity(humidity);
+        speedSum += fan.getFanSpeed();
+    }
+    uint64_t cycles = readCycles() - start;
+    sink = sink + speedSum;
+
+    printf("%-22s %8.1f cycles/telegram  (speed sum %ld)\n", name,
+           (double)cycles / Telegrams, (long)speedSum);
+}
+
+static void runModuleCase(const char* name, bool shadow) {
+    knx.reset();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 65);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed), 4);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TrendRate), 15);
+    if (shadow) {
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowEnable), 1);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowControlMode), 1 << FAN_CH_ShadowControlModeShift);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdOn), 60);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdOff), 55);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdSpeed), 4);
+    }
+
+    FanModule module;
+    module.setup(true);
+    GroupObject& ko = KoFAN_CH_HumidityInside;
+
+    uint32_t sentCount = 0;
+    uint64_t start = readCycles();
+    for (uint32_t i = 0; i < Telegrams; i++) {
+        uint32_t step = i % 10000;
+        float humidity = 40.0f + (step < 5000 ? step : 10000 - step) * 0.01f;
+        HostState::advanceMillis(1000);
+        ko.receive(humidity, DPT_Value_Humidity);
+        module.processInputKo(ko);
+        sentCount += knx.sent.size();
+        knx.sent.clear();
+    }
+    uint64_t cycles = readCycles() - start;
+
+    printf("%-22s %8.1f cycles/telegram  (sent %lu)\n", name,
+           (double)cycles / Telegrams, (unsigned long)sentCount);
+}
+
+enum DecodePath {
+    Decode_Generic,
+    Decode_Fast,
+    Decode_FastCached,
+};
+
+static void runDecodeCase(const char* name, DecodePath path) {
+    // encoded once, the loop only decodes; every value is repeated for the cache
+    static uint8_t telegrams[20000][2];
+    for (uint32_t i = 0; i < 20000; i++) {
+        uint32_t step = (i / 2) % 10000;
+        float humidity = 40.0f + (step < 5000 ? step : 10000 - step) * 0.01f;
+        KnxDpt::encode(humidity, DPT_Value_Humidity, telegrams[i]);
+    }
+
+    Dpt9Decoder decoder;
+    int64_t sum = 0;
+    uint64_t start = readCycles();
+    for (uint32_t i = 0; i < Telegrams; i++) {
+        const uint8_t* data = telegrams[i % 20000];
+        int32_t hundredths = 0;
+        switch (path) {
+        case Decode_Generic:
+            hundredths = lroundf((float)KnxDpt::decode(data, DPT_Value_Humidity) * 100);
+            break;
+        case Decode_Fast:
+            Dpt9Decoder::toHundredths((data[0] << 8) | data[1], hundredths);
+            break;
+        case Decode_FastCached:
+            decoder.decode(data, hundredths);
+            break;
+        }
+        sum += hundredths;
+    }
+    uint64_t cycles = readCycles() - start;
+    sink = sink + (int32_t)sum;
+
+    printf("%-22s %8.1f cycles/telegram  (sum %lld)\n", name,
+           (double)cycles / Telegrams, (long long)sum);
+}
+
+int main() {
+#ifdef FAN_FIXED_POINT
+    printf("Fan environment logic, fixed point (0.01 units)\n");
+#else
+    printf("Fan environment logic, float\n");
+#endif
+    runCase("threshold/relative", Fan::ControlMode::Threshold, Fan::HumiditySensorMode::Relative);
+    runCase("adaptive/relative", Fan::ControlMode::Adaptive, Fan::HumiditySensorMode::Relative);
+    runCase("predictive/relative", Fan::ControlMode::Predictive, Fan::HumiditySensorMode::Relative);
+    runCase("threshold/absolute", Fan::ControlMode::Threshold, Fan::HumiditySensorMode::Absolute);
+    runModuleCase("module/threshold", false);
+    runModuleCase("module/shadow", true);
+    runDecodeCase("dpt9/generic", Decode_Generic);
+    runDecodeCase("dpt9/fast", Decode_Fast);
+    runDecodeCase("dpt9/fast cached", Decode_FastCached);
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Fan energy of the control modes on recorded traces.
+//
+//   pio run -e native_energy
+//   .pio/build/native_energy/program <in.trace> [--tau <min>] [--tail <min>] [--deadline <min>] [--no-trend]
+//
+// Traces are the binary format of bench/trace_fan.cpp (text2trace converts
+// the text format, e.g. bench/traces/shower.txt). The recorded inside
+// humidity of channel 1 does not react to a different fan, so it is turned
+// into the moisture load of a room model instead: every rise of the recording
+// adds moisture, the fan removes the excess over the first recorded value
+// with a time constant of --tau minutes at step 5 (default 30) and
+// proportionally less at lower steps. Each control mode runs the whole module
+// with the parameters of the trace against its own copy of that room, the
+// simulated humidity is sent every minute in place of the recorded one. All
+// other telegrams are replayed as recorded. --tail keeps simulating after the
+// last telegram (default 120 minutes). --deadline replaces the deadline of
+// the predictive mode from the trace (30 minutes if the trace has none).
+// --no-trend switches the fast rise detection off, its boost runs the same
+// step in every mode.
+//
+// Fan power is taken as the cube of the step. Reported per mode: energy in
+// hours at step 5, run time, time above the off threshold and the peak.
+#include "FanModule.h"
+#include "FanTrace.h"
+#include "knx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+static const uint32_t TickMs = 1000;
+static const uint32_t SensorPeriodMs = 60000;
+
+struct Sample {
+    uint32_t timeMs;
+    float humidity;
+};
+
+struct Result {
+    double energy = 0;      // hours at step 5
+    double runMinutes = 0;
+    double aboveMinutes = 0; // above the off threshold
+    float peak = 0;
+};
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + count);
+    fclose(file);
+    return true;
+}
+
+static Result run(const std::vector<uint8_t>& data, uint8_t controlMode, bool trend, uint8_t deadlineMinutes, double tauMinutes, uint32_t tailMs,
+                  const std::vector<Sample>& recorded) {
+    FanTraceReader reader(data.data(), data.size());
+    knx.reset();
+    HostState::reset();
+    openknx.setAfterStartupDelay(true);
+    for (uint16_t i = 0; i < reader.paramSize(); i++)
+        knx.setParamByte(i, reader.params()[i]);
+
+    uint8_t _channelIndex = 0;
+    uint16_t controlAddress = FAN_ParamCalcIndex(FAN_CH_ControlMode);
+    knx.setParamByte(controlAddress, (knx.paramByte(controlAddress) & ~FAN_CH_ControlModeMask) |
+                                         controlMode << FAN_CH_ControlModeShift);
+    // traces from before the predictive mode have no values for it
+    if (deadlineMinutes)
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_PredictDeadline), deadlineMinutes);
+    else if (!ParamFAN_CH_PredictDeadline)
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_PredictDeadline), 30);
+    if (!ParamFAN_CH_PredictTimeConstant)
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_PredictTimeConstant), 30);
+    if (!trend)
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TrendRate), 0);
+    float thresholdOff = ParamFAN_CH_ThresholdHumidityOff;
+
+    std::unique_ptr<FanModule> module(new FanModule());
+    module->setup(true);
+    module->processAfterStartupDelay();
+
+    uint16_t humidityAsap = FAN_KoCalcNumber(FAN_KoCH_HumidityInside);
+    GroupObject& humidityKo = knx.getGroupObject(humidityAsap);
+    GroupObject& levelKo = knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_LevelFeedback));
+
+    Result result;
+    float floor = recorded.front().humidity;
+    float humidity = floor;
+    size_t next = 0; // next recorded sample, its rise is the load until then
+    uint32_t endMs = recorded.back().timeMs + tailMs;
+    uint32_t nextSensorMs = 0;
+    FanTrace::Record record;
+    bool pending = reader.next(record);
+    while (millis() < endMs) {
+        uint32_t now = millis();
+        while (pending && record.timeMs <= now) {
+            if (record.asap != humidityAsap) {
+                GroupObject& ko = knx.getGroupObject(record.asap);
+                ko.receiveRaw(record.data, record.size);
+                module->processInputKo(ko);
+            }
+            pending = reader.next(record);
+        }
+        if (now >= nextSensorMs) {
+            nextSensorMs = now + SensorPeriodMs;
+            humidityKo.receive(humidity, DPT_Value_Humidity);
+            module->processInputKo(humidityKo);
+        }
+
+        HostState::advanceMillis(TickMs);
+        module->loop();
+        knx.sent.clear();
+
+        int step = (uint8_t)levelKo.value(DPT_Value_1_Ucount);
+        double hours = TickMs / 3600000.0;
+        while (next < recorded.size() && recorded[next].timeMs <= now)
+            next++;
+        if (next > 0 && next < recorded.size()) {
+            float rise = recorded[next].humidity - recorded[next - 1].humidity;
+            if (rise > 0)
+                humidity += rise * TickMs / (recorded[next].timeMs - recorded[next - 1].timeMs);
+        }
+        humidity -= (humidity - floor) * step / Fan::StepCount * (float)(hours * 60 / tauMinutes);
+
+        result.energy += hours * step * step * step / (Fan::StepCount * Fan::StepCount * Fan::StepCount);
+        result.runMinutes += step > 0 ? TickMs / 60000.0 : 0;
+        result.aboveMinutes += humidity >= thresholdOff ? TickMs / 60000.0 : 0;
+        if (humidity > result.peak)
+            result.peak = humidity;
+    }
+    return result;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <in.trace> [--tau <min>] [--tail <min>] [--deadline <min>] [--no-trend]\n", argv[0]);
+        return 2;
+    }
+    double tauMinutes = 30;
+    uint32_t tailMs = 120 * 60000;
+    bool trend = true;
+    uint8_t deadlineMinutes = 0;
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--no-trend"))
+            trend = false;
+        else if (!strcmp(argv[i], "--tau") && i + 1 < argc)
+            tauMinutes = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--deadline") && i + 1 < argc)
+            deadlineMinutes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tail") && i + 1 < argc)
+            tailMs = strtoul(argv[++i], nullptr, 10) * 60000;
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (tauMinutes <= 0) {
+        fprintf(stderr, "--tau has to be positive\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(argv[1], data)) {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return 1;
+    }
+    FanTraceReader reader(data.data(), data.size());
+    if (!reader.valid() || reader.paramSize() > KnxFacade::ParamSize) {
+        fprintf(stderr, "%s is no valid fan trace\n", argv[1]);
+        return 1;
+    }
+
+    // inside humidity of channel 1 as recorded
+    uint8_t _channelIndex = 0;
+    std::vector<Sample> recorded;
+    FanTrace::Record record;
+    while (reader.next(record)) {
+        if (record.asap == FAN_KoCalcNumber(FAN_KoCH_HumidityInside))
+            recorded.push_back({record.timeMs, (float)KnxDpt::decode(record.data, DPT_Value_Humidity)});
+    }
+    if (recorded.size() < 2) {
+        fprintf(stderr, "%s has less than two humidity telegrams for channel 1\n", argv[1]);
+        return 1;
+    }
+
+    static const char* const Modes[] = {"threshold", "adaptive", "predictive"};
+    printf("%-12s %10s %10s %10s %8s\n", "mode", "energy", "run min", "above min", "peak");
+    for (uint8_t mode = 0; mode < 3; mode++) {
+        Result result = run(data, mode, trend, deadlineMinutes, tauMinutes, tailMs, recorded);
+        printf("%-12s %10.3f %10.1f %10.1f %8.1f\n", Modes[mode], result.energy, result.runMinutes,
+               result.aboveMinutes, result.peak);
+    }
+    return 0;
+}
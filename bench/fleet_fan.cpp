@@ -0,0 +1,168 @@
+// Fleet simulation of the fan control over a year of hourly weather and
+// indoor moisture, to compare thresholds and gains before roll-out.
+//
+//   pio run -e native_fleet
+//   .pio/build/native_fleet/program <configs.txt> [--weather <hours.txt>] [--buildings <n>]
+//                                   [--threads <n>] [--verify <n>]
+//
+// bench/fleet/configs.txt lists example configurations, one per line:
+//
+//   # name  control(threshold|adaptive) sensor(relative|absolute) on off speed gain limit
+//   thr60   threshold relative 60 55 4 0.18 70
+//
+// Every configuration runs against the same --buildings virtual rooms
+// (default 25000). --weather reads one line per hour,
+//
+//   <outside °C> <outside %RH> <inside °C> <moisture g/h>
+//
+// without it a synthetic year is used. --verify runs <n> fans per
+// configuration through the scalar MaicoPPB30 as well and fails on any
+// difference. Reported per configuration: mean run hours, speed changes and
+// hours at or above the humidity limit per fan, and the worst building.
+#include "FanFleet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+static bool readConfigs(const char* path, std::vector<FanFleet::Config>& configs) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    uint32_t lineNumber = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char name[64], control[16], sensor[16];
+        FanFleet::Config config;
+        int speed = 0;
+        if (line[0] == '#' || strspn(line, " \t\r\n") == strlen(line))
+            continue;
+        if (sscanf(line, "%63s %15s %15s %f %f %d %f %f", name, control, sensor, &config.thresholdOn,
+                   &config.thresholdOff, &speed, &config.controlGain, &config.humidityLimit) != 8 ||
+            (strcmp(control, "threshold") && strcmp(control, "adaptive")) ||
+            (strcmp(sensor, "relative") && strcmp(sensor, "absolute"))) {
+            fprintf(stderr, "%s:%lu: invalid configuration\n", path, (unsigned long)lineNumber);
+            ok = false;
+            break;
+        }
+        config.name = name;
+        config.controlMode = strcmp(control, "adaptive") ? Fan::ControlMode::Threshold : Fan::ControlMode::Adaptive;
+        config.sensorMode = strcmp(sensor, "absolute") ? Fan::HumiditySensorMode::Relative
+                                                       : Fan::HumiditySensorMode::Absolute;
+        config.thresholdSpeed = speed;
+        configs.push_back(config);
+    }
+    fclose(file);
+    return ok && !configs.empty();
+}
+
+static bool readWeather(const char* path, std::vector<FanFleet::Hour>& hours) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        FanFleet::Hour hour;
+        if (line[0] == '#' || strspn(line, " \t\r\n") == strlen(line))
+            continue;
+        if (sscanf(line, "%f %f %f %f", &hour.outsideTemperature, &hour.outsideHumidity,
+                   &hour.insideTemperature, &hour.moisture) != 4) {
+            fprintf(stderr, "%s: invalid line after hour %lu\n", path, (unsigned long)hours.size());
+            fclose(file);
+            return false;
+        }
+        hours.push_back(hour);
+    }
+    fclose(file);
+    return !hours.empty();
+}
+
+// compares the first fans of every configuration with the scalar reference
+static bool verify(const FanFleet& fleet, const std::vector<FanFleet::Config>& configs, uint32_t buildings,
+                   uint32_t count, const std::vector<FanFleet::Hour>& hours) {
+    uint32_t mismatches = 0;
+    if (count > buildings)
+        count = buildings;
+    for (size_t c = 0; c < configs.size(); c++) {
+        for (uint32_t b = 0; b < count; b++) {
+            FanFleet::Metrics vector = fleet.metrics(c * buildings + b);
+            FanFleet::Metrics scalar = FanFleet::simulateScalar(configs[c], FanFleet::building(b), hours);
+            if (vector.runHours != scalar.runHours || vector.switches != scalar.switches ||
+                vector.hoursAbove != scalar.hoursAbove) {
+                if (mismatches++ < 10)
+                    fprintf(stderr, "verify: %s building %lu: run %lu/%lu switches %lu/%lu above %lu/%lu\n",
+                            configs[c].name.c_str(), (unsigned long)b, (unsigned long)vector.runHours,
+                            (unsigned long)scalar.runHours, (unsigned long)vector.switches,
+                            (unsigned long)scalar.switches, (unsigned long)vector.hoursAbove,
+                            (unsigned long)scalar.hoursAbove);
+            }
+        }
+    }
+    fprintf(stderr, "verify: %lu fans, %lu differ from the scalar Fan\n", (unsigned long)(count * configs.size()),
+            (unsigned long)mismatches);
+    return mismatches == 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <configs.txt> [--weather <hours.txt>] [--buildings <n>] [--threads <n>] "
+                        "[--verify <n>]\n", argv[0]);
+        return 2;
+    }
+
+    const char* weatherPath = nullptr;
+    uint32_t buildings = 25000;
+    unsigned threads = std::thread::hardware_concurrency();
+    uint32_t verifyCount = 0;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--weather"))
+            weatherPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--buildings"))
+            buildings = strtoul(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads"))
+            threads = strtoul(argv[i + 1], nullptr, 10);
+        else if (!strcmp(argv[i], "--verify"))
+            verifyCount = strtoul(argv[i + 1], nullptr, 10);
+        else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (threads == 0)
+        threads = 1;
+
+    std::vector<FanFleet::Config> configs;
+    if (!readConfigs(argv[1], configs))
+        return 1;
+    std::vector<FanFleet::Hour> hours;
+    if (weatherPath ? !readWeather(weatherPath, hours) : (hours = FanFleet::syntheticYear(), false))
+        return 1;
+
+    FanFleet fleet(configs, buildings);
+    auto start = std::chrono::steady_clock::now();
+    fleet.run(hours, threads);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-16s %8s %10s %10s %10s %10s\n", "config", "fans", "run h", "switches", "h above", "max above");
+    for (size_t c = 0; c < configs.size(); c++) {
+        const FanFleet::Result& result = fleet.result(c);
+        double fans = result.fans ? result.fans : 1;
+        printf("%-16s %8lu %10.1f %10.1f %10.1f %10lu\n", configs[c].name.c_str(), (unsigned long)result.fans,
+               result.runHours / fans, result.switches / fans, result.hoursAbove / fans,
+               (unsigned long)result.maxHoursAbove);
+    }
+    double fanHours = (double)fleet.fanCount() * hours.size();
+    fprintf(stderr, "%.0f fan hours in %.2f s, %.1f M fan hours/s, %u threads\n", fanHours, seconds,
+            fanHours / seconds / 1e6, threads);
+
+    if (verifyCount && !verify(fleet, configs, buildings, verifyCount, hours))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,65 @@
+# Flash/RAM report per translation unit of the fan module (PlatformIO extra script).
+#
+#   extra_scripts = post:bench/footprint.py
+#   custom_budget_flash = <bytes>   ; text + data of all module objects, 0 = report only
+#   custom_budget_ram = <bytes>     ; data + bss of all module objects, 0 = report only
+#   custom_footprint_src = <dir>    ; module sources, default src of the project
+#
+# Runs after the link of the program, sums the sections of the objects built
+# from src/ and fails the build when a budget is exceeded. Works for the
+# native envs and for a firmware env that embeds the module, the size tool of
+# the toolchain is used when the platform defines one.
+import os
+import subprocess
+
+Import("env")
+
+
+def module_objects(build_dir, src_dir):
+    # objects are named <source>.o or <source>.cpp.o depending on the builder
+    units = set(name[:-4] for name in os.listdir(src_dir) if name.endswith(".cpp"))
+    objects = []
+    for root, _, files in os.walk(build_dir):
+        for name in files:
+            if name.endswith(".o") and name[:-2].replace(".cpp", "") in units:
+                objects.append(os.path.join(root, name))
+    return sorted(objects, key=os.path.basename)
+
+
+def object_sizes(size_tool, path):
+    # Berkeley format: text data bss dec hex filename
+    output = subprocess.check_output([size_tool, path], universal_newlines=True)
+    text, data, bss = output.splitlines()[1].split()[:3]
+    return int(text), int(data), int(bss)
+
+
+def report(source, target, env):
+    size_tool = env.subst("$SIZETOOL") or "size"
+    build_dir = env.subst("$BUILD_DIR")
+    src_dir = os.path.join(env.subst("$PROJECT_DIR"), env.GetProjectOption("custom_footprint_src", "src"))
+    budget_flash = int(env.GetProjectOption("custom_budget_flash", "0"))
+    budget_ram = int(env.GetProjectOption("custom_budget_ram", "0"))
+
+    total_flash = 0
+    total_ram = 0
+    print("%-28s %8s %8s %8s" % ("translation unit", "text", "data", "bss"))
+    for path in module_objects(build_dir, src_dir):
+        text, data, bss = object_sizes(size_tool, path)
+        total_flash += text + data
+        total_ram += data + bss
+        print("%-28s %8d %8d %8d" % (os.path.basename(path)[:-2].replace(".cpp", ""), text, data, bss))
+
+    failed = False
+    for name, value, budget in (("flash", total_flash, budget_flash), ("static RAM", total_ram, budget_ram)):
+        if budget and value > budget:
+            print("%-12s %8d bytes  (budget %d)  EXCEEDED" % (name, value, budget))
+            failed = True
+        elif budget:
+            print("%-12s %8d bytes  (budget %d)" % (name, value, budget))
+        else:
+            print("%-12s %8d bytes" % (name, value))
+    if failed:
+        env.Exit(1)
+
+
+env.AddPostAction("$PROGPATH", report)
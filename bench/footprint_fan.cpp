@@ -0,0 +1,115 @@
+// Memory footprint report and budget gate of the fan module.
+//
+//   pio run -e native_footprint -t exec
+//
+// Prints the object size of every class of the module, the static RAM of the
+// module instance and the heap allocated by FanModule::setup(). The program
+// exits with 1 when one of the FAN_BUDGET_* limits is exceeded, the limits are
+// set in platformio.ini. bench/footprint.py adds the flash and RAM of each
+// translation unit after the link and checks custom_budget_flash/ram.
+//
+// Sizes are measured on the host (64 bit pointers), they are an upper bound
+// for the 32 bit RP2040 and meant to catch growth, not to predict the image.
+#include "FanModule.h"
+#include "FanTrace.h"
+#include "knx.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#ifndef FAN_BUDGET_MODULE
+#define FAN_BUDGET_MODULE 0 // sizeof(FanModule), 0 = report only
+#endif
+#ifndef FAN_BUDGET_HEAP
+#define FAN_BUDGET_HEAP 0 // heap bytes after setup, 0 = report only
+#endif
+
+static size_t heapBytes = 0;
+static size_t heapBlocks = 0;
+
+// every allocation carries its size in front, so delete can account for it
+void* operator new(size_t size) {
+    size_t* block = static_cast<size_t*>(malloc(size + sizeof(size_t)));
+    if (!block)
+        throw std::bad_alloc();
+    *block = size;
+    heapBytes += size;
+    heapBlocks++;
+    return block + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr)
+        return;
+    size_t* block = static_cast<size_t*>(ptr) - 1;
+    heapBytes -= *block;
+    heapBlocks--;
+    free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+#define REPORT_SIZE(type) printf("  %-24s %6lu\n", #type, (unsigned long)sizeof(type))
+
+static bool checkBudget(const char* name, size_t value, size_t budget) {
+    if (budget == 0) {
+        printf("%-26s %6lu bytes\n", name, (unsigned long)value);
+        return true;
+    }
+    bool ok = value <= budget;
+    printf("%-26s %6lu bytes  (budget %lu)%s\n", name, (unsigned long)value, (unsigned long)budget,
+           ok ? "" : "  EXCEEDED");
+    return ok;
+}
+
+int main() {
+    printf("object sizes\n");
+    REPORT_SIZE(Fan);
+    REPORT_SIZE(MaicoPPB30);
+    REPORT_SIZE(RP2040FanHardware);
+    REPORT_SIZE(FanTimerWheel);
+    REPORT_SIZE(FanTimer);
+    REPORT_SIZE(FanSchedule);
+    REPORT_SIZE(HumidityTrend);
+    REPORT_SIZE(FanAutoTune);
+    REPORT_SIZE(FanPredictor);
+    REPORT_SIZE(SensorAggregate);
+    REPORT_SIZE(FanPhaseSync);
+    REPORT_SIZE(FanShadow);
+    REPORT_SIZE(FanSpeedCurve);
+    REPORT_SIZE(FanHistory);
+    REPORT_SIZE(FanChannel);
+    REPORT_SIZE(FanModule);
+    REPORT_SIZE(FanTraceWriter);
+    REPORT_SIZE(std::function<void()>);
+    printf("\n");
+
+    // all features enabled, so setup allocates everything it can
+    knx.reset();
+    for (uint8_t _channelIndex = 0; _channelIndex < FAN_ChannelCount; _channelIndex++) {
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SchedActive), 1);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ControlMode), 3 << FAN_CH_ControlModeShift);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowEnable), 1);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowControlMode), 3 << FAN_CH_ShadowControlModeShift);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_HistoryEnable), 1);
+        for (uint8_t i = 0; i < FanSchedule::MaxSwitchPoints; i++)
+            knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched1Day) + i * 4, FanSchedule::Daily);
+    }
+
+    size_t heapBefore = heapBytes;
+    size_t blocksBefore = heapBlocks;
+    FanModule* module = new FanModule();
+    size_t moduleHeap = heapBytes - heapBefore - sizeof(FanModule);
+    module->setup(true);
+    size_t setupHeap = heapBytes - heapBefore - sizeof(FanModule);
+
+    bool ok = true;
+    ok &= checkBudget("module static RAM", sizeof(FanModule), FAN_BUDGET_MODULE);
+    ok &= checkBudget("heap after setup", setupHeap, FAN_BUDGET_HEAP);
+    printf("  %lu blocks, %lu bytes from the constructor\n",
+           (unsigned long)(heapBlocks - blocksBefore - 1), (unsigned long)moduleHeap);
+    return ok ? 0 : 1;
+}
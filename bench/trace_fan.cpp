@@ -0,0 +1,224 @@
+// Record/replay tool for received KNX telegrams of the fan module.
+//
+//   pio run -e native_trace
+//   .pio/build/native_trace/program text2trace <in.txt> <out.trace>
+//   .pio/build/native_trace/program trace2text <in.trace>
+//   .pio/build/native_trace/program replay <in.trace> [--speed <factor>] [--tick <ms>] [--tail <ms>] [--tickless]
+//                                          [--dwell <on>,<off>,<step>[,<band>]]
+//
+// bench/traces/shower.txt is a small example trace in the text format,
+// bench/traces/dewpoint.txt an absolute humidity channel close to the outside
+// dew point for the anti-chatter parameters.
+//
+// Traces come from a device built with -DFAN_TRACE_SIZE=<bytes> (see
+// FanModule::trace()) or are written by hand in the text format:
+//
+//   # comment
+//   P <address> <hex bytes>        parameter memory, address in hex
+//   T <ms> <ko number> <hex bytes> telegram, ms since start of recording
+//
+// replay prints every PWM, digital and KO write of the module to stdout, one
+// line each, and the throughput and latency percentiles to stderr. Without
+// --speed the trace runs as fast as possible in virtual time, the output is
+// identical either way. --tickless sleeps in FanModule::idle() until the next
+// deadline or telegram instead of calling loop() every tick; the output has
+// to match a replay with --tick 1, the wake-ups and the share of time asleep
+// are printed to stderr. --dwell replaces the anti-chatter parameters of all
+// channels: minimum on, off and step time in minutes and the dew point band in
+// 0.1 K. The number of speed changes is printed to stderr, replays with and
+// without --dwell show how much switching the parameters save on a trace.
+#include "FanTrace.h"
+#include "FanTraceReplay.h"
+#include "Arduino.h"
+#include "knx.h"
+#include "knxprod.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+    uint8_t chunk[4096];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + count);
+    fclose(file);
+    return true;
+}
+
+static size_t parseHex(char* text, uint8_t* bytes, size_t maxBytes) {
+    size_t count = 0;
+    for (char* token = strtok(text, " \t\r\n"); token && count < maxBytes; token = strtok(nullptr, " \t\r\n"))
+        bytes[count++] = static_cast<uint8_t>(strtoul(token, nullptr, 16));
+    return count;
+}
+
+static int textToTrace(const char* inPath, const char* outPath) {
+    FILE* in = fopen(inPath, "r");
+    if (!in) {
+        fprintf(stderr, "cannot open %s\n", inPath);
+        return 1;
+    }
+
+    uint8_t params[KnxFacade::ParamSize] = {};
+    uint16_t paramSize = 0;
+    struct Telegram {
+        uint32_t timeMs;
+        uint16_t asap;
+        uint8_t size;
+        uint8_t data[FanTrace::MaxPayload];
+    };
+    std::vector<Telegram> telegrams;
+
+    char line[512];
+    unsigned lineNumber = 0;
+    while (fgets(line, sizeof(line), in)) {
+        lineNumber++;
+        char* text = line + strspn(line, " \t");
+        if (*text == 'P') {
+            char* end;
+            unsigned long address = strtoul(text + 1, &end, 16);
+            uint8_t bytes[KnxFacade::ParamSize];
+            size_t count = parseHex(end, bytes, sizeof(bytes));
+            if (address + count > sizeof(params)) {
+                fprintf(stderr, "%s:%u: parameter out of range\n", inPath, lineNumber);
+                fclose(in);
+                return 1;
+            }
+            memcpy(params + address, bytes, count);
+            if (address + count > paramSize)
+                paramSize = address + count;
+        } else if (*text == 'T') {
+            char* end;
+            Telegram telegram;
+            telegram.timeMs = strtoul(text + 1, &end, 10);
+            telegram.asap = strtoul(end, &end, 10);
+            telegram.size = parseHex(end, telegram.data, sizeof(telegram.data));
+            if (!telegrams.empty() && telegram.timeMs < telegrams.back().timeMs) {
+                fprintf(stderr, "%s:%u: time goes backwards\n", inPath, lineNumber);
+                fclose(in);
+                return 1;
+            }
+            telegrams.push_back(telegram);
+        }
+    }
+    fclose(in);
+
+    std::vector<uint8_t> buffer(FanTrace::HeaderSize + paramSize + telegrams.size() * (10 + FanTrace::MaxPayload));
+    FanTraceWriter writer(buffer.data(), buffer.size());
+    writer.begin(params, paramSize, 0);
+    for (const Telegram& telegram : telegrams)
+        writer.record(telegram.timeMs, telegram.asap, telegram.data, telegram.size);
+
+    FILE* out = fopen(outPath, "wb");
+    if (!out || fwrite(writer.data(), 1, writer.size(), out) != writer.size()) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        if (out)
+            fclose(out);
+        return 1;
+    }
+    fclose(out);
+    fprintf(stderr, "%zu telegrams, %zu bytes\n", telegrams.size(), writer.size());
+    return 0;
+}
+
+static int traceToText(const char* inPath) {
+    std::vector<uint8_t> data;
+    if (!readFile(inPath, data)) {
+        fprintf(stderr, "cannot open %s\n", inPath);
+        return 1;
+    }
+    FanTraceReader reader(data.data(), data.size());
+    if (!reader.valid()) {
+        fprintf(stderr, "%s is no fan trace\n", inPath);
+        return 1;
+    }
+
+    for (uint16_t address = 0; address < reader.paramSize(); address += 16) {
+        printf("P %04X", address);
+        for (uint16_t i = address; i < reader.paramSize() && i < address + 16; i++)
+            printf(" %02X", reader.params()[i]);
+        printf("\n");
+    }
+    FanTrace::Record record;
+    while (reader.next(record)) {
+        printf("T %lu %u", (unsigned long)record.timeMs, record.asap);
+        for (uint8_t i = 0; i < record.size; i++)
+            printf(" %02X", record.data[i]);
+        printf("\n");
+    }
+    return 0;
+}
+
+static int replay(int argc, char** argv) {
+    std::vector<uint8_t> data;
+    if (!readFile(argv[0], data)) {
+        fprintf(stderr, "cannot open %s\n", argv[0]);
+        return 1;
+    }
+
+    FanTraceReplay::Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tickless") == 0)
+            options.tickless = true;
+        else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+            options.speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--tick") == 0 && i + 1 < argc)
+            options.tickMs = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--tail") == 0 && i + 1 < argc)
+            options.tailMs = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--dwell") == 0 && i + 1 < argc) {
+            unsigned on = 0, off = 0, step = 0, band = 0;
+            if (sscanf(argv[++i], "%u,%u,%u,%u", &on, &off, &step, &band) < 3) {
+                fprintf(stderr, "--dwell expects <on>,<off>,<step>[,<band>]\n");
+                return 1;
+            }
+            for (uint8_t _channelIndex = 0; _channelIndex < FAN_ChannelCount; _channelIndex++) {
+                options.params.push_back({FAN_ParamCalcIndex(FAN_CH_AutoMinOnTime), (uint8_t)on});
+                options.params.push_back({FAN_ParamCalcIndex(FAN_CH_AutoMinOffTime), (uint8_t)off});
+                options.params.push_back({FAN_ParamCalcIndex(FAN_CH_AutoMinStepTime), (uint8_t)step});
+                options.params.push_back({FAN_ParamCalcIndex(FAN_CH_DewPointHysteresis), (uint8_t)band});
+            }
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    FanTraceReplay replay;
+    if (!replay.run(data.data(), data.size(), options)) {
+        fprintf(stderr, "%s is no valid fan trace\n", argv[0]);
+        return 1;
+    }
+    fputs(replay.output().c_str(), stdout);
+
+    const FanTraceReplay::Stats& stats = replay.stats();
+    fprintf(stderr, "%u telegrams, %.0f telegrams/s\n", stats.telegrams, stats.telegramsPerSecond());
+    fprintf(stderr, "latency p50 %u ns, p90 %u ns, p99 %u ns, max %u ns\n", stats.percentileNs(50),
+            stats.percentileNs(90), stats.percentileNs(99), stats.percentileNs(100));
+    fprintf(stderr, "%u speed changes\n", stats.speedChanges);
+    if (options.tickless && millis() > 0)
+        fprintf(stderr, "tickless: %u wake-ups, %.1f per minute, asleep %.2f %% of %lu ms\n", stats.loops,
+                stats.loops * 60000.0 / millis(), stats.sleptMs * 100.0 / millis(), (unsigned long)millis());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && strcmp(argv[1], "text2trace") == 0)
+        return textToTrace(argv[2], argv[3]);
+    if (argc >= 3 && strcmp(argv[1], "trace2text") == 0)
+        return traceToText(argv[2]);
+    if (argc >= 3 && strcmp(argv[1], "replay") == 0)
+        return replay(argc - 2, argv + 2);
+
+    fprintf(stderr, "usage: %s text2trace <in.txt> <out.trace>\n"
+                    "       %s trace2text <in.trace>\n"
+                    "       %s replay <in.trace> [--speed <factor>] [--tick <ms>] [--tail <ms>] [--tickless]\n"
+                    "                  [--dwell <on>,<off>,<step>[,<band>]]\n",
+            argv[0], argv[0], argv[0]);
+    return 1;
+}
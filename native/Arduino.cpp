@@ -0,0 +1,99 @@
+#include "Arduino.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include <string.h>
+
+namespace HostState {
+    uint64_t timeUs = 0;
+    int16_t pwm[PinCount];
+    bool digital[PinCount];
+    uint8_t pinModes[PinCount];
+    uint8_t pinFunctions[PinCount];
+    PwmSlice pwmSlices[SliceCount];
+    void (*pinWriteHook)(uint8_t pin, int value, bool analog) = nullptr;
+    uint64_t sleptUs = 0;
+    uint32_t sleeps = 0;
+
+    void advanceMillis(uint64_t ms) {
+        timeUs += ms * 1000;
+    }
+
+    void reset() {
+        timeUs = 0;
+        memset(pwm, 0, sizeof(pwm));
+        memset(digital, 0, sizeof(digital));
+        memset(pinModes, 0, sizeof(pinModes));
+        memset(pinFunctions, 0, sizeof(pinFunctions));
+        memset(pwmSlices, 0, sizeof(pwmSlices));
+        pinWriteHook = nullptr;
+        sleptUs = 0;
+        sleeps = 0;
+    }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < HostState::PinCount)
+        HostState::pinModes[pin] = mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (pin < HostState::PinCount)
+        HostState::digital[pin] = value != LOW;
+    if (HostState::pinWriteHook)
+        HostState::pinWriteHook(pin, value, false);
+}
+
+uint32_t pwm_gpio_to_slice_num(uint32_t gpio) {
+    return (gpio >> 1) & (HostState::SliceCount - 1);
+}
+
+void pwm_set_wrap(uint32_t slice, uint16_t wrap) {
+    HostState::pwmSlices[slice].wrap = wrap;
+}
+
+void pwm_set_clkdiv_int_frac(uint32_t slice, uint8_t integer, uint8_t fract) {
+    HostState::pwmSlices[slice].div16 = integer << 4 | fract;
+}
+
+void pwm_set_enabled(uint32_t slice, bool enabled) {
+    HostState::pwmSlices[slice].enabled = enabled;
+}
+
+void pwm_set_gpio_level(uint32_t gpio, uint16_t level) {
+    if (gpio < HostState::PinCount)
+        HostState::pwm[gpio] = level;
+    if (HostState::pinWriteHook)
+        HostState::pinWriteHook(gpio, level, true);
+}
+
+void gpio_set_function(uint32_t gpio, enum gpio_function fn) {
+    if (gpio < HostState::PinCount)
+        HostState::pinFunctions[gpio] = fn;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index) {
+    return 125000000;
+}
+
+uint32_t millis() {
+    return static_cast<uint32_t>(HostState::timeUs / 1000);
+}
+
+uint64_t time_us_64() {
+    return HostState::timeUs;
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms) {
+    return HostState::timeUs + (uint64_t)ms * 1000;
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout) {
+    if (timeout > HostState::timeUs) {
+        HostState::sleptUs += timeout - HostState::timeUs;
+        HostState::sleeps++;
+        HostState::timeUs = timeout;
+    }
+    return true;
+}
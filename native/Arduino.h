@@ -0,0 +1,39 @@
+#pragma once
+// Host-side stand-in for the Arduino core functions used by the fan module.
+// Pin writes are recorded and time is virtual, see HostState.
+#include <stdint.h>
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+uint32_t millis();
+
+namespace HostState {
+    static constexpr uint8_t PinCount = 32;
+    static constexpr uint8_t SliceCount = 8;
+
+    struct PwmSlice {
+        uint16_t wrap;
+        uint16_t div16; // clock divider in 1/16 units
+        bool enabled;
+    };
+
+    extern uint64_t timeUs;
+    extern int16_t pwm[PinCount];
+    extern bool digital[PinCount];
+    extern uint8_t pinModes[PinCount];
+    extern uint8_t pinFunctions[PinCount];
+    extern PwmSlice pwmSlices[SliceCount];
+    // called for every PWM level and digitalWrite, e.g. to capture traces
+    extern void (*pinWriteHook)(uint8_t pin, int value, bool analog);
+    // virtual time spent in best_effort_wfe_or_timeout() and number of sleeps
+    extern uint64_t sleptUs;
+    extern uint32_t sleeps;
+
+    void advanceMillis(uint64_t ms);
+    void reset();
+}
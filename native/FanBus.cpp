@@ -0,0 +1,127 @@
+#include "FanBus.h"
+#include "FanModule.h"
+#include <algorithm>
+#include <utility>
+
+FanBus::FanBus() : _timeUs(HostState::timeUs) {}
+
+FanBus::~FanBus() = default;
+
+size_t FanBus::addDevice(const std::function<void()>& configure) {
+    _devices.emplace_back(new Device());
+    size_t index = _devices.size() - 1;
+    Device& device = *_devices.back();
+    enter(device);
+    configure();
+    // the fans claim their pins on construction, so the module is created in place as well
+    device.module.reset(new FanModule());
+    device.module->setup(true);
+    device.module->processAfterStartupDelay();
+    device.module->loop(); // brings the timer wheel of a device added later to the current time
+    collect(index);
+    leave(device);
+    deliver();
+    return index;
+}
+
+void FanBus::connect(uint16_t asap) {
+    if (!connected(asap))
+        _connected.push_back(asap);
+}
+
+bool FanBus::connected(uint16_t asap) const {
+    return std::find(_connected.begin(), _connected.end(), asap) != _connected.end();
+}
+
+void FanBus::setAttached(size_t device, bool attached) {
+    _devices[device]->attached = attached;
+}
+
+void FanBus::setClockDrift(size_t device, int32_t ppm) {
+    _devices[device]->driftPpm = ppm;
+}
+
+void FanBus::enter(Device& device) {
+    std::swap(knx, device.knx);
+    std::swap(HostState::pwm, device.pins.pwm);
+    std::swap(HostState::digital, device.pins.digital);
+    std::swap(HostState::pinModes, device.pins.pinModes);
+    std::swap(HostState::pinFunctions, device.pins.pinFunctions);
+    std::swap(HostState::pwmSlices, device.pins.pwmSlices);
+    HostState::timeUs = _timeUs + static_cast<int64_t>(_timeUs) * device.driftPpm / 1000000;
+}
+
+void FanBus::leave(Device& device) {
+    std::swap(knx, device.knx);
+    std::swap(HostState::pwm, device.pins.pwm);
+    std::swap(HostState::digital, device.pins.digital);
+    std::swap(HostState::pinModes, device.pins.pinModes);
+    std::swap(HostState::pinFunctions, device.pins.pinFunctions);
+    std::swap(HostState::pwmSlices, device.pins.pwmSlices);
+    HostState::timeUs = _timeUs;
+}
+
+void FanBus::collect(size_t device) {
+    // read requests are not answered by the stand-in
+    for (const KnxTelegram& telegram : knx.sent) {
+        if (_devices[device]->attached && !telegram.readRequest && connected(telegram.asap))
+            _queue.push_back({device, telegram});
+    }
+    knx.sent.clear();
+}
+
+void FanBus::deliver() {
+    for (size_t next = 0; next < _queue.size(); next++) {
+        Telegram telegram = _queue[next]; // receivers may queue more
+        _telegrams.push_back(telegram);
+        for (size_t i = 0; i < _devices.size(); i++) {
+            Device& device = *_devices[i];
+            if (i == telegram.device || !device.attached)
+                continue;
+            enter(device);
+            GroupObject& ko = knx.getGroupObject(telegram.telegram.asap);
+            ko.receiveRaw(telegram.telegram.data, telegram.telegram.size);
+            device.module->processInputKo(ko);
+            collect(i);
+            leave(device);
+        }
+    }
+    _queue.clear();
+}
+
+void FanBus::run(uint32_t ms) {
+    uint64_t endUs = _timeUs + static_cast<uint64_t>(ms) * 1000;
+    for (;;) {
+        for (size_t i = 0; i < _devices.size(); i++) {
+            enter(*_devices[i]);
+            _devices[i]->module->loop();
+            collect(i);
+            leave(*_devices[i]);
+        }
+        deliver();
+        if (_timeUs >= endUs)
+            return;
+
+        uint32_t next = UINT32_MAX;
+        for (auto& device : _devices) {
+            enter(*device);
+            next = std::min(next, device->module->msUntilNextEvent());
+            leave(*device);
+        }
+        // a drifting clock may reach its deadline a little later, it is polled again after 1 ms
+        uint64_t stepUs = static_cast<uint64_t>(next ? next : 1) * 1000;
+        _timeUs += std::min(stepUs, endUs - _timeUs);
+    }
+}
+
+void FanBus::with(size_t device, const std::function<void(FanModule&)>& fn) {
+    enter(*_devices[device]);
+    fn(*_devices[device]->module);
+    collect(device);
+    leave(*_devices[device]);
+    deliver();
+}
+
+int16_t FanBus::pwm(size_t device, uint8_t pin) const {
+    return pin < HostState::PinCount ? _devices[device]->pins.pwm[pin] : 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+// Host-side KNX line between several fan modules in one process, e.g. for the
+// heat recovery phase sync. Every device has its own parameter memory, group
+// objects and pins, they are swapped into the global knx and HostState while
+// the device runs. Time is shared, optionally with a clock drift per device.
+// Group objects with a connected number share one group address: what a device
+// writes there is received by all other attached devices in the same step.
+#include "knx.h"
+#include "Arduino.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class FanModule;
+
+class FanBus {
+public:
+    struct Telegram {
+        size_t device; // sender
+        KnxTelegram telegram;
+    };
+
+    FanBus();
+    ~FanBus();
+
+    // configure writes the parameters with knx.setParamByte, then the module is set up
+    size_t addDevice(const std::function<void()>& configure);
+    void connect(uint16_t asap);
+    // a detached device keeps running but neither sends nor receives
+    void setAttached(size_t device, bool attached);
+    // the clock of the device runs faster (positive) or slower by ppm
+    void setClockDrift(size_t device, int32_t ppm);
+
+    // loop() of all devices until ms later, tickless from one deadline to the next
+    void run(uint32_t ms);
+    // runs fn with the state of the device in place, e.g. to receive a telegram or read a KO
+    void with(size_t device, const std::function<void(FanModule&)>& fn);
+
+    int16_t pwm(size_t device, uint8_t pin) const;
+    size_t deviceCount() const { return _devices.size(); }
+    uint32_t nowMs() const { return static_cast<uint32_t>(_timeUs / 1000); }
+    // telegrams on connected numbers in the order they went over the line
+    const std::vector<Telegram>& telegrams() const { return _telegrams; }
+
+private:
+    struct Pins {
+        int16_t pwm[HostState::PinCount] = {};
+        bool digital[HostState::PinCount] = {};
+        uint8_t pinModes[HostState::PinCount] = {};
+        uint8_t pinFunctions[HostState::PinCount] = {};
+        HostState::PwmSlice pwmSlices[HostState::SliceCount] = {};
+    };
+
+    struct Device {
+        std::unique_ptr<FanModule> module;
+        KnxFacade knx;
+        Pins pins;
+        bool attached = true;
+        int32_t driftPpm = 0;
+    };
+
+    void enter(Device& device);
+    void leave(Device& device);
+    // telegrams the device in place has written, queued for the other devices
+    void collect(size_t device);
+    void deliver();
+    bool connected(uint16_t asap) const;
+
+    std::vector<std::unique_ptr<Device>> _devices;
+    std::vector<uint16_t> _connected;
+    std::vector<Telegram> _queue;
+    std::vector<Telegram> _telegrams;
+    uint64_t _timeUs; // shared time, HostState::timeUs holds the clock of the device in place
+};
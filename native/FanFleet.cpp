@@ -0,0 +1,330 @@
+#include "FanFleet.h"
+#include "MaicoPPB30.h"
+#include <math.h>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// speed range of the simulated driver (MaicoPPB30)
+const float MaxSpeed = 5.0f;
+
+class FleetFanHardware : public IFanHardware {
+public:
+    void init(uint8_t s1_pin, uint8_t s2_pin, uint8_t sw_pin) override {}
+    void setPWM(uint8_t pin, int16_t value) override {}
+    void setDigital(uint8_t pin, bool value) override {}
+    void startDirectionTimer(uint32_t intervalMs, std::function<void()> callback) override {}
+    void stopDirectionTimer() override {}
+    void startOneShotTimer(uint64_t delayMs, std::function<void()> callback) override {}
+    void stopOneShotTimer() override {}
+    void startOverrideTimer(uint64_t delayMs, std::function<void()> callback) override {}
+    void stopOverrideTimer() override {}
+    uint32_t getMillis() override { return nowMs; }
+
+    uint32_t nowMs = 0;
+};
+
+uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+float unit(uint32_t x) {
+    return (mix(x) & 0xFFFF) / 65535.0f;
+}
+
+// saturation vapour density in g/m³, Magnus formula with the constants of Fan::getDewPoint
+float saturationDensity(float temperature) {
+    float pressure = 6.112f * expf(17.625f * temperature / (243.04f + temperature)); // hPa
+    return 216.68f * pressure / (temperature + 273.15f);
+}
+
+// One hour of the room with the speed of the previous hour, returns the relative
+// humidity. Shared by the vector loop and the scalar reference, same operation order.
+inline float roomStep(float& vapour, float speed, float volume, float moisture, float infiltration,
+                      float vapourOutside, float moistureProduced, float saturation) {
+    float exchange = infiltration + speed * FanFleet::FlowPerStep / volume;
+    exchange = exchange < 1.0f ? exchange : 1.0f; // hourly step, at most one full exchange
+    float next = vapour + moistureProduced * moisture / volume + exchange * (vapourOutside - vapour);
+    next = next < saturation ? next : saturation; // surplus condenses
+    vapour = next;
+    return next / saturation * 100.0f;
+}
+
+// The kernels take restrict pointers as parameters, so the compiler vectorises
+// them without alias checks for every array.
+void roomKernel(size_t begin, size_t end, float* __restrict vapour, float* __restrict humidity,
+                const float* __restrict speed, const float* __restrict volume, const float* __restrict moisture,
+                const float* __restrict infiltration, float vapourOutside, float moistureProduced, float saturation) {
+    for (size_t i = begin; i < end; i++)
+        humidity[i] = roomStep(vapour[i], speed[i], volume[i], moisture[i], infiltration[i], vapourOutside,
+                               moistureProduced, saturation);
+}
+
+// Fan::evaluateEnvironment, mode machine and MaicoPPB30 clamp of a fan in
+// automatic mode without trend, override or timer, as selects.
+void evaluateKernel(size_t begin, size_t end, const float* __restrict humidity, const float* __restrict dewPointInside,
+                    float dewPointOutside, const float* __restrict on, const float* __restrict off,
+                    const float* __restrict thresholdSpeed, const float* __restrict gain,
+                    const int32_t* __restrict adaptive, const int32_t* __restrict absolute,
+                    int32_t* __restrict active, float* __restrict request, float* __restrict speed) {
+    for (size_t i = begin; i < end; i++) {
+        float value = humidity[i];
+        // absolute mode without benefit holds the fan at 0, a NaN dew point as well
+        int32_t hold = absolute[i] & !(dewPointInside[i] > dewPointOutside);
+        int32_t high = hold | (value >= on[i]);
+        int32_t low = value < off[i];
+
+        float excess = value - on[i];
+        excess = excess < 0.0f ? 0.0f : excess;
+        float delta = absolute[i] ? dewPointInside[i] - dewPointOutside : excess;
+        // same order as EnvValue: (gain * delta) * max speed / steps
+        float adaptiveSpeed = floorf(gain[i] * delta * MaxSpeed / Fan::StepCount);
+        float automatic = hold ? 0.0f : (adaptive[i] ? adaptiveSpeed : thresholdSpeed[i]);
+
+        // high sets the request, low stops, the band keeps both
+        int32_t isActive = high ? 1 : (low ? 0 : active[i]);
+        float requested = high ? automatic : request[i];
+        float applied = isActive ? requested : 0.0f;
+        applied = applied < 0.0f ? 0.0f : applied;
+        applied = applied > MaxSpeed ? MaxSpeed : applied;
+
+        active[i] = isActive;
+        request[i] = requested;
+        speed[i] = applied;
+    }
+}
+
+void accountKernel(size_t begin, size_t end, float* __restrict humidity, const float* __restrict nextHumidity,
+                   const float* __restrict speed, float* __restrict lastSpeed, const float* __restrict limit,
+                   int32_t* __restrict runHours, int32_t* __restrict switches, int32_t* __restrict hoursAbove) {
+    for (size_t i = begin; i < end; i++) {
+        runHours[i] += speed[i] > 0.0f;
+        switches[i] += speed[i] != lastSpeed[i];
+        hoursAbove[i] += nextHumidity[i] >= limit[i];
+        lastSpeed[i] = speed[i];
+        humidity[i] = nextHumidity[i];
+    }
+}
+
+} // namespace
+
+FanFleet::FanFleet(const std::vector<Config>& configs, uint32_t buildings)
+    : _configs(configs), _buildings(buildings), _results(configs.size()) {
+    size_t count = configs.size() * buildings;
+    for (std::vector<float>* values : {&_on, &_off, &_thresholdSpeed, &_gain, &_limit, &_volume, &_moisture,
+                                       &_infiltration, &_vapour, &_humidity, &_nextHumidity, &_dewPointInside,
+                                       &_request, &_speed, &_lastSpeed})
+        values->resize(count);
+    for (std::vector<int32_t>* values : {&_adaptive, &_absoluteMode, &_active, &_runHours, &_switches, &_hoursAbove})
+        values->resize(count);
+
+    for (size_t c = 0; c < configs.size(); c++) {
+        const Config& config = configs[c];
+        size_t first = c * buildings;
+        if (config.sensorMode == Fan::HumiditySensorMode::Absolute)
+            _absolute.push_back({first, first + buildings});
+        for (uint32_t b = 0; b < buildings; b++) {
+            size_t i = first + b;
+            Building building = FanFleet::building(b);
+            _on[i] = config.thresholdOn;
+            _off[i] = config.thresholdOff;
+            _thresholdSpeed[i] = config.thresholdSpeed;
+            _gain[i] = config.controlGain;
+            _limit[i] = config.humidityLimit;
+            _adaptive[i] = config.controlMode == Fan::ControlMode::Adaptive;
+            _absoluteMode[i] = config.sensorMode == Fan::HumiditySensorMode::Absolute;
+            _volume[i] = building.volume;
+            _moisture[i] = building.moistureFactor;
+            _infiltration[i] = building.infiltration;
+        }
+    }
+}
+
+FanFleet::Building FanFleet::building(uint32_t index) {
+    // bathrooms and kitchens of a typical housing stock
+    Building building;
+    building.volume = 12.0f + 28.0f * unit(index * 3);
+    building.moistureFactor = 0.6f + 0.8f * unit(index * 3 + 1);
+    building.infiltration = 0.2f + 0.4f * unit(index * 3 + 2);
+    return building;
+}
+
+std::vector<FanFleet::Hour> FanFleet::syntheticYear(uint32_t hours) {
+    const float Pi = 3.14159265f;
+    std::vector<Hour> year(hours);
+    for (uint32_t h = 0; h < hours; h++) {
+        uint32_t day = h / 24;
+        uint32_t hour = h % 24;
+        float season = cosf(2 * Pi * ((float)day - 15) / 365.0f); // 1 mid January, -1 mid July
+        float daily = sinf(2 * Pi * ((float)hour - 9) / 24.0f);   // warmest in the afternoon
+        float weather = unit(0x5EA5 + day) - 0.5f;                // day to day variation
+
+        Hour& entry = year[h];
+        entry.outsideTemperature = 10 - 10 * season + 4 * daily + 6 * weather;
+        float humidity = 78 + 8 * season - 15 * daily + 20 * weather;
+        entry.outsideHumidity = humidity < 25 ? 25 : (humidity > 100 ? 100 : humidity);
+        entry.insideTemperature = 21.5f - 1.5f * season;
+        // occupants and plants, morning shower, cooking, laundry drying on Saturdays
+        entry.moisture = 40;
+        if (hour == 7)
+            entry.moisture += 500;
+        if (hour == 18)
+            entry.moisture += 250;
+        if (day % 7 == 5 && hour >= 10 && hour < 16)
+            entry.moisture += 150;
+    }
+    return year;
+}
+
+std::vector<FanFleet::HourTerms> FanFleet::hourTerms(const std::vector<Hour>& hours) {
+    std::vector<HourTerms> terms(hours.size());
+    float lastOutsideHumidity = 0; // a fresh Fan starts with 0 %RH
+    for (size_t h = 0; h < hours.size(); h++) {
+        const Hour& hour = hours[h];
+        HourTerms& entry = terms[h];
+        entry.vapourOutside = saturationDensity(hour.outsideTemperature) * hour.outsideHumidity / 100.0f;
+        entry.saturationInside = saturationDensity(hour.insideTemperature);
+        entry.moisture = hour.moisture;
+        entry.insideTemperature = hour.insideTemperature;
+        entry.dewPointStale = Fan::getDewPoint(lastOutsideHumidity, hour.outsideTemperature);
+        entry.dewPointOutside = Fan::getDewPoint(hour.outsideHumidity, hour.outsideTemperature);
+        lastOutsideHumidity = hour.outsideHumidity;
+    }
+    return terms;
+}
+
+void FanFleet::reset(const HourTerms& first) {
+    float dewPointZero = Fan::getDewPoint(0, 0); // NaN, inputs of a fresh Fan
+    for (size_t i = 0; i < fanCount(); i++) {
+        _vapour[i] = 0.5f * first.saturationInside;
+        _humidity[i] = 0;
+        _dewPointInside[i] = dewPointZero;
+        _active[i] = 0;
+        _request[i] = 0;
+        _runHours[i] = _switches[i] = _hoursAbove[i] = 0;
+    }
+    // switching to automatic mode evaluates once with all inputs at 0
+    evaluate({0, fanCount()}, _humidity.data(), dewPointZero);
+    _lastSpeed = _speed;
+}
+
+void FanFleet::evaluate(Range range, const float* humidity, float dewPointOutside) {
+    evaluateKernel(range.begin, range.end, humidity, _dewPointInside.data(), dewPointOutside, _on.data(), _off.data(),
+                   _thresholdSpeed.data(), _gain.data(), _adaptive.data(), _absoluteMode.data(), _active.data(),
+                   _request.data(), _speed.data());
+}
+
+void FanFleet::runBlock(Range block, const std::vector<HourTerms>& terms) {
+    for (const HourTerms& hour : terms) {
+        roomKernel(block.begin, block.end, _vapour.data(), _nextHumidity.data(), _lastSpeed.data(), _volume.data(),
+                   _moisture.data(), _infiltration.data(), hour.vapourOutside, hour.moisture, hour.saturationInside);
+
+        // The fan evaluates after every telegram: outside temperature, outside
+        // humidity, inside temperature, inside humidity. With relative humidity
+        // only the last one changes the decision, absolute mode needs all four.
+        for (const Range& absolute : _absolute) {
+            Range range = {absolute.begin > block.begin ? absolute.begin : block.begin,
+                           absolute.end < block.end ? absolute.end : block.end};
+            if (range.begin >= range.end)
+                continue;
+            evaluate(range, _humidity.data(), hour.dewPointStale);
+            evaluate(range, _humidity.data(), hour.dewPointOutside);
+            for (size_t i = range.begin; i < range.end; i++)
+                _dewPointInside[i] = Fan::getDewPoint(_humidity[i], hour.insideTemperature);
+            evaluate(range, _humidity.data(), hour.dewPointOutside);
+            for (size_t i = range.begin; i < range.end; i++)
+                _dewPointInside[i] = Fan::getDewPoint(_nextHumidity[i], hour.insideTemperature);
+        }
+        evaluate(block, _nextHumidity.data(), hour.dewPointOutside);
+
+        accountKernel(block.begin, block.end, _humidity.data(), _nextHumidity.data(), _speed.data(),
+                      _lastSpeed.data(), _limit.data(), _runHours.data(), _switches.data(), _hoursAbove.data());
+    }
+}
+
+void FanFleet::run(const std::vector<Hour>& hours, unsigned threads) {
+    if (hours.empty() || fanCount() == 0)
+        return;
+    std::vector<HourTerms> terms = hourTerms(hours);
+    reset(terms[0]);
+
+    // blocks are independent, threads take the next free one
+    size_t blocks = (fanCount() + BlockSize - 1) / BlockSize;
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t block = next++; block < blocks; block = next++) {
+            size_t end = (block + 1) * BlockSize;
+            runBlock({block * BlockSize, end < fanCount() ? end : fanCount()}, terms);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& thread : pool)
+        thread.join();
+
+    for (size_t c = 0; c < _configs.size(); c++) {
+        Result& result = _results[c];
+        result = Result();
+        for (size_t i = c * _buildings; i < (c + 1) * _buildings; i++) {
+            result.fans++;
+            result.runHours += _runHours[i];
+            result.switches += _switches[i];
+            result.hoursAbove += _hoursAbove[i];
+            if ((uint32_t)_hoursAbove[i] > result.maxHoursAbove)
+                result.maxHoursAbove = _hoursAbove[i];
+        }
+    }
+}
+
+FanFleet::Metrics FanFleet::metrics(size_t fan) const {
+    Metrics metrics;
+    metrics.runHours = _runHours[fan];
+    metrics.switches = _switches[fan];
+    metrics.hoursAbove = _hoursAbove[fan];
+    return metrics;
+}
+
+FanFleet::Metrics FanFleet::simulateScalar(const Config& config, const Building& building,
+                                           const std::vector<Hour>& hours) {
+    Metrics metrics;
+    if (hours.empty())
+        return metrics;
+    std::vector<HourTerms> terms = hourTerms(hours);
+
+    FleetFanHardware hw;
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    fan.thresholdHumidityOn = config.thresholdOn;
+    fan.thresholdHumidityOff = config.thresholdOff;
+    fan.thresholdSpeed = config.thresholdSpeed;
+    fan.controlGain = config.controlGain;
+    fan.humiditySensorMode = config.sensorMode;
+    fan.setControlMode(config.controlMode);
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+
+    float vapour = 0.5f * terms[0].saturationInside;
+    int16_t lastSpeed = fan.getFanSpeed();
+    for (size_t h = 0; h < hours.size(); h++) {
+        float humidity = roomStep(vapour, lastSpeed, building.volume, building.moistureFactor, building.infiltration,
+                                  terms[h].vapourOutside, terms[h].moisture, terms[h].saturationInside);
+        hw.nowMs = (uint32_t)(h * 3600000);
+        fan.setOutsideTemperature(hours[h].outsideTemperature);
+        fan.setOutsideHumidity(hours[h].outsideHumidity);
+        fan.setInsideTemperature(hours[h].insideTemperature);
+        fan.setInsideHumdity(humidity);
+
+        int16_t speed = fan.getFanSpeed();
+        metrics.runHours += speed > 0;
+        metrics.switches += speed != lastSpeed;
+        metrics.hoursAbove += humidity >= config.humidityLimit;
+        lastSpeed = speed;
+    }
+    return metrics;
+}
@@ -0,0 +1,111 @@
+#pragma once
+// Host-side simulation of many fans in automatic mode against hourly weather
+// and indoor moisture profiles, to compare parameter sets before roll-out.
+// Every fan controls a simple room model: the moisture production of the
+// profile raises the absolute humidity, infiltration and the fan exchange it
+// with outside air. The fan sees the resulting relative humidity once per hour.
+//
+// The state is kept as structure of arrays, the room model and the control
+// decision are branch-free loops the compiler vectorises. Dew points call the
+// scalar Fan::getDewPoint, so the decisions are bit-identical to a MaicoPPB30
+// fed the same telegrams (float build). simulateScalar() is that reference.
+#include "Fan.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class FanFleet {
+public:
+    static constexpr float FlowPerStep = 9.0f; // m³/h per speed step, PPB30 reaches ~45 m³/h
+
+    struct Hour {
+        float outsideTemperature; // °C
+        float outsideHumidity;    // %RH
+        float insideTemperature;  // °C
+        float moisture;           // g/h produced in the room, scaled per building
+    };
+
+    struct Config {
+        std::string name;
+        Fan::ControlMode controlMode = Fan::ControlMode::Threshold;
+        Fan::HumiditySensorMode sensorMode = Fan::HumiditySensorMode::Relative;
+        float thresholdOn = 60;
+        float thresholdOff = 55;
+        int16_t thresholdSpeed = 4;
+        float controlGain = 0.18f;
+        float humidityLimit = 70; // hours at or above count as time above the limit
+    };
+
+    struct Building {
+        float volume;         // m³
+        float moistureFactor; // scales the moisture of the profile
+        float infiltration;   // air changes per hour without fan
+    };
+
+    struct Metrics {
+        uint32_t runHours = 0;   // hours with speed > 0
+        uint32_t switches = 0;   // speed changes
+        uint32_t hoursAbove = 0; // hours at or above the humidity limit
+    };
+
+    struct Result {
+        uint32_t fans = 0;
+        uint64_t runHours = 0;
+        uint64_t switches = 0;
+        uint64_t hoursAbove = 0;
+        uint32_t maxHoursAbove = 0;
+    };
+
+    // every config runs against the same buildings, fan = config * buildings + building
+    FanFleet(const std::vector<Config>& configs, uint32_t buildings);
+
+    void run(const std::vector<Hour>& hours, unsigned threads);
+
+    size_t fanCount() const { return _on.size(); }
+    Metrics metrics(size_t fan) const;
+    const Result& result(size_t config) const { return _results[config]; }
+
+    static Building building(uint32_t index);
+    static std::vector<Hour> syntheticYear(uint32_t hours = 8760);
+    static Metrics simulateScalar(const Config& config, const Building& building, const std::vector<Hour>& hours);
+
+private:
+    static constexpr size_t BlockSize = 1024; // fans per work item, state of a block stays in L2
+
+    // per hour values shared by all fans
+    struct HourTerms {
+        float vapourOutside;    // g/m³
+        float saturationInside; // g/m³
+        float moisture;         // g/h
+        float insideTemperature;
+        float dewPointStale;    // outside temperature already new, outside humidity still old
+        float dewPointOutside;
+    };
+
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    static std::vector<HourTerms> hourTerms(const std::vector<Hour>& hours);
+    void reset(const HourTerms& first);
+    void runBlock(Range block, const std::vector<HourTerms>& terms);
+    void evaluate(Range range, const float* humidity, float dewPointOutside);
+
+    std::vector<Config> _configs;
+    uint32_t _buildings;
+    std::vector<Range> _absolute; // fan ranges of the configs in absolute mode
+    std::vector<Result> _results;
+
+    // parameters
+    std::vector<float> _on, _off, _thresholdSpeed, _gain, _limit;
+    std::vector<int32_t> _adaptive, _absoluteMode;
+    std::vector<float> _volume, _moisture, _infiltration;
+    // state, _humidity is the value the fan has seen last
+    std::vector<float> _vapour, _humidity, _nextHumidity, _dewPointInside;
+    std::vector<int32_t> _active;
+    std::vector<float> _request, _speed, _lastSpeed;
+    // metrics
+    std::vector<int32_t> _runHours, _switches, _hoursAbove;
+};
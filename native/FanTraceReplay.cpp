@@ -0,0 +1,118 @@
+#include "FanTraceReplay.h"
+#include "FanModule.h"
+#include "FanTrace.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+FanTraceReplay* FanTraceReplay::_active = nullptr;
+
+double FanTraceReplay::Stats::telegramsPerSecond() const {
+    return processNs ? telegrams * 1e9 / processNs : 0;
+}
+
+uint32_t FanTraceReplay::Stats::percentileNs(double percent) const {
+    if (latencyNs.empty())
+        return 0;
+    std::vector<uint32_t> sorted(latencyNs);
+    std::sort(sorted.begin(), sorted.end());
+    size_t index = static_cast<size_t>(percent / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+void FanTraceReplay::onPinWrite(uint8_t pin, int value, bool analog) {
+    char line[48];
+    snprintf(line, sizeof(line), "%lu %s %u %d\n", (unsigned long)millis(), analog ? "pwm" : "dig", pin, value);
+    _active->_output += line;
+}
+
+void FanTraceReplay::onSend(const KnxTelegram& telegram) {
+    char line[80];
+    int length = snprintf(line, sizeof(line), "%lu %s %u", (unsigned long)telegram.timeMs,
+                          telegram.readRequest ? "read" : "ko", telegram.asap);
+    for (size_t i = 0; i < telegram.size; i++)
+        length += snprintf(line + length, sizeof(line) - length, " %02X", telegram.data[i]);
+    _active->_output += line;
+    _active->_output += '\n';
+
+    for (uint8_t _channelIndex = 0; _channelIndex < FAN_ChannelCount; _channelIndex++) {
+        if (!telegram.readRequest && telegram.asap == FAN_KoCalcNumber(FAN_KoCH_LevelFeedback))
+            _active->_stats.speedChanges++;
+    }
+}
+
+bool FanTraceReplay::run(const uint8_t* data, size_t size, const Options& options) {
+    FanTraceReader reader(data, size);
+    if (!reader.valid() || reader.paramSize() > KnxFacade::ParamSize)
+        return false;
+
+    _output.clear();
+    _stats = Stats();
+    knx.reset();
+    HostState::reset();
+    openknx.setAfterStartupDelay(true);
+    for (uint16_t i = 0; i < reader.paramSize(); i++)
+        knx.setParamByte(i, reader.params()[i]);
+    for (const std::pair<uint16_t, uint8_t>& param : options.params)
+        knx.setParamByte(param.first, param.second);
+
+    _active = this;
+    HostState::pinWriteHook = &FanTraceReplay::onPinWrite;
+    knx.sendHook = &FanTraceReplay::onSend;
+
+    std::unique_ptr<FanModule> module(new FanModule());
+    module->setup(true);
+    module->processAfterStartupDelay();
+
+    uint32_t tickMs = options.tickMs ? options.tickMs : 1;
+    auto runUntil = [&](uint32_t timeMs) {
+        // the next telegram is the bus interrupt that ends the sleep
+        while (options.tickless && millis() < timeMs) {
+            uint64_t before = time_us_64();
+            module->idle(timeMs - millis());
+            if (time_us_64() == before)
+                HostState::advanceMillis(1); // work is due, one tick like the polled loop
+            module->loop();
+            _stats.loops++;
+        }
+        while (millis() + tickMs <= timeMs) {
+            HostState::advanceMillis(tickMs);
+            module->loop();
+            _stats.loops++;
+        }
+        if (millis() < timeMs) {
+            HostState::advanceMillis(timeMs - millis());
+            module->loop();
+            _stats.loops++;
+        }
+    };
+
+    FanTrace::Record record;
+    while (reader.next(record)) {
+        if (options.speed > 0 && record.timeMs > millis()) {
+            auto wait = std::chrono::duration<double, std::milli>((record.timeMs - millis()) / options.speed);
+            std::this_thread::sleep_for(wait);
+        }
+        runUntil(record.timeMs);
+
+        GroupObject& ko = knx.getGroupObject(record.asap);
+        ko.receiveRaw(record.data, record.size);
+        auto start = std::chrono::steady_clock::now();
+        module->processInputKo(ko);
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        _stats.telegrams++;
+        _stats.processNs += ns;
+        _stats.latencyNs.push_back(static_cast<uint32_t>(ns));
+    }
+    runUntil(millis() + options.tailMs);
+    _stats.sleptMs = HostState::sleptUs / 1000;
+
+    module.reset();
+    HostState::pinWriteHook = nullptr;
+    knx.sendHook = nullptr;
+    _active = nullptr;
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+// Host-side replay of a FanTrace through FanModule::processInputKo.
+// PWM, digital and KO writes are collected as text lines, one per write, so
+// the output of two firmware versions can be diffed directly.
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct KnxTelegram;
+
+class FanTraceReplay {
+public:
+    struct Options {
+        uint32_t tickMs = 10;  // module.loop() interval in virtual time, timer writes are stamped with it
+        uint32_t tailMs = 0;   // keep running after the last telegram, e.g. for run-on timers
+        double speed = 0;      // 0 = as fast as possible, otherwise real time scaled by speed
+        bool tickless = false; // sleep in FanModule::idle() between loops instead of ticking
+        std::vector<std::pair<uint16_t, uint8_t>> params; // address and value, written over the parameters of the trace
+    };
+
+    struct Stats {
+        uint32_t telegrams = 0;
+        uint64_t processNs = 0;             // time spent in processInputKo
+        std::vector<uint32_t> latencyNs;    // per telegram
+        uint32_t loops = 0;                 // module.loop() calls, the wake-ups in tickless mode
+        uint64_t sleptMs = 0;               // virtual time spent in FanModule::idle()
+        uint32_t speedChanges = 0;          // sent speed feedbacks of all channels, the switching events
+
+        double telegramsPerSecond() const;
+        uint32_t percentileNs(double percent) const;
+    };
+
+    // false if the trace is invalid or does not fit the parameter memory
+    bool run(const uint8_t* data, size_t size, const Options& options);
+
+    const std::string& output() const { return _output; }
+    const Stats& stats() const { return _stats; }
+
+private:
+    static void onPinWrite(uint8_t pin, int value, bool analog);
+    static void onSend(const KnxTelegram& telegram);
+    static FanTraceReplay* _active;
+
+    std::string _output;
+    Stats _stats;
+};
@@ -0,0 +1,19 @@
+#include "OpenKNX.h"
+#include <string.h>
+
+OpenKNX::Common openknx;
+
+bool delayCheck(uint32_t timerStart, uint32_t delayMs) {
+    return millis() - timerStart >= delayMs;
+}
+
+uint32_t delayTimerInit() {
+    uint32_t now = millis();
+    return now == 0 ? 1 : now; // 0 means "not started" in OpenKNX
+}
+
+void OpenKNX::Flash::writeFloat(float value) {
+    uint8_t bytes[sizeof(value)];
+    memcpy(bytes, &value, sizeof(value));
+    written.insert(written.end(), bytes, bytes + sizeof(value));
+}
@@ -0,0 +1,97 @@
+#pragma once
+// Host-side stand-in for the OpenKNX common framework. Only the module and
+// channel base classes and the helpers used by the fan module are provided.
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "knx.h"
+
+namespace OpenKNX {
+
+class Base {
+public:
+    virtual ~Base() = default;
+    virtual const std::string name() = 0;
+};
+
+class Channel : public Base {
+public:
+    virtual void setup() {}
+    virtual void setup(bool configured) {
+        if (configured)
+            setup();
+    }
+    virtual void loop() {}
+
+protected:
+    uint8_t _channelIndex = 0;
+};
+
+class Module : public Base {
+public:
+    virtual const std::string version() { return "0"; }
+    virtual void setup() {}
+    virtual void setup(bool configured) {
+        if (configured)
+            setup();
+    }
+    virtual void loop() {}
+    virtual void processAfterStartupDelay() {}
+    virtual void processInputKo(GroupObject& ko) {}
+    // console: true if the module handled the command
+    virtual bool processCommand(const std::string cmd, bool diagnoseKo) { return false; }
+    virtual void showHelp() {}
+
+    // module data in flash, readFlash gets the block written by writeFlash
+    virtual void writeFlash() {}
+    virtual void readFlash(const uint8_t* data, const uint16_t size) {}
+    virtual uint16_t flashSize() { return 0; }
+};
+
+// host side: writes are collected in memory, save() only counts the requests
+class Flash {
+public:
+    void writeByte(uint8_t value) { written.push_back(value); }
+    void writeFloat(float value);
+    void save(bool force = false) { saveRequests++; }
+
+    std::vector<uint8_t> written;
+    uint32_t saveRequests = 0;
+};
+
+// host side: console output is collected line by line
+class Logger {
+public:
+    void log(const std::string message) { lines.push_back(message); }
+
+    std::vector<std::string> lines;
+};
+
+class Console {
+public:
+    void printHelpLine(const char* command, const char* message) {}
+};
+
+class Common {
+public:
+    bool afterStartupDelay() const { return _afterStartupDelay; }
+
+    // host side: the startup delay is controlled by the test
+    void setAfterStartupDelay(bool value) { _afterStartupDelay = value; }
+
+    Flash flash;
+    Logger logger;
+    Console console;
+
+private:
+    bool _afterStartupDelay = true;
+};
+
+}
+
+extern OpenKNX::Common openknx;
+
+// true if the delay in ms has passed since the timer start
+bool delayCheck(uint32_t timerStart, uint32_t delayMs);
+uint32_t delayTimerInit();
@@ -0,0 +1,10 @@
+#pragma once
+// Host-side pin assignment, mirrors the layout of the fan device.
+
+#define FAN1_S1_PWM_PIN 2
+#define FAN1_S2_PWM_PIN 3
+#define FAN1_SW_PIN 4
+#define FAN2_S1_PWM_PIN 6
+#define FAN2_S2_PWM_PIN 7
+#define FAN2_SW_PIN 8
+#define STATUS_LED_PIN 25
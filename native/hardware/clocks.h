@@ -0,0 +1,10 @@
+#pragma once
+// Host-side stand-in for the pico SDK clock query, the system clock runs at
+// the RP2040 default of 125 MHz.
+#include <stdint.h>
+
+enum clock_index {
+    clk_sys = 5,
+};
+
+uint32_t clock_get_hz(enum clock_index clk_index);
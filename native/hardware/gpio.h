@@ -0,0 +1,10 @@
+#pragma once
+// Host-side stand-in for the pico SDK pin function select.
+#include <stdint.h>
+
+enum gpio_function {
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PWM = 4,
+};
+
+void gpio_set_function(uint32_t gpio, enum gpio_function fn);
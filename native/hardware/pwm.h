@@ -0,0 +1,10 @@
+#pragma once
+// Host-side stand-in for the pico SDK PWM functions used by the fan module.
+// Slice setup and levels are recorded in HostState, see Arduino.h.
+#include <stdint.h>
+
+uint32_t pwm_gpio_to_slice_num(uint32_t gpio);
+void pwm_set_wrap(uint32_t slice, uint16_t wrap);
+void pwm_set_clkdiv_int_frac(uint32_t slice, uint8_t integer, uint8_t fract);
+void pwm_set_enabled(uint32_t slice, bool enabled);
+void pwm_set_gpio_level(uint32_t gpio, uint16_t level);
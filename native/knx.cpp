@@ -0,0 +1,199 @@
+#include "knx.h"
+#include "Arduino.h"
+#include <math.h>
+#include <string.h>
+
+KnxFacade knx;
+
+namespace KnxDpt {
+
+size_t size(const Dpt& type) {
+    switch (type.mainGroup) {
+    case 1:
+    case 5:
+        return 1;
+    case 7:
+    case 9:
+        return 2;
+    case 10:
+        return 3;
+    case 12:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+static double clampPercent(double value) {
+    return value < 0 ? 0 : (value > 100 ? 100 : value);
+}
+
+static uint16_t encodeFloat16(double value) {
+    // DPT 9: MEEEEMMM MMMMMMMM, value = 0.01 * M * 2^E, M is 12 bit two's complement
+    double scaled = value * 100.0;
+    uint8_t exponent = 0;
+    long mantissa = lround(scaled);
+    while ((mantissa < -2048 || mantissa > 2047) && exponent < 15) {
+        exponent++;
+        mantissa = lround(scaled / (1 << exponent));
+    }
+    if (mantissa < -2048 || mantissa > 2047)
+        return 0x7FFF; // invalid data
+    return (mantissa < 0 ? 0x8000 : 0) | (exponent << 11) | (mantissa & 0x07FF);
+}
+
+static double decodeFloat16(uint16_t raw) {
+    int32_t mantissa = raw & 0x07FF;
+    if (raw & 0x8000)
+        mantissa -= 2048;
+    uint8_t exponent = (raw >> 11) & 0x0F;
+    return 0.01 * mantissa * (1 << exponent);
+}
+
+void encode(const KNXValue& value, const Dpt& type, uint8_t* data) {
+    switch (type.mainGroup) {
+    case 1:
+        data[0] = (bool)value ? 1 : 0;
+        break;
+    case 5:
+        if (type.subGroup == 1) // scaling, 0..100 % in 0..255
+            data[0] = static_cast<uint8_t>(lround(clampPercent((double)value) * 255.0 / 100.0));
+        else
+            data[0] = (uint8_t)value;
+        break;
+    case 7: {
+        uint16_t raw = (uint16_t)value;
+        data[0] = raw >> 8;
+        data[1] = raw & 0xFF;
+        break;
+    }
+    case 9: {
+        uint16_t raw = encodeFloat16((double)value);
+        data[0] = raw >> 8;
+        data[1] = raw & 0xFF;
+        break;
+    }
+    case 12: {
+        uint32_t raw = (uint32_t)value;
+        data[0] = raw >> 24;
+        data[1] = (raw >> 16) & 0xFF;
+        data[2] = (raw >> 8) & 0xFF;
+        data[3] = raw & 0xFF;
+        break;
+    }
+    default:
+        data[0] = (uint8_t)value;
+        break;
+    }
+}
+
+KNXValue decode(const uint8_t* data, const Dpt& type) {
+    switch (type.mainGroup) {
+    case 1:
+        return (bool)(data[0] & 0x01);
+    case 5:
+        if (type.subGroup == 1)
+            return static_cast<uint8_t>(lround(data[0] * 100.0 / 255.0));
+        return data[0];
+    case 7:
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    case 9:
+        return decodeFloat16((data[0] << 8) | data[1]);
+    case 12:
+        return static_cast<uint32_t>((uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 | data[3]);
+    default:
+        return data[0];
+    }
+}
+
+}
+
+void GroupObject::requestObjectRead() {
+    knx.capture(*this, true);
+}
+
+KNXValue GroupObject::value(const Dpt& type) const {
+    return KnxDpt::decode(_data, type);
+}
+
+void GroupObject::value(const KNXValue& value, const Dpt& type) {
+    valueNoSend(value, type);
+    knx.capture(*this, false);
+}
+
+void GroupObject::valueNoSend(const KNXValue& value, const Dpt& type) {
+    _size = KnxDpt::size(type);
+    KnxDpt::encode(value, type, _data);
+    _initialized = true;
+}
+
+void GroupObject::receive(const KNXValue& value, const Dpt& type) {
+    valueNoSend(value, type);
+}
+
+void GroupObject::receiveRaw(const uint8_t* data, size_t size) {
+    _size = size < MaxValueSize ? size : MaxValueSize;
+    memcpy(_data, data, _size);
+    _initialized = true;
+}
+
+KnxFacade::KnxFacade() {
+    reset();
+}
+
+uint8_t KnxFacade::paramByte(uint32_t addr) {
+    return addr < ParamSize ? _params[addr] : 0;
+}
+
+uint16_t KnxFacade::paramWord(uint32_t addr) {
+    return (paramByte(addr) << 8) | paramByte(addr + 1);
+}
+
+uint32_t KnxFacade::paramInt(uint32_t addr) {
+    return ((uint32_t)paramWord(addr) << 16) | paramWord(addr + 2);
+}
+
+uint8_t* KnxFacade::paramData(uint32_t addr) {
+    return _params + (addr < ParamSize ? addr : 0);
+}
+
+GroupObject& KnxFacade::getGroupObject(uint16_t asap) {
+    return _groupObjects[asap <= GroupObjectCount ? asap : 0];
+}
+
+void KnxFacade::setParamByte(uint32_t addr, uint8_t value) {
+    if (addr < ParamSize)
+        _params[addr] = value;
+}
+
+void KnxFacade::setParamWord(uint32_t addr, uint16_t value) {
+    setParamByte(addr, value >> 8);
+    setParamByte(addr + 1, value & 0xFF);
+}
+
+void KnxFacade::setParamInt(uint32_t addr, uint32_t value) {
+    setParamWord(addr, value >> 16);
+    setParamWord(addr + 2, value & 0xFFFF);
+}
+
+void KnxFacade::reset() {
+    memset(_params, 0, sizeof(_params));
+    for (uint16_t i = 0; i <= GroupObjectCount; i++) {
+        _groupObjects[i] = GroupObject();
+        _groupObjects[i]._asap = i;
+    }
+    sent.clear();
+    sendHook = nullptr;
+}
+
+void KnxFacade::capture(const GroupObject& ko, bool readRequest) {
+    KnxTelegram telegram = {};
+    telegram.asap = ko.asap();
+    telegram.readRequest = readRequest;
+    telegram.size = readRequest ? 0 : ko.valueSize();
+    memcpy(telegram.data, ko._data, telegram.size);
+    telegram.timeMs = millis();
+    sent.push_back(telegram);
+    if (sendHook)
+        sendHook(telegram);
+}
@@ -0,0 +1,146 @@
+#pragma once
+// Host-side stand-in for the parts of the knx stack used by the fan module:
+// datapoint types, KNXValue, GroupObject and the parameter memory of the
+// KnxFacade. Telegrams written by the module are captured instead of sent.
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class Dpt {
+public:
+    Dpt() = default;
+    Dpt(uint16_t mainGroup, uint16_t subGroup) : mainGroup(mainGroup), subGroup(subGroup) {}
+
+    bool operator==(const Dpt& other) const { return mainGroup == other.mainGroup && subGroup == other.subGroup; }
+    bool operator!=(const Dpt& other) const { return !(*this == other); }
+
+    uint16_t mainGroup = 0;
+    uint16_t subGroup = 0;
+};
+
+#define DPT_Switch Dpt(1, 1)
+#define DPT_Enable Dpt(1, 3)
+#define DPT_Step Dpt(1, 7)
+#define DPT_Start Dpt(1, 10)
+#define DPT_State Dpt(1, 11)
+#define DPT_Scaling Dpt(5, 1)
+#define DPT_Value_1_Ucount Dpt(5, 10)
+#define DPT_TimePeriodSec Dpt(7, 5)
+#define DPT_Value_Temp Dpt(9, 1)
+#define DPT_Value_Humidity Dpt(9, 7)
+#define DPT_TimeOfDay Dpt(10, 1)
+#define DPT_Value_4_Ucount Dpt(12, 1)
+
+/**
+ * @brief Decoded value of a group object.
+ * Stores integers and floating point numbers separately, so integer DPTs
+ * keep their exact value when converted back.
+ */
+class KNXValue {
+public:
+    KNXValue(bool value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(uint8_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(int8_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(uint16_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(int16_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(uint32_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(int32_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(int64_t value) : _int(value), _float(value), _isFloat(false) {}
+    KNXValue(float value) : _int(static_cast<int64_t>(value)), _float(value), _isFloat(true) {}
+    KNXValue(double value) : _int(static_cast<int64_t>(value)), _float(value), _isFloat(true) {}
+
+    operator bool() const { return _isFloat ? _float != 0 : _int != 0; }
+    operator uint8_t() const { return static_cast<uint8_t>(_int); }
+    operator int8_t() const { return static_cast<int8_t>(_int); }
+    operator uint16_t() const { return static_cast<uint16_t>(_int); }
+    operator int16_t() const { return static_cast<int16_t>(_int); }
+    operator uint32_t() const { return static_cast<uint32_t>(_int); }
+    operator int32_t() const { return static_cast<int32_t>(_int); }
+    operator int64_t() const { return _int; }
+    operator float() const { return static_cast<float>(_float); }
+    operator double() const { return _float; }
+
+private:
+    int64_t _int;
+    double _float;
+    bool _isFloat;
+};
+
+class GroupObject {
+public:
+    static constexpr uint8_t MaxValueSize = 14;
+
+    uint16_t asap() const { return _asap; }
+    bool initialized() const { return _initialized; }
+    void requestObjectRead();
+
+    KNXValue value(const Dpt& type) const;
+    void value(const KNXValue& value, const Dpt& type);
+    void valueNoSend(const KNXValue& value, const Dpt& type);
+    uint8_t* valueRef() { return _data; }
+    size_t valueSize() const { return _size; }
+
+    // host side: store a received telegram without calling the module
+    void receive(const KNXValue& value, const Dpt& type);
+    void receiveRaw(const uint8_t* data, size_t size);
+
+private:
+    friend class KnxFacade;
+
+    uint16_t _asap = 0;
+    bool _initialized = false;
+    uint8_t _data[MaxValueSize] = {};
+    size_t _size = 1;
+};
+
+/**
+ * @brief Telegram written by the module, captured by the stand-in.
+ * A read request has no payload.
+ */
+struct KnxTelegram {
+    uint16_t asap;
+    bool readRequest;
+    uint8_t data[GroupObject::MaxValueSize];
+    size_t size;
+    uint32_t timeMs;
+};
+
+class KnxFacade {
+public:
+    static constexpr uint16_t ParamSize = 512;
+    static constexpr uint16_t GroupObjectCount = 256;
+
+    KnxFacade();
+
+    uint8_t paramByte(uint32_t addr);
+    uint16_t paramWord(uint32_t addr);
+    uint32_t paramInt(uint32_t addr);
+    uint8_t* paramData(uint32_t addr);
+    GroupObject& getGroupObject(uint16_t asap);
+
+    // host side: fill the parameter memory as the ETS would (big endian)
+    void setParamByte(uint32_t addr, uint8_t value);
+    void setParamWord(uint32_t addr, uint16_t value);
+    void setParamInt(uint32_t addr, uint32_t value);
+    void reset();
+
+    std::vector<KnxTelegram> sent;
+    // called for every captured telegram, e.g. to stream a replay
+    void (*sendHook)(const KnxTelegram& telegram) = nullptr;
+
+private:
+    friend class GroupObject;
+    void capture(const GroupObject& ko, bool readRequest);
+
+    uint8_t _params[ParamSize];
+    GroupObject _groupObjects[GroupObjectCount + 1]; // 1 based like the stack
+};
+
+extern KnxFacade knx;
+
+namespace KnxDpt {
+    // encode/decode a value in the wire format of the given DPT
+    size_t size(const Dpt& type);
+    void encode(const KNXValue& value, const Dpt& type, uint8_t* data);
+    KNXValue decode(const uint8_t* data, const Dpt& type);
+}
@@ -0,0 +1,283 @@
+#pragma once
+// Host-side copy of the OpenKNXproducer output for the fan module. Mirrors the
+// memory layout of Fan.share.xml and Fan.templ.xml, keep both in sync when
+// parameters or communication objects are added.
+#include "knx.h"
+
+#define FAN_ModuleVersion 2
+#define FAN_ChannelCount 2
+
+// Module parameters (Fan.share.xml)
+#define FAN_StatusLED 0x0000
+#define FAN_StatusLEDMask 0xE0
+#define FAN_StatusLEDShift 5
+
+#define FAN_SyncRole 0x0000
+#define FAN_SyncRoleMask 0x18
+#define FAN_SyncRoleShift 3
+#define FAN_SyncId 0x0001
+#define FAN_SyncPeriod 0x0002
+
+#define ParamFAN_StatusLED ((knx.paramByte(FAN_StatusLED) & FAN_StatusLEDMask) >> FAN_StatusLEDShift)
+#define ParamFAN_SyncRole ((knx.paramByte(FAN_SyncRole) & FAN_SyncRoleMask) >> FAN_SyncRoleShift)
+#define ParamFAN_SyncId (knx.paramByte(FAN_SyncId))
+#define ParamFAN_SyncPeriod (knx.paramByte(FAN_SyncPeriod))
+
+// Module communication objects
+#define FAN_KoOffset 1
+#define FAN_KoTime 0
+#define FAN_KoHeatRecoverySync 1
+
+#define KoFAN_Time (knx.getGroupObject(FAN_KoTime + FAN_KoOffset))
+#define KoFAN_HeatRecoverySync (knx.getGroupObject(FAN_KoHeatRecoverySync + FAN_KoOffset))
+
+// Channel parameters (Fan.templ.xml)
+#define FAN_ParamBlockOffset 3
+#define FAN_ParamBlockSize 96
+#define FAN_ParamCalcIndex(index) (index + FAN_ParamBlockOffset + _channelIndex * FAN_ParamBlockSize)
+
+#define FAN_CH_OpMode 0x0001
+#define FAN_CH_OpModeMask 0xE0
+#define FAN_CH_OpModeShift 5
+#define FAN_CH_ThresholdHumidityOn 0x0002
+#define FAN_CH_ControlMode 0x0003
+#define FAN_CH_ControlModeMask 0xC0
+#define FAN_CH_ControlModeShift 6
+#define FAN_CH_VentMode 0x0004
+#define FAN_CH_VentModeMask 0xC0
+#define FAN_CH_VentModeShift 6
+#define FAN_CH_HumSensMode 0x0005
+#define FAN_CH_HumSensModeMask 0xC0
+#define FAN_CH_HumSensModeShift 6
+#define FAN_CH_TimerSelection 0x0006
+#define FAN_CH_TimerValue 0x0008
+#define FAN_CH_ThresholdSpeed 0x000C
+#define FAN_CH_ThresholdHumidityOff 0x000D
+#define FAN_CH_VentModeAutomatic 0x000E
+#define FAN_CH_VentModeAutomaticMask 0xC0
+#define FAN_CH_VentModeAutomaticShift 6
+#define FAN_CH_SchedActive 0x000F
+#define FAN_CH_Sched1Day 0x0010
+#define FAN_CH_Sched1Hour 0x0011
+#define FAN_CH_Sched1Minute 0x0012
+#define FAN_CH_Sched1Speed 0x0013
+#define FAN_CH_Sched2Day 0x0014
+#define FAN_CH_Sched2Hour 0x0015
+#define FAN_CH_Sched2Minute 0x0016
+#define FAN_CH_Sched2Speed 0x0017
+#define FAN_CH_Sched3Day 0x0018
+#define FAN_CH_Sched3Hour 0x0019
+#define FAN_CH_Sched3Minute 0x001A
+#define FAN_CH_Sched3Speed 0x001B
+#define FAN_CH_Sched4Day 0x001C
+#define FAN_CH_Sched4Hour 0x001D
+#define FAN_CH_Sched4Minute 0x001E
+#define FAN_CH_Sched4Speed 0x001F
+#define FAN_CH_Sched5Day 0x0020
+#define FAN_CH_Sched5Hour 0x0021
+#define FAN_CH_Sched5Minute 0x0022
+#define FAN_CH_Sched5Speed 0x0023
+#define FAN_CH_Sched6Day 0x0024
+#define FAN_CH_Sched6Hour 0x0025
+#define FAN_CH_Sched6Minute 0x0026
+#define FAN_CH_Sched6Speed 0x0027
+#define FAN_CH_Sched7Day 0x0028
+#define FAN_CH_Sched7Hour 0x0029
+#define FAN_CH_Sched7Minute 0x002A
+#define FAN_CH_Sched7Speed 0x002B
+#define FAN_CH_Sched8Day 0x002C
+#define FAN_CH_Sched8Hour 0x002D
+#define FAN_CH_Sched8Minute 0x002E
+#define FAN_CH_Sched8Speed 0x002F
+#define FAN_CH_TrendRate 0x0030
+#define FAN_CH_TrendMargin 0x0031
+#define FAN_CH_TrendSpeed 0x0032
+#define FAN_CH_OverrideTime 0x0033
+#define FAN_CH_PredictDeadline 0x0035
+#define FAN_CH_PredictTimeConstant 0x0036
+#define FAN_CH_StatusCompound 0x0037
+#define FAN_CH_SensorCount 0x0038
+#define FAN_CH_SensorAggregation 0x0039
+#define FAN_CH_SensorWeight1 0x003A
+#define FAN_CH_SensorWeight2 0x003B
+#define FAN_CH_SensorWeight3 0x003C
+#define FAN_CH_SensorStaleTime 0x003D
+#define FAN_CH_HeatRecoveryAdaptive 0x003E
+#define FAN_CH_HeatRecoveryMinPeriod 0x003F
+#define FAN_CH_HeatRecoveryMaxPeriod 0x0040
+#define FAN_CH_HeatRecoveryFrostPeriod 0x0041
+#define FAN_CH_AutoMinOnTime 0x0042
+#define FAN_CH_AutoMinOffTime 0x0043
+#define FAN_CH_AutoMinStepTime 0x0044
+#define FAN_CH_DewPointHysteresis 0x0045
+#define FAN_CH_SyncEnable 0x0046
+#define FAN_CH_SyncOffset 0x0047
+#define FAN_CH_ShadowEnable 0x0048
+#define FAN_CH_ShadowControlMode 0x0049
+#define FAN_CH_ShadowControlModeMask 0xC0
+#define FAN_CH_ShadowControlModeShift 6
+#define FAN_CH_ShadowHumSensMode 0x004A
+#define FAN_CH_ShadowHumSensModeMask 0xC0
+#define FAN_CH_ShadowHumSensModeShift 6
+#define FAN_CH_ShadowThresholdOn 0x004B
+#define FAN_CH_ShadowThresholdOff 0x004C
+#define FAN_CH_ShadowThresholdSpeed 0x004D
+#define FAN_CH_HistoryEnable 0x004E
+#define FAN_CH_HistoryCheckpoint 0x004F
+#define FAN_CH_TimerSpeed 0x0050
+#define FAN_CH_TimerRetrigger 0x0051
+#define FAN_CH_TimerRemainingInterval 0x0052
+#define FAN_CH_CurveLinear 0x0053
+#define FAN_CH_Curve1Value 0x0054
+#define FAN_CH_Curve1Hysteresis 0x0055
+#define FAN_CH_Curve1Step 0x0056
+
+#define ParamFAN_CH_OpMode ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_OpMode)) & FAN_CH_OpModeMask) >> FAN_CH_OpModeShift)
+#define ParamFAN_CH_ThresholdHumidityOn ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn)))
+#define ParamFAN_CH_ControlMode ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ControlMode)) & FAN_CH_ControlModeMask) >> FAN_CH_ControlModeShift)
+#define ParamFAN_CH_VentMode ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_VentMode)) & FAN_CH_VentModeMask) >> FAN_CH_VentModeShift)
+#define ParamFAN_CH_HumSensMode ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HumSensMode)) & FAN_CH_HumSensModeMask) >> FAN_CH_HumSensModeShift)
+#define ParamFAN_CH_TimerSelection (knx.paramWord(FAN_ParamCalcIndex(FAN_CH_TimerSelection)))
+#define ParamFAN_CH_TimerValue ((int32_t)knx.paramInt(FAN_ParamCalcIndex(FAN_CH_TimerValue)))
+#define ParamFAN_CH_ThresholdSpeed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed)))
+#define ParamFAN_CH_ThresholdHumidityOff ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff)))
+#define ParamFAN_CH_VentModeAutomatic ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_VentModeAutomatic)) & FAN_CH_VentModeAutomaticMask) >> FAN_CH_VentModeAutomaticShift)
+#define ParamFAN_CH_SchedActive (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SchedActive)))
+#define ParamFAN_CH_Sched1Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched1Day)))
+#define ParamFAN_CH_Sched1Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched1Hour)))
+#define ParamFAN_CH_Sched1Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched1Minute)))
+#define ParamFAN_CH_Sched1Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched1Speed)))
+#define ParamFAN_CH_Sched2Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched2Day)))
+#define ParamFAN_CH_Sched2Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched2Hour)))
+#define ParamFAN_CH_Sched2Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched2Minute)))
+#define ParamFAN_CH_Sched2Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched2Speed)))
+#define ParamFAN_CH_Sched3Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched3Day)))
+#define ParamFAN_CH_Sched3Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched3Hour)))
+#define ParamFAN_CH_Sched3Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched3Minute)))
+#define ParamFAN_CH_Sched3Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched3Speed)))
+#define ParamFAN_CH_Sched4Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched4Day)))
+#define ParamFAN_CH_Sched4Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched4Hour)))
+#define ParamFAN_CH_Sched4Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched4Minute)))
+#define ParamFAN_CH_Sched4Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched4Speed)))
+#define ParamFAN_CH_Sched5Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched5Day)))
+#define ParamFAN_CH_Sched5Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched5Hour)))
+#define ParamFAN_CH_Sched5Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched5Minute)))
+#define ParamFAN_CH_Sched5Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched5Speed)))
+#define ParamFAN_CH_Sched6Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched6Day)))
+#define ParamFAN_CH_Sched6Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched6Hour)))
+#define ParamFAN_CH_Sched6Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched6Minute)))
+#define ParamFAN_CH_Sched6Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched6Speed)))
+#define ParamFAN_CH_Sched7Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched7Day)))
+#define ParamFAN_CH_Sched7Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched7Hour)))
+#define ParamFAN_CH_Sched7Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched7Minute)))
+#define ParamFAN_CH_Sched7Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched7Speed)))
+#define ParamFAN_CH_Sched8Day (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched8Day)))
+#define ParamFAN_CH_Sched8Hour (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched8Hour)))
+#define ParamFAN_CH_Sched8Minute (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched8Minute)))
+#define ParamFAN_CH_Sched8Speed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Sched8Speed)))
+#define ParamFAN_CH_TrendRate (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_TrendRate)))
+#define ParamFAN_CH_TrendMargin (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_TrendMargin)))
+#define ParamFAN_CH_TrendSpeed (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_TrendSpeed)))
+#define ParamFAN_CH_OverrideTime (knx.paramWord(FAN_ParamCalcIndex(FAN_CH_OverrideTime)))
+#define ParamFAN_CH_PredictDeadline (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_PredictDeadline)))
+#define ParamFAN_CH_PredictTimeConstant (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_PredictTimeConstant)))
+#define ParamFAN_CH_StatusCompound (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_StatusCompound)))
+#define ParamFAN_CH_SensorCount (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SensorCount)))
+#define ParamFAN_CH_SensorAggregation (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SensorAggregation)))
+#define ParamFAN_CH_SensorWeight1 (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SensorWeight1)))
+#define ParamFAN_CH_SensorWeight2 (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SensorWeight2)))
+#define ParamFAN_CH_SensorWeight3 (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SensorWeight3)))
+#define ParamFAN_CH_SensorStaleTime (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SensorStaleTime)))
+#define ParamFAN_CH_HeatRecoveryAdaptive (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HeatRecoveryAdaptive)))
+#define ParamFAN_CH_HeatRecoveryMinPeriod (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HeatRecoveryMinPeriod)))
+#define ParamFAN_CH_HeatRecoveryMaxPeriod (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HeatRecoveryMaxPeriod)))
+#define ParamFAN_CH_HeatRecoveryFrostPeriod (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HeatRecoveryFrostPeriod)))
+#define ParamFAN_CH_AutoMinOnTime (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_AutoMinOnTime)))
+#define ParamFAN_CH_AutoMinOffTime (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_AutoMinOffTime)))
+#define ParamFAN_CH_AutoMinStepTime (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_AutoMinStepTime)))
+#define ParamFAN_CH_DewPointHysteresis (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_DewPointHysteresis)))
+#define ParamFAN_CH_SyncEnable (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SyncEnable)))
+#define ParamFAN_CH_SyncOffset (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_SyncOffset)))
+#define ParamFAN_CH_ShadowEnable (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ShadowEnable)))
+#define ParamFAN_CH_ShadowControlMode ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ShadowControlMode)) & FAN_CH_ShadowControlModeMask) >> FAN_CH_ShadowControlModeShift)
+#define ParamFAN_CH_ShadowHumSensMode ((knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ShadowHumSensMode)) & FAN_CH_ShadowHumSensModeMask) >> FAN_CH_ShadowHumSensModeShift)
+#define ParamFAN_CH_ShadowThresholdOn ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdOn)))
+#define ParamFAN_CH_ShadowThresholdOff ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdOff)))
+#define ParamFAN_CH_ShadowThresholdSpeed ((int8_t)knx.paramByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdSpeed)))
+#define ParamFAN_CH_HistoryEnable (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HistoryEnable)))
+#define ParamFAN_CH_HistoryCheckpoint (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_HistoryCheckpoint)))
+#define ParamFAN_CH_TimerSpeed (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_TimerSpeed)))
+#define ParamFAN_CH_TimerRetrigger (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_TimerRetrigger)))
+#define ParamFAN_CH_TimerRemainingInterval (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_TimerRemainingInterval)))
+#define ParamFAN_CH_CurveLinear (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_CurveLinear)))
+#define ParamFAN_CH_Curve1Value (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Curve1Value)))
+#define ParamFAN_CH_Curve1Hysteresis (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Curve1Hysteresis)))
+#define ParamFAN_CH_Curve1Step (knx.paramByte(FAN_ParamCalcIndex(FAN_CH_Curve1Step)))
+
+// Channel communication objects
+#define FAN_KoBlockOffset 3
+#define FAN_KoBlockSize 30
+#define FAN_KoCalcNumber(index) (index + FAN_KoBlockOffset + _channelIndex * FAN_KoBlockSize)
+#define FAN_KoCalcIndex(number) ((number >= FAN_KoCalcNumber(0) && number < FAN_KoCalcNumber(FAN_KoBlockSize)) ? number - FAN_KoBlockOffset - _channelIndex * FAN_KoBlockSize : -1)
+
+#define FAN_KoCH_HumidityInside 0
+#define FAN_KoCH_TemperatureInside 1
+#define FAN_KoCH_HumidityOutside 2
+#define FAN_KoCH_TemperatureOutside 3
+#define FAN_KoCH_Level 4
+#define FAN_KoCH_LevelUpDown 5
+#define FAN_KoCH_LevelFeedback 6
+#define FAN_KoCH_OpMode 7
+#define FAN_KoCH_OpModeFeedback 8
+#define FAN_KoCH_VentMode 9
+#define FAN_KoCH_VentModeFeedback 10
+#define FAN_KoCH_TimerActivation 11
+#define FAN_KoCH_TimerFeedback 12
+#define FAN_KoCH_VentModeAutomatic 13
+#define FAN_KoCH_VentModeFeedbackAutomatic 14
+#define FAN_KoCH_ActiveSource 15
+#define FAN_KoCH_LevelPercent 16
+#define FAN_KoCH_LevelPercentFeedback 17
+#define FAN_KoCH_AutoTune 18
+#define FAN_KoCH_AutoTuneStatus 19
+#define FAN_KoCH_Status 20
+#define FAN_KoCH_HumidityInside2 21
+#define FAN_KoCH_TemperatureInside2 22
+#define FAN_KoCH_HumidityInside3 23
+#define FAN_KoCH_TemperatureInside3 24
+#define FAN_KoCH_ShadowLevel 25
+#define FAN_KoCH_ShadowDivergenceTime 26
+#define FAN_KoCH_ShadowDivergenceSteps 27
+#define FAN_KoCH_TimerRemaining 28
+#define FAN_KoCH_TimerPause 29
+
+#define KoFAN_CH_HumidityInside (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_HumidityInside)))
+#define KoFAN_CH_TemperatureInside (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TemperatureInside)))
+#define KoFAN_CH_HumidityOutside (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_HumidityOutside)))
+#define KoFAN_CH_TemperatureOutside (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TemperatureOutside)))
+#define KoFAN_CH_Level (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_Level)))
+#define KoFAN_CH_LevelUpDown (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_LevelUpDown)))
+#define KoFAN_CH_LevelFeedback (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_LevelFeedback)))
+#define KoFAN_CH_OpMode (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_OpMode)))
+#define KoFAN_CH_OpModeFeedback (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_OpModeFeedback)))
+#define KoFAN_CH_VentMode (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_VentMode)))
+#define KoFAN_CH_VentModeFeedback (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_VentModeFeedback)))
+#define KoFAN_CH_TimerActivation (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TimerActivation)))
+#define KoFAN_CH_TimerFeedback (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TimerFeedback)))
+#define KoFAN_CH_VentModeAutomatic (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_VentModeAutomatic)))
+#define KoFAN_CH_VentModeFeedbackAutomatic (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_VentModeFeedbackAutomatic)))
+#define KoFAN_CH_ActiveSource (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_ActiveSource)))
+#define KoFAN_CH_LevelPercent (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_LevelPercent)))
+#define KoFAN_CH_LevelPercentFeedback (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_LevelPercentFeedback)))
+#define KoFAN_CH_AutoTune (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_AutoTune)))
+#define KoFAN_CH_AutoTuneStatus (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_AutoTuneStatus)))
+#define KoFAN_CH_Status (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_Status)))
+#define KoFAN_CH_HumidityInside2 (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_HumidityInside2)))
+#define KoFAN_CH_TemperatureInside2 (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TemperatureInside2)))
+#define KoFAN_CH_HumidityInside3 (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_HumidityInside3)))
+#define KoFAN_CH_TemperatureInside3 (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TemperatureInside3)))
+#define KoFAN_CH_ShadowLevel (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_ShadowLevel)))
+#define KoFAN_CH_ShadowDivergenceTime (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_ShadowDivergenceTime)))
+#define KoFAN_CH_ShadowDivergenceSteps (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_ShadowDivergenceSteps)))
+#define KoFAN_CH_TimerRemaining (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TimerRemaining)))
+#define KoFAN_CH_TimerPause (knx.getGroupObject(FAN_KoCalcNumber(FAN_KoCH_TimerPause)))
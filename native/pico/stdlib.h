@@ -0,0 +1,11 @@
+#pragma once
+// Host-side stand-in for the pico SDK time base.
+#include <stdint.h>
+
+uint64_t time_us_64();
+
+// Sleep of the core: the virtual time jumps to the timeout, there are no
+// interrupts on the host. HostState counts the sleeps for the idle statistics.
+typedef uint64_t absolute_time_t;
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+bool best_effort_wfe_or_timeout(absolute_time_t timeout);
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Decodes DPT 9 telegrams (2 byte float) of one group object into
+ * 1/100 units without the generic KNX value conversion.
+ * The wire format is MEEEEMMM MMMMMMMM with value = 0.01 * M * 2^E and M a
+ * 12 bit two's complement, so M << E is the exact value in 1/100 units. The
+ * raw bytes of the last telegram are kept: a sensor repeating its value costs
+ * one compare. 0x7FFF is "invalid data" and has no value.
+ */
+class Dpt9Decoder {
+public:
+  static constexpr uint16_t Invalid = 0x7FFF;
+
+  // value of the raw encoding in 1/100 units, false for Invalid
+  static bool toHundredths(uint16_t raw, int32_t& hundredths) {
+    if (raw == Invalid)
+      return false;
+    int32_t mantissa = raw & 0x07FF;
+    if (raw & 0x8000)
+      mantissa -= 2048;
+    // multiply instead of shifting, a left shift of a negative mantissa is undefined before C++20
+    hundredths = mantissa * (int32_t(1) << ((raw >> 11) & 0x0F));
+    return true;
+  }
+
+  // data is the group object buffer, false for an invalid telegram
+  bool decode(const uint8_t* data, int32_t& hundredths) {
+    uint16_t raw = (data[0] << 8) | data[1];
+    if (raw != _raw) {
+      _raw = raw;
+      _valid = toHundredths(raw, _hundredths);
+    }
+    hundredths = _hundredths;
+    return _valid;
+  }
+
+private:
+  uint16_t _raw = Invalid; // nothing received yet decodes like an invalid telegram
+  bool _valid = false;
+  int32_t _hundredths = 0;
+};
@@ -0,0 +1,36 @@
+#include "EcFan.h"
+
+EcFan::EcFan(IFanHardware& hw, uint8_t PWM_PIN, uint8_t ENABLE_PIN, uint8_t minimumDuty)
+    : Fan(hw), minimumDuty(minimumDuty > 100 ? 100 : minimumDuty), _PWM_PIN(PWM_PIN), _ENABLE_PIN(ENABLE_PIN) {
+  _hw.init(_PWM_PIN, IFanHardware::NoPin, _ENABLE_PIN);
+  _pwmRange = _hw.getPWMRange();
+  setPWM();
+}
+
+void EcFan::changeFanSpeedDelegate(int16_t fanSpeed) {
+  if (fanSpeed < 0) fanSpeed = 0;
+  if (fanSpeed > MaxSpeed) fanSpeed = MaxSpeed;
+
+  _speed = fanSpeed;
+  updateMode();
+}
+
+int16_t EcFan::getFanSpeed() {
+  return _speed;
+}
+
+void EcFan::updateMode() {
+  if (_operatingMode == OperatingMode::Off)
+    _speed = 0;
+
+  // supply only while running, EC electronics draw standby power otherwise
+  _hw.setDigital(_ENABLE_PIN, _speed > 0);
+  setPWM();
+}
+
+void EcFan::setPWM() {
+  int32_t duty = 0;
+  if (_speed > 0)
+    duty = minimumDuty + (int32_t)_speed * (100 - minimumDuty) / MaxSpeed;
+  _hw.setPWM(_PWM_PIN, duty * _pwmRange / 100);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "Fan.h"
+#include "IFanHardware.h"
+
+/**
+ * @brief Driver for EC fans with 0-10 V or PWM speed input.
+ * The speed is continuous in percent, the PWM output is filtered to the
+ * control voltage or fed to the PWM input of the fan directly. The enable
+ * output switches the supply relay while the fan runs. Single-direction
+ * fans, the ventilation mode has no effect.
+ */
+class EcFan : public Fan {
+public:
+  static constexpr int16_t MaxSpeed = 100; // percent
+
+  EcFan(IFanHardware& hw, uint8_t PWM_PIN, uint8_t ENABLE_PIN, uint8_t minimumDuty = 0);
+
+  void changeFanSpeedDelegate(int16_t fanSpeed) override;
+  int16_t getFanSpeed() override;
+  int16_t getMaxSpeed() const override { return MaxSpeed; }
+
+  uint8_t minimumDuty = 0; // duty in percent at speed 1, most EC fans stop below 10-20 %
+
+protected:
+  void updateMode() override;
+
+private:
+  void setPWM();
+
+  const uint8_t _PWM_PIN;
+  const uint8_t _ENABLE_PIN;
+  uint16_t _pwmRange = 1024;
+
+  int16_t _speed = 0;
+};
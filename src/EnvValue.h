@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @brief Environment value of the fan logic (humidity, temperature, rates).
+ * Built with FAN_FIXED_POINT the value is kept as scaled integer in 1/100
+ * units (0.01 %RH, 0.01 °C), so the threshold logic avoids soft-float on the
+ * RP2040. Otherwise it is a thin wrapper around float.
+ */
+class EnvValue {
+public:
+#ifdef FAN_FIXED_POINT
+  typedef int32_t Raw;
+  static constexpr int32_t Scale = 100;
+#else
+  typedef float Raw;
+  static constexpr int32_t Scale = 1;
+#endif
+
+  EnvValue() : _raw(0) {}
+  EnvValue(float value) : _raw(fromFloat(value)) {}
+
+  static EnvValue fromRaw(Raw raw) {
+    EnvValue value;
+    value._raw = raw;
+    return value;
+  }
+
+  // exact in the fixed point build, e.g. for a decoded DPT 9 telegram
+  static EnvValue fromHundredths(int32_t hundredths) {
+#ifdef FAN_FIXED_POINT
+    return fromRaw(hundredths);
+#else
+    return fromRaw(hundredths / 100.0f);
+#endif
+  }
+
+  Raw raw() const { return _raw; }
+  float toFloat() const { return static_cast<float>(_raw) / Scale; }
+
+  // value in 1/100 units, exact in the fixed point build
+  int32_t toHundredths() const {
+#ifdef FAN_FIXED_POINT
+    return _raw;
+#else
+    return static_cast<int32_t>(lroundf(_raw * 100));
+#endif
+  }
+
+  // largest integer not greater than the value
+  int16_t floorToInt() const {
+#ifdef FAN_FIXED_POINT
+    return _raw >= 0 ? _raw / Scale : -((-_raw + Scale - 1) / Scale);
+#else
+    return static_cast<int16_t>(floor(_raw));
+#endif
+  }
+
+  // value * numerator / denominator without intermediate overflow
+  EnvValue mulDiv(int32_t numerator, int32_t denominator) const {
+#ifdef FAN_FIXED_POINT
+    return fromRaw(static_cast<Raw>(static_cast<int64_t>(_raw) * numerator / denominator));
+#else
+    return fromRaw(_raw * numerator / denominator);
+#endif
+  }
+
+  friend EnvValue operator+(EnvValue a, EnvValue b) { return fromRaw(a._raw + b._raw); }
+  friend EnvValue operator-(EnvValue a, EnvValue b) { return fromRaw(a._raw - b._raw); }
+  friend EnvValue operator*(EnvValue a, EnvValue b) {
+#ifdef FAN_FIXED_POINT
+    return fromRaw(static_cast<Raw>(static_cast<int64_t>(a._raw) * b._raw / Scale));
+#else
+    return fromRaw(a._raw * b._raw);
+#endif
+  }
+  friend bool operator<(EnvValue a, EnvValue b) { return a._raw < b._raw; }
+  friend bool operator<=(EnvValue a, EnvValue b) { return a._raw <= b._raw; }
+  friend bool operator>(EnvValue a, EnvValue b) { return a._raw > b._raw; }
+  friend bool operator>=(EnvValue a, EnvValue b) { return a._raw >= b._raw; }
+  friend bool operator==(EnvValue a, EnvValue b) { return a._raw == b._raw; }
+  friend bool operator!=(EnvValue a, EnvValue b) { return a._raw != b._raw; }
+
+private:
+  static Raw fromFloat(float value) {
+#ifdef FAN_FIXED_POINT
+    return static_cast<Raw>(lroundf(value * Scale));
+#else
+    return value;
+#endif
+  }
+
+  Raw _raw;
+};
@@ -1,31 +1,27 @@
 #include "Fan.h"
-#include <sstream>
 #include <algorithm>
 
 using namespace std;
 
+static_assert(FanPredictor::StepCount == Fan::StepCount, "the predictor plans in the steps of the fan");
+static_assert(FanSpeedCurve::StepCount == Fan::StepCount, "the speed curve is given in the steps of the fan");
+
 Fan::Fan(IFanHardware& hw)
     : _hw(hw) {
 }
 
 void Fan::onTimeoutTimer() {
-  changeFanSpeed(0, true); // force stop fan
+  _timerRemainingMs = 0;
+  _timerPaused = false;
+  dispatch(FanModeMachine::Event_TimerEnd);
+  arbitrate();
   if(_timerCallback) {
       _timerCallback();
   }
 }
 
 void Fan::setOperatingMode(OperatingMode operatingMode) {
-
-  // stop fan when leaving automatic mode
-  if(operatingMode != OperatingMode::Automatic 
-    && _operatingMode == OperatingMode::Automatic
-    && !_manualOverrideActive) {
-    changeFanSpeed(0); 
-  }
-
-  _operatingMode = operatingMode;
-  _manualOverrideActive = false; // reset manual override on mode change
+  dispatch(static_cast<FanModeMachine::Event>(FanModeMachine::Event_ModeOff + operatingMode));
   updateMode();
   updateEnvironment();
 }
@@ -33,17 +29,17 @@ void Fan::setOperatingMode(OperatingMode operatingMode) {
 void Fan::setVentilationMode(VentilationMode ventilationMode, VentilationModeTarget target) {
   if(target == VentilationModeTarget_Manual) {
     _ventilationModeManual = ventilationMode;
+    for (uint8_t source = 0; source < SourceCount; source++) {
+      if (source != Source_Automatic)
+        _requests[source].ventilationMode = ventilationMode;
+    }
   } else {
     _ventilationModeAutomatic = ventilationMode;
+    _requests[Source_Automatic].ventilationMode = ventilationMode;
   }
 
-  if (_autoModeActive) {
-    _ventilationMode = _ventilationModeAutomatic;
-  } else {
-    _ventilationMode = _ventilationModeManual;
-  }
-
-  updateMode();
+  _arbitrationPending = true;
+  arbitrate();
 }
 
 Fan::VentilationMode Fan::getVentilationMode() {
@@ -51,57 +47,230 @@ Fan::VentilationMode Fan::getVentilationMode() {
 }
 
 void Fan::setControlMode(ControlMode controlMode) {
-  controlMode = controlMode;
+  _controlMode = controlMode;
+  _predictor.reset();
   updateEnvironment();
 }
 
 void Fan::setFanSpeed(int16_t fanSpeed) {
-    _manualOverrideActive = true;
-  
-  changeFanSpeed(fanSpeed, true); // force speed change
-  _previousState = saveState(); // update previous state to current state after manual override
+  dispatch(FanModeMachine::Event_ManualCommand, fanSpeed);
+  arbitrate();
 }
 
-void Fan::changeFanSpeed(int16_t fanSpeed, bool force) {
-  if (!force && _manualOverrideActive) {
-    // manual override active, ignore speed changes except if forced
-    return;
-  }
-  // Delegate to derived class implementation
-  changeFanSpeedDelegate(fanSpeed);
-
-  // Notify listener of speed change
-  if (_speedChangeCallback) {
-    _speedChangeCallback(getFanSpeed());
-  }
+void Fan::resetFanSpeed() {
+  dispatch(FanModeMachine::Event_Reset);
+  arbitrate();
 }
 
 void Fan::setTimer(uint64_t secondsRemaining,
                    std::function<void()> timerCallback) {
   _timerCallback = timerCallback;
-  _hw.startOneShotTimer(secondsRemaining * 1000, [this]() {
+  // the run starts with timerSpeed or the current speed, a retrigger keeps the speed of the run
+  int16_t speed = isSourceActive(Source_Timer) ? _requests[Source_Timer].speed
+                : timerSpeed >= 0 ? timerSpeed : _requests[_activeSource].speed;
+  dispatch(FanModeMachine::Event_TimerStart, speed);
+  arbitrate();
+  _timerRemainingMs = secondsRemaining > UINT64_MAX / 1000 ? UINT64_MAX : secondsRemaining * 1000;
+  _timerSyncMs = _hw.getMillis();
+  _timerPaused = false;
+  armTimer();
+}
+
+void Fan::extendTimer(uint64_t seconds) {
+  if (!isSourceActive(Source_Timer))
+    return;
+  syncTimer();
+  uint64_t extensionMs = seconds > UINT64_MAX / 1000 ? UINT64_MAX : seconds * 1000;
+  _timerRemainingMs = extensionMs > UINT64_MAX - _timerRemainingMs ? UINT64_MAX : _timerRemainingMs + extensionMs;
+  if (!_timerPaused)
+    armTimer();
+}
+
+void Fan::pauseTimer(bool paused) {
+  if (!isSourceActive(Source_Timer) || paused == _timerPaused)
+    return;
+  syncTimer();
+  _timerPaused = paused;
+  if (paused)
+    _hw.stopOneShotTimer();
+  else
+    armTimer();
+}
+
+uint64_t Fan::timerRemainingMs() {
+  if (!isSourceActive(Source_Timer))
+    return 0;
+  syncTimer();
+  return _timerRemainingMs;
+}
+
+void Fan::syncTimer() {
+  uint32_t now = _hw.getMillis();
+  if (!_timerPaused) {
+    uint32_t elapsed = now - _timerSyncMs;
+    _timerRemainingMs = elapsed < _timerRemainingMs ? _timerRemainingMs - elapsed : 0;
+  }
+  _timerSyncMs = now;
+}
+
+void Fan::armTimer() {
+  // re-arming replaces the running deadline
+  _hw.startOneShotTimer(_timerRemainingMs, [this]() {
       this->onTimeoutTimer();
   });
 }
 
 void Fan::stopTimer() {
-  changeFanSpeed(0, true); // force stop fan
+  _timerRemainingMs = 0;
+  _timerPaused = false;
+  dispatch(FanModeMachine::Event_TimerEnd);
+  arbitrate();
   _hw.stopOneShotTimer();
   _timerCallback = nullptr;
 }
 
+
+void Fan::setScheduleSpeed(int16_t fanSpeed) {
+  dispatch(FanModeMachine::Event_ScheduleSwitch); // a new switch point replaces manual commands
+  setRequest(Source_Schedule, fanSpeed, _ventilationModeManual);
+  arbitrate();
+}
+
+void Fan::setTuningSpeed(int16_t fanSpeed) {
+  setRequest(Source_Tuning, fanSpeed, _ventilationModeManual);
+  arbitrate();
+}
+
+void Fan::clearTuningSpeed() {
+  clearRequest(Source_Tuning);
+  arbitrate();
+}
+
+void Fan::setRequest(Source source, int16_t fanSpeed, VentilationMode ventilationMode) {
+  Request& request = _requests[source];
+  if (isSourceActive(source) && request.speed == fanSpeed && request.ventilationMode == ventilationMode)
+    return;
+  request.speed = fanSpeed;
+  request.ventilationMode = ventilationMode;
+  _activeSources |= 1 << source;
+  _arbitrationPending = true;
+}
+
+void Fan::clearRequest(Source source) {
+  if (source == Source_Base || !isSourceActive(source))
+    return;
+  _activeSources &= ~(1 << source);
+  _arbitrationPending = true;
+}
+
+void Fan::releaseManualOverride() {
+  if (!isSourceActive(Source_Manual))
+    return;
+  clearRequest(Source_Manual);
+  _hw.stopOverrideTimer();
+}
+
+uint8_t Fan::modeState() const {
+  // the flags of the machine are the request bits of the sources it controls
+  return FanModeMachine::state(_operatingMode,
+                               (isSourceActive(Source_Timer) ? FanModeMachine::Timer : 0) |
+                               (isSourceActive(Source_Manual) ? FanModeMachine::Override : 0) |
+                               (isSourceActive(Source_Automatic) ? FanModeMachine::AutoActive : 0));
+}
+
+void Fan::dispatch(FanModeMachine::Event event, int16_t fanSpeed) {
+  uint8_t state = modeState();
+  const FanModeMachine::Transition& transition = FanModeMachine::lookup(state, event);
+  uint8_t cleared = state & ~transition.next;
+
+  if ((transition.actions & FanModeMachine::Action_ResetBase) && _requests[Source_Base].speed != 0) {
+    _requests[Source_Base].speed = 0;
+    _arbitrationPending = true;
+  }
+  if (cleared & FanModeMachine::Override)
+    releaseManualOverride();
+  if (cleared & FanModeMachine::AutoActive)
+    clearRequest(Source_Automatic);
+  if (cleared & FanModeMachine::Timer)
+    clearRequest(Source_Timer);
+
+  _operatingMode = static_cast<OperatingMode>(FanModeMachine::modeOf(transition.next));
+  if (_operatingMode == OperatingMode::Off)
+    setRequest(Source_Off, 0, _ventilationModeManual);
+  else
+    clearRequest(Source_Off);
+
+  if (transition.actions & FanModeMachine::Action_AutoRequest)
+    setRequest(Source_Automatic, fanSpeed, _ventilationModeAutomatic);
+  if (transition.actions & FanModeMachine::Action_ManualRequest) {
+    if (manualOverrideTimeoutMs == 0) {
+      _requests[Source_Base].speed = fanSpeed; // manual level stays after the override is released
+    } else {
+      _hw.startOverrideTimer(manualOverrideTimeoutMs, [this]() {
+          dispatch(FanModeMachine::Event_OverrideTimeout);
+          arbitrate();
+      });
+    }
+    setRequest(Source_Manual, fanSpeed, _ventilationModeManual);
+  }
+  if (transition.actions & FanModeMachine::Action_TimerRequest)
+    setRequest(Source_Timer, fanSpeed, _ventilationModeManual);
+}
+
+void Fan::arbitrate() {
+  if (!_arbitrationPending)
+    return;
+  _arbitrationPending = false;
+
+  // sources are numbered by priority, the highest set bit wins
+  Source winner = static_cast<Source>(31 - __builtin_clz(_activeSources));
+  const Request& request = _requests[winner];
+
+  bool modeChanged = request.ventilationMode != _ventilationMode;
+  _ventilationMode = request.ventilationMode;
+  if (request.speed != _appliedSpeed) {
+    _appliedSpeed = request.speed;
+    // Delegate to derived class implementation, it updates the mode as well
+    changeFanSpeedDelegate(request.speed);
+
+    // Notify listener of speed change
+    if (_speedChangeCallback) {
+      _speedChangeCallback(getFanSpeed());
+    }
+  } else if (modeChanged) {
+    updateMode();
+  }
+
+  if (winner != _activeSource) {
+    _activeSource = winner;
+    if (_sourceChangeCallback) {
+      _sourceChangeCallback(winner);
+    }
+  }
+}
+
 void Fan::setSpeedChangeCallback(std::function<void(int16_t)> callback) {
   _speedChangeCallback = callback;
 }
 
-bool Fan::setInsideHumdity(float insideRelHumidity) {
+void Fan::setSourceChangeCallback(std::function<void(Source)> callback) {
+  _sourceChangeCallback = callback;
+}
+
+bool Fan::setInsideHumdity(EnvValue insideRelHumidity) {
   bool thresholdCrossed = false;
+  bool boostStarted = _humidityTrend.addSample(_hw.getMillis(), insideRelHumidity,
+                                               trendRiseRate, trendMargin);
+  if (_controlMode == ControlMode::Predictive)
+    _predictor.addSample(_hw.getMillis(), insideRelHumidity.toHundredths(), speedToStep(max(_appliedSpeed, int16_t(0))),
+                         predictiveTimeConstantMs);
   if ((_insideRelHumidity < thresholdHumidityOn &&
       insideRelHumidity >= thresholdHumidityOn) ||
       (_insideRelHumidity >= thresholdHumidityOff &&
-      insideRelHumidity < thresholdHumidityOff)) {
+      insideRelHumidity < thresholdHumidityOff) ||
+      boostStarted) {
     thresholdCrossed = true;
-    _manualOverrideActive = false; // reset manual override on threshold crossing
+    dispatch(FanModeMachine::Event_HumidityCrossed); // ends a manual override in automatic mode
   }
   else
     thresholdCrossed = false;
@@ -111,99 +280,149 @@ bool Fan::setInsideHumdity(float insideRelHumidity) {
   return thresholdCrossed;
 }
 
-void Fan::setInsideTemperature(float insideTemperature) {
+void Fan::setInsideTemperature(EnvValue insideTemperature) {
   _insideTemperature = insideTemperature;
+  _insideTemperatureValid = true;
   updateEnvironment();
 }
 
-void Fan::setOutsideHumidity(float outsideRelHumidity) {
+void Fan::setOutsideHumidity(EnvValue outsideRelHumidity) {
   _outsideRelHumidity = outsideRelHumidity;
   updateEnvironment();
 }
 
-void Fan::setOutsideTemperature(float outsideTemperature) {
+void Fan::setOutsideTemperature(EnvValue outsideTemperature) {
   _outsideTemperature = outsideTemperature;
+  _outsideTemperatureValid = true;
   updateEnvironment();
 }
 
 void Fan::updateEnvironment() {
-  if (_operatingMode != OperatingMode::Automatic)
-    return;
-
-  if (humiditySensorMode == HumiditySensorMode::Absolute &&
-      !outsideAbsHumidityLower()){
-    // absolute humidity mode and outside humidity not lower -> switch off fan
-    changeFanSpeed(0);
-    return;
+  // only automatic mode reacts on the environment, skip the evaluation otherwise
+  if (_operatingMode == OperatingMode::Automatic) {
+    int16_t speed = 0;
+    FanModeMachine::Event event = evaluateEnvironment(speed);
+    if (!holdAutomatic(event, speed))
+      dispatch(event, speed);
   }
+  arbitrate();
+}
 
-  if(thresholdHumidityOff >= thresholdHumidityOn) {
-    // negative hysteresis
-    if (_insideRelHumidity >= thresholdHumidityOn) {
-      // humidity above threshold -> switch to auto mode
-      activateAutoMode();
-      return;
-    }
-    if (_insideRelHumidity < thresholdHumidityOff) {
-      // humidity below threshold -> switch to manual mode
-      deactivateAutoMode();
-      return;
-    }
-  } else {
-    // positive hysteresis
-    if (_insideRelHumidity < thresholdHumidityOff) {
-      // humidity below threshold -> switch to manual mode
-      deactivateAutoMode();
-      return;
-    }
+bool Fan::holdAutomatic(FanModeMachine::Event event, int16_t speed) {
+  if (event == FanModeMachine::Event_HumidityBand)
+    return false;
+  _dwellPending = false;
+  int16_t current = isSourceActive(Source_Automatic) ? _requests[Source_Automatic].speed : 0;
+  int16_t target = event == FanModeMachine::Event_HumidityHigh ? speed : 0;
+  if (target == current)
+    return false;
+
+  uint32_t now = _hw.getMillis();
+  uint32_t dwellMs = current == 0 ? automaticMinOffMs : (target == 0 ? automaticMinOnMs : automaticMinStepMs);
+  if (_automaticChanged && now - _automaticChangeMs < dwellMs) {
+    _dwellEndMs = _automaticChangeMs + dwellMs;
+    _dwellPending = true;
+    return true;
+  }
+  _automaticChanged = true;
+  _automaticChangeMs = now;
+  return false;
+}
 
-    if (_insideRelHumidity >= thresholdHumidityOn) {
-      // humidity above threshold -> switch to auto mode
-      activateAutoMode();
-      return;
-    }
+void Fan::loop() {
+  // the elapsed time of a run is taken in steps shorter than the 32 bit clock wrap
+  if (isSourceActive(Source_Timer))
+    syncTimer();
+  if (_dwellPending && static_cast<int32_t>(_hw.getMillis() - _dwellEndMs) >= 0) {
+    _dwellPending = false;
+    updateEnvironment();
   }
+}
 
+uint32_t Fan::msUntilDwellEnd() const {
+  if (!_dwellPending)
+    return UINT32_MAX;
+  int32_t remaining = static_cast<int32_t>(_dwellEndMs - _hw.getMillis());
+  return remaining > 0 ? remaining : 0;
 }
 
-void Fan::activateAutoMode() {
-  if(!_autoModeActive) {
-    _previousState = saveState();
+FanModeMachine::Event Fan::evaluateEnvironment(int16_t& speed) {
+  if (humiditySensorMode == HumiditySensorMode::Absolute &&
+      !outsideAbsHumidityLower()) {
+    // absolute humidity mode and outside humidity not lower -> hold the fan at 0
+    speed = 0;
+    return FanModeMachine::Event_HumidityHigh;
+  }
+
+  // fast rise ventilates until humidity is back at the baseline. The on
+  // threshold is checked first, so a negative hysteresis (off >= on) has no
+  // band and needs no branch of its own.
+  if (_humidityTrend.isBoosting() || _insideRelHumidity >= thresholdHumidityOn) {
+    speed = automaticSpeed();
+    return FanModeMachine::Event_HumidityHigh;
   }
-  _autoModeActive = true;
+  if (_insideRelHumidity < thresholdHumidityOff)
+    return FanModeMachine::Event_HumidityLow;
+  if (_controlMode == ControlMode::Predictive && isSourceActive(Source_Automatic)) {
+    // the plan runs down to the off threshold, so it is renewed within the band as well
+    speed = automaticSpeed();
+    return FanModeMachine::Event_HumidityHigh;
+  }
+  return FanModeMachine::Event_HumidityBand;
+}
+
+int16_t Fan::automaticSpeed() {
+  int16_t speed = 0;
   if (_controlMode == ControlMode::Threshold) {
-    changeFanSpeed(thresholdSpeed);
+    speed = thresholdSpeed;
   } else if (_controlMode == ControlMode::Adaptive) {
-    float delta = 0;
+    EnvValue delta = 0;
 
     if (humiditySensorMode == HumiditySensorMode::Relative) {
-      delta = max(_insideRelHumidity - thresholdHumidityOn, 0.0f);
+      delta = max(_insideRelHumidity - thresholdHumidityOn, EnvValue(0));
     } else // humiditySensorMode == HumiditySensorMode::Absolute
     {
-      delta = getDewPoint(_insideRelHumidity, _insideTemperature) -
-              getDewPoint(_outsideRelHumidity, _outsideTemperature);
-      // no hysteresis here yet
+      delta = dewPointDelta();
     }
-    changeFanSpeed(static_cast<int16_t>(floor(_controlGain * delta)));
+    // gain is given per step, drivers with a finer range get the finer output
+    speed = (controlGain * delta).mulDiv(getMaxSpeed(), StepCount).floorToInt();
+  } else if (_controlMode == ControlMode::Curve) {
+    if (speedCurve) {
+      EnvValue input = humiditySensorMode == HumiditySensorMode::Relative ? _insideRelHumidity : dewPointDelta();
+      speed = speedCurve->speed(input.toHundredths(), isSourceActive(Source_Automatic) ? _requests[Source_Automatic].speed : 0);
+    }
+  } else if (_controlMode == ControlMode::Predictive) {
+    uint32_t now = _hw.getMillis();
+    if (!isSourceActive(Source_Automatic))
+      _predictor.start(now);
+    speed = stepToSpeed(_predictor.plan(now, _insideRelHumidity.toHundredths(), thresholdHumidityOff.toHundredths(),
+                                        predictiveDeadlineMs, predictiveTimeConstantMs));
+  }
+  if (_humidityTrend.isBoosting()) {
+    speed = max(speed, trendSpeed);
   }
-  setVentilationMode(_ventilationModeAutomatic, VentilationModeTarget_Automatic);
+  return speed;
+}
+
+EnvValue Fan::dewPointDelta() {
+  return getDewPoint(_insideRelHumidity.toFloat(), _insideTemperature.toFloat()) -
+         getDewPoint(_outsideRelHumidity.toFloat(), _outsideTemperature.toFloat());
+}
+
+int16_t Fan::stepToSpeed(int16_t step) const {
+  return (step * getMaxSpeed() + StepCount / 2) / StepCount;
 }
 
-void Fan::deactivateAutoMode() {
-  _autoModeActive = false;
-  restoreState(_previousState);
+int16_t Fan::speedToStep(int16_t speed) const {
+  return (speed * StepCount + getMaxSpeed() / 2) / getMaxSpeed();
 }
 
-Fan::FanState Fan::saveState() {
-  FanState state;
-  state.speed = getFanSpeed();
-  state.ventilationMode = _ventilationMode;
-  return state;
+int16_t Fan::percentToSpeed(uint8_t percent) const {
+  return (percent * getMaxSpeed() + 50) / 100;
 }
 
-void Fan::restoreState(FanState state) {
-  changeFanSpeed(state.speed, true);
-  setVentilationMode(state.ventilationMode);
+uint8_t Fan::speedToPercent(int16_t speed) const {
+  return (speed * 100 + getMaxSpeed() / 2) / getMaxSpeed();
 }
 
 float Fan::getDewPoint(float relHumidity, float temperature) {
@@ -215,7 +434,39 @@ float Fan::getDewPoint(float relHumidity, float temperature) {
 }
 
 bool Fan::outsideAbsHumidityLower() {
-  float insideDewPoint = getDewPoint(_insideRelHumidity, _insideTemperature);
-  float outsideDewPoint = getDewPoint(_outsideRelHumidity, _outsideTemperature);
-  return insideDewPoint > outsideDewPoint;
-}
\ No newline at end of file
+  float insideDewPoint = getDewPoint(_insideRelHumidity.toFloat(), _insideTemperature.toFloat());
+  float outsideDewPoint = getDewPoint(_outsideRelHumidity.toFloat(), _outsideTemperature.toFloat());
+  // drier outside air starts the ventilation above the band and ends it at no difference
+  float band = _outsideDrier ? 0 : dewPointHysteresis.toFloat();
+  _outsideDrier = insideDewPoint - outsideDewPoint > band;
+  return _outsideDrier;
+}
+
+uint32_t Fan::heatRecoveryPeriodMs(int32_t flowPermille) const {
+  uint32_t minMs = heatRecoveryMinSeconds * 1000;
+  uint32_t maxMs = heatRecoveryMaxSeconds > heatRecoveryMinSeconds ? heatRecoveryMaxSeconds * 1000 : minMs;
+  uint32_t periodMs = maxMs;
+  if (maxMs > minMs && flowPermille > 0) {
+    // the core saturates after a fixed air volume, at the highest step after the shortest period
+    uint32_t flowMs = minMs * 1000 / flowPermille;
+    if (flowMs > maxMs)
+      flowMs = maxMs;
+    // a small difference recovers little heat, fewer reversals then lose less
+    // air in the core and the ducts; without temperatures only the airflow counts
+    int32_t weight = HeatRecoveryFullDelta;
+    if (_insideTemperatureValid && _outsideTemperatureValid) {
+      int32_t delta = (_insideTemperature - _outsideTemperature).toHundredths();
+      if (delta < 0)
+        delta = -delta;
+      if (delta < weight)
+        weight = delta;
+    }
+    periodMs = maxMs - static_cast<uint32_t>(static_cast<uint64_t>(maxMs - flowMs) * weight / HeatRecoveryFullDelta);
+    periodMs = (periodMs + 500) / 1000 * 1000;
+  }
+  // the exhaust air condenses in the core, a cold core must not stay in the supply air too long
+  if (heatRecoveryFrostSeconds && _outsideTemperatureValid && _outsideTemperature < EnvValue(0.0f) &&
+      periodMs > heatRecoveryFrostSeconds * 1000u)
+    periodMs = heatRecoveryFrostSeconds * 1000u;
+  return periodMs;
+}
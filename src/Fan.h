@@ -4,6 +4,11 @@
 #include <array>
 #include <functional>
 #include "IFanHardware.h"
+#include "EnvValue.h"
+#include "HumidityTrend.h"
+#include "FanPredictor.h"
+#include "FanSpeedCurve.h"
+#include "FanModeMachine.h"
 
 
 class Fan {
@@ -23,6 +28,8 @@ public:
   enum ControlMode {
     Threshold = 0,
     Adaptive = 1,
+    Predictive = 2,
+    Curve = 3,
   };
 
   enum HumiditySensorMode {
@@ -30,9 +37,16 @@ public:
     Absolute = 1,
   };
 
-  struct FanState {
-    int16_t speed = 0;
-    VentilationMode ventilationMode = VentilationMode::HeatRecovery;
+  // request sources in ascending priority, the highest active one drives the fan
+  enum Source {
+    Source_Base = 0,      // resting level, always active
+    Source_Schedule = 1,  // weekly time program
+    Source_Automatic = 2, // humidity control
+    Source_Manual = 3,    // manual override, optionally time limited
+    Source_Timer = 4,     // run-on timer
+    Source_Tuning = 5,    // auto-tune procedure of the adaptive gain
+    Source_Off = 6,       // operating mode off
+    SourceCount = 7,
   };
 
   enum VentilationModeTarget {
@@ -41,6 +55,9 @@ public:
   };
 
 
+  // steps of the Level KO and the speed parameters, drivers may offer a finer range
+  static constexpr int16_t StepCount = 5;
+
   virtual ~Fan() = default;
 
   Fan(IFanHardware& hw);
@@ -48,36 +65,97 @@ public:
   virtual void setOperatingMode(OperatingMode operatingMode);
   virtual void setControlMode(ControlMode controlMode);
   void setFanSpeed(int16_t fanSpeed); // for speed changes from outside
-  void setTimer(uint64_t secondsRemaining, std::function<void()> timerCallback);
+  void resetFanSpeed();               // base level 0 without manual override
+  void setTimer(uint64_t secondsRemaining, std::function<void()> timerCallback); // starts or restarts the run
+  void extendTimer(uint64_t seconds); // adds to the remaining time of a running timer
+  void pauseTimer(bool paused);       // holds the remaining time, the fan keeps the speed of the run
   void stopTimer();
+  bool isTimerPaused() const { return _timerPaused; }
+  uint64_t timerRemainingMs(); // 0 without timer
+  void setScheduleSpeed(int16_t fanSpeed); // base level from the weekly time program
+  void setTuningSpeed(int16_t fanSpeed);   // speed driven by the auto-tune procedure
+  void clearTuningSpeed();
   void setSpeedChangeCallback(std::function<void(int16_t)> callback);
-  FanState saveState();
-  void restoreState(FanState state);
+  void setSourceChangeCallback(std::function<void(Source)> callback);
+  Source getActiveSource() const { return _activeSource; }
+  void loop();                      // re-evaluates an automatic decision held back by the dwell times
+  uint32_t msUntilDwellEnd() const; // time until loop() re-evaluates, UINT32_MAX without held decision
+  bool isSourceActive(Source source) const { return _activeSources & (1 << source); }
   
-  bool setInsideHumdity(float insideRelHumidity);
-  void setInsideTemperature(float insideTemperature);
-  void setOutsideHumidity(float outsideRelHumidity);
-  void setOutsideTemperature(float outsideTemperature);
+  // %RH and °C, a float converts implicitly, fixed point sources pass EnvValue::fromHundredths()
+  bool setInsideHumdity(EnvValue insideRelHumidity);
+  void setInsideTemperature(EnvValue insideTemperature);
+  void setOutsideHumidity(EnvValue outsideRelHumidity);
+  void setOutsideTemperature(EnvValue outsideTemperature);
   virtual int16_t getFanSpeed() = 0;
+  virtual int16_t getMaxSpeed() const { return StepCount; } // speeds run from 0 to this value
+  int16_t stepToSpeed(int16_t step) const;
+  int16_t speedToStep(int16_t speed) const;
+  int16_t percentToSpeed(uint8_t percent) const;
+  uint8_t speedToPercent(int16_t speed) const;
   VentilationMode getVentilationMode();
+  OperatingMode getOperatingMode() const { return _operatingMode; }
   static float getDewPoint(float relHumidity, float temperature);
 
   HumiditySensorMode humiditySensorMode = HumiditySensorMode::Relative;
-  float thresholdHumidityOn = 60;
-  float thresholdHumidityOff = 60;
-  int16_t thresholdSpeed = 4;
+  EnvValue thresholdHumidityOn = 60;
+  EnvValue thresholdHumidityOff = 60;
+  int16_t thresholdSpeed = 4; // speeds in units of the driver, see getMaxSpeed()
+  EnvValue controlGain = 0.18f; // adaptive mode, steps per %RH (relative) or K dew point (absolute)
+  EnvValue trendRiseRate = 0; // %RH per minute to start boost ventilation, 0 = disabled
+  EnvValue trendMargin = 2;   // boost ends at pre-event baseline + margin
+  int16_t trendSpeed = 5;
+  const FanSpeedCurve* speedCurve = nullptr; // curve mode, compiled for getMaxSpeed(); without curve the fan stays off
+  uint32_t predictiveDeadlineMs = 30 * 60000; // predictive mode, time to reach thresholdHumidityOff
+  uint32_t predictiveTimeConstantMs = 30 * 60000; // predictive mode, decay of the excess humidity at the highest step
+  uint32_t manualOverrideTimeoutMs = 0; // 0 = manual override lasts until the next threshold crossing
+  int16_t timerSpeed = -1; // speed of a timer run, -1 keeps the current speed
+  // anti-chatter of the automatic requests: once switched on the fan runs at least
+  // automaticMinOnMs, once off it stays off automaticMinOffMs and a speed holds for
+  // automaticMinStepMs. Decisions within these times are taken again by loop().
+  uint32_t automaticMinOnMs = 0;
+  uint32_t automaticMinOffMs = 0;
+  uint32_t automaticMinStepMs = 0;
+  EnvValue dewPointHysteresis = 0; // absolute mode, K the outside dew point has to be lower to start ventilating
+  // reversal period of the heat recovery for drivers with alternating direction. It runs
+  // between the bounds from the airflow and the inside/outside temperature difference,
+  // equal bounds give a fixed period. Below 0 °C outside it is limited to the frost period.
+  uint8_t heatRecoveryMinSeconds = 60;
+  uint8_t heatRecoveryMaxSeconds = 60;
+  uint8_t heatRecoveryFrostSeconds = 0; // 0 = no frost protection
+  static constexpr int32_t HeatRecoveryFullDelta = 1500; // 0.01 K, from here the airflow alone sets the period
+  // locks the heat recovery to a cycle shared with other fans: exhaust from cycleStartMs
+  // (time of the hardware) for periodMs, then supply, repeating every 2 * periodMs. The
+  // common period replaces the own one. Drivers without alternating direction ignore it.
+  virtual void syncHeatRecovery(uint32_t periodMs, uint32_t cycleStartMs) {}
 
 protected:
-  void changeFanSpeed(int16_t fanSpeed, bool force = false); //used for changes from within base or derived classes
+  struct Request {
+    int16_t speed = 0;
+    VentilationMode ventilationMode = VentilationMode::HeatRecovery;
+  };
+
+  void setRequest(Source source, int16_t fanSpeed, VentilationMode ventilationMode);
+  void clearRequest(Source source);
+  void arbitrate(); // applies the highest active request, called on every source change
+  void releaseManualOverride();
+  void dispatch(FanModeMachine::Event event, int16_t fanSpeed = 0); // runs one transition of the mode machine
+  uint8_t modeState() const;
   virtual void changeFanSpeedDelegate(int16_t fanSpeed) = 0; //specific speed change implementation in derived classes
   virtual void updateMode() = 0;
   void updateEnvironment();
+  FanModeMachine::Event evaluateEnvironment(int16_t& automaticSpeed);
+  int16_t automaticSpeed();
+  EnvValue dewPointDelta(); // inside - outside
+  bool holdAutomatic(FanModeMachine::Event event, int16_t speed); // true if a dwell time blocks the change
   bool outsideAbsHumidityLower();
-  void activateAutoMode();
-  void deactivateAutoMode();
+  // reversal period in ms for the airflow in permille of the highest step
+  uint32_t heatRecoveryPeriodMs(int32_t flowPermille) const;
   
   // Callbacks used by logic
   void onTimeoutTimer();
+  void syncTimer(); // counts the time since the last call off the remaining time of the run
+  void armTimer();
 
   IFanHardware& _hw;
 
@@ -87,17 +165,31 @@ protected:
   OperatingMode _operatingMode = OperatingMode::Manual;
   ControlMode _controlMode = ControlMode::Threshold;
   
-  bool _autoModeActive = false;
-  bool _manualOverrideActive = false;
-  const float _controlGain = 0.18; // TODO: determine proper gain value
-
-  float _outsideRelHumidity = 0;
-  float _insideRelHumidity = 0;
-  float _outsideTemperature = 0;
-  float _insideTemperature = 0;
+  Request _requests[SourceCount];
+  uint8_t _activeSources = 1 << Source_Base; // bit per source with a request
+  Source _activeSource = Source_Base;
+  int16_t _appliedSpeed = -1;
+  bool _arbitrationPending = false;
+  HumidityTrend _humidityTrend;
+  FanPredictor _predictor;
+
+  EnvValue _outsideRelHumidity = 0;
+  EnvValue _insideRelHumidity = 0;
+  EnvValue _outsideTemperature = 0;
+  EnvValue _insideTemperature = 0;
+  bool _outsideTemperatureValid = false;
+  bool _insideTemperatureValid = false;
+  bool _outsideDrier = false;      // state of the dew point hysteresis
+  bool _automaticChanged = false;  // _automaticChangeMs holds the last change of the automatic request
+  bool _dwellPending = false;      // a decision waits for _dwellEndMs
+  uint32_t _automaticChangeMs = 0;
+  uint32_t _dwellEndMs = 0;
+
+  uint64_t _timerRemainingMs = 0; // at _timerSyncMs
+  uint32_t _timerSyncMs = 0;
+  bool _timerPaused = false;
 
   std::function<void()> _timerCallback;
   std::function<void(int16_t)> _speedChangeCallback;
-
-  FanState _previousState;
+  std::function<void(Source)> _sourceChangeCallback;
 };
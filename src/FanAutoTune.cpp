@@ -0,0 +1,132 @@
+#include "FanAutoTune.h"
+
+const int8_t FanAutoTune::PhaseSteps[PhaseCount] = {0, 5, 0, 5};
+
+void FanAutoTune::start(uint32_t nowMs) {
+  _state = Running;
+  _phase = 0;
+  _phaseStartMs = nowMs;
+  _nextSampleMs = nowMs;
+  _lastSampleValid = false;
+  _gain = 0;
+  resetFit();
+}
+
+void FanAutoTune::abort() {
+  _state = Idle;
+  _phase = 0;
+}
+
+void FanAutoTune::fail() {
+  _state = Failed;
+  _phase = 0;
+}
+
+uint32_t FanAutoTune::msUntilNextEvent(uint32_t nowMs) const {
+  if (_state != Running)
+    return UINT32_MAX;
+  int32_t sample = (int32_t)(_nextSampleMs - nowMs);
+  int32_t phaseEnd = (int32_t)(_phaseStartMs + PhaseMs - nowMs);
+  int32_t next = sample < phaseEnd ? sample : phaseEnd;
+  return next > 0 ? next : 0;
+}
+
+void FanAutoTune::setHumidity(float relHumidity) {
+  _humidity = relHumidity;
+  _humidityValid = true;
+}
+
+bool FanAutoTune::loop(uint32_t nowMs) {
+  if (_state != Running)
+    return false;
+
+  // sensors send on change, the last value is held between telegrams
+  if ((int32_t)(nowMs - _nextSampleMs) >= 0) {
+    _nextSampleMs = nowMs + SamplePeriodMs;
+    if (_humidityValid) {
+      float sample = _humidity;
+      if (_lastSampleValid) {
+        float x = _lastSample - _fit.origin;
+        float y = sample - _fit.origin;
+        _fit.sumX += x;
+        _fit.sumY += y;
+        _fit.sumXX += x * x;
+        _fit.sumXY += x * y;
+        _fit.pairs++;
+      } else {
+        _fit.origin = sample;
+      }
+      _lastSample = sample;
+      _lastSampleValid = true;
+    }
+  }
+
+  if (nowMs - _phaseStartMs < PhaseMs)
+    return false;
+
+  if (!finishPhase()) {
+    _state = Failed;
+    _phase = 0;
+    return true;
+  }
+  if (++_phase < PhaseCount) {
+    _phaseStartMs = nowMs;
+    resetFit();
+    // the step changes now, a pair across the change fits neither phase
+    if (_humidityValid) {
+      _lastSample = _fit.origin = _humidity;
+      _lastSampleValid = true;
+      _nextSampleMs = nowMs + SamplePeriodMs;
+    }
+    return true;
+  }
+
+  // process gain in %RH per step, averaged over the step changes
+  float response = 0;
+  for (uint8_t i = 1; i < PhaseCount; i++) {
+    float change = (_settled[i] - _settled[i - 1]) / (PhaseSteps[i] - PhaseSteps[i - 1]);
+    if (change >= 0) {
+      // more air has to lower the humidity, anything else was disturbed
+      _state = Failed;
+      _phase = 0;
+      return true;
+    }
+    response -= change;
+  }
+  response /= PhaseCount - 1;
+  _phase = 0;
+  if (response < MinResponse) {
+    _state = Failed;
+    return true;
+  }
+  // loop gain 1: the controller halves a deviation, twice as fast as the room alone
+  _gain = 1.0f / response;
+  _gain = _gain < MinGain ? MinGain : (_gain > MaxGain ? MaxGain : _gain);
+  _state = Done;
+  return true;
+}
+
+bool FanAutoTune::finishPhase() {
+  const Fit& fit = _fit;
+  if (fit.pairs < 4)
+    return false; // no humidity telegrams during the phase
+
+  float n = fit.pairs;
+  float variance = n * fit.sumXX - fit.sumX * fit.sumX;
+  float a = variance > 0 ? (n * fit.sumXY - fit.sumX * fit.sumY) / variance : 0;
+  if (variance < n * n * 0.01f || a <= 0) {
+    // settled or only sensor noise, the mean is the settling value
+    _settled[_phase] = _fit.origin + fit.sumY / n;
+    return true;
+  }
+  if (a >= MaxPole)
+    return false; // still moving at the end of the phase, no reliable settling value
+  float c = (fit.sumY - a * fit.sumX) / n;
+  _settled[_phase] = _fit.origin + c / (1 - a);
+  return true;
+}
+
+void FanAutoTune::resetFit() {
+  _fit = Fit();
+  _fit.origin = _lastSample;
+}
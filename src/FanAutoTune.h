@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Identifies the humidity response of the room and derives the gain
+ * of the adaptive controller.
+ * The procedure drives the fan through a fixed sequence of steps. Within each
+ * phase the inside humidity is sampled at a fixed period and fitted to a first
+ * order response h[k+1] = a * h[k] + c, which gives the settling value
+ * c / (1 - a). The change of the settling value per step between phases is the
+ * process gain of the room, the controller gain is chosen for a loop gain of 1.
+ * loop() takes at most one sample per call and only updates running sums, so
+ * the procedure runs inside the normal loop with constant cost per tick.
+ */
+class FanAutoTune {
+public:
+  // values of the status KO
+  enum State : uint8_t {
+    Idle = 0,
+    Running = 1,
+    Done = 2,
+    Failed = 3,
+  };
+
+  static constexpr uint32_t SamplePeriodMs = 30000;
+  static constexpr uint32_t PhaseMs = 15 * 60000;
+  static constexpr uint8_t PhaseCount = 4;
+  static constexpr float MinResponse = 0.5f; // %RH per step, a weaker room response is not usable
+  static constexpr float MaxPole = 0.99f;    // a time constant far beyond the phase is not fitted
+  static constexpr float MinGain = 0.02f;
+  static constexpr float MaxGain = 2.0f;
+
+  // steps of the phases: settle, on, off, on
+  static const int8_t PhaseSteps[PhaseCount];
+
+  void start(uint32_t nowMs);
+  void abort(); // back to idle, the result is dropped
+  void fail();  // ends with Failed, e.g. when the channel cannot use a result
+  void setHumidity(float relHumidity);
+  bool loop(uint32_t nowMs); // true when the state or the requested step changed
+  uint32_t msUntilNextEvent(uint32_t nowMs) const; // next sample or phase end, UINT32_MAX when not running
+
+  State state() const { return _state; }
+  int16_t requestedStep() const { return PhaseSteps[_phase]; }
+  float gain() const { return _gain; } // steps per %RH, valid in state Done
+
+private:
+  struct Fit {
+    // sums of the sample pairs relative to the first sample of the phase
+    float origin;
+    float sumX, sumY, sumXX, sumXY;
+    uint16_t pairs;
+  };
+
+  bool finishPhase();
+  void resetFit();
+
+  State _state = Idle;
+  uint8_t _phase = 0;
+  uint32_t _phaseStartMs = 0;
+  uint32_t _nextSampleMs = 0;
+  float _humidity = 0;
+  bool _humidityValid = false;
+  float _lastSample = 0;
+  bool _lastSampleValid = false;
+  Fit _fit = {};
+  float _settled[PhaseCount] = {};
+  float _gain = 0;
+};
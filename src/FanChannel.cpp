@@ -11,7 +11,7 @@ _fan(fan)
 
 const std::string FanChannel::name()
 {
-    return "FanChannel" + _channelIndex;
+    return "FanChannel" + std::to_string(_channelIndex);
 }
 
 void FanChannel::setup(bool configured)
@@ -23,21 +23,434 @@ void FanChannel::setup(bool configured)
     setVentilationMode(ParamFAN_CH_VentMode);
     setVentilationMode(ParamFAN_CH_VentModeAutomatic, Fan::VentilationModeTarget_Automatic);
     setControlMode(ParamFAN_CH_ControlMode);
+    if (ParamFAN_CH_ControlMode == 3)
+    {
+        _speedCurve = createSpeedCurve(_fan.getMaxSpeed());
+        _fan.speedCurve = _speedCurve;
+    }
     setHumiditySensorMode(ParamFAN_CH_HumSensMode);
     _fan.thresholdHumidityOn = ParamFAN_CH_ThresholdHumidityOn;
     _fan.thresholdHumidityOff = ParamFAN_CH_ThresholdHumidityOff;
-    _fan.thresholdSpeed = ParamFAN_CH_ThresholdSpeed;
+    // speed parameters are steps, the driver may run a finer range
+    _fan.thresholdSpeed = _fan.stepToSpeed(ParamFAN_CH_ThresholdSpeed);
+    _fan.trendRiseRate = ParamFAN_CH_TrendRate / 10.0f;
+    _fan.trendMargin = ParamFAN_CH_TrendMargin;
+    _fan.trendSpeed = _fan.stepToSpeed(ParamFAN_CH_TrendSpeed);
+    _fan.manualOverrideTimeoutMs = ParamFAN_CH_OverrideTime * 60000;
+    _fan.timerSpeed = ParamFAN_CH_TimerSpeed ? _fan.stepToSpeed(ParamFAN_CH_TimerSpeed) : -1;
+    _fan.predictiveDeadlineMs = ParamFAN_CH_PredictDeadline * 60000;
+    _fan.predictiveTimeConstantMs = ParamFAN_CH_PredictTimeConstant * 60000;
+    _fan.automaticMinOnMs = ParamFAN_CH_AutoMinOnTime * 60000;
+    _fan.automaticMinOffMs = ParamFAN_CH_AutoMinOffTime * 60000;
+    _fan.automaticMinStepMs = ParamFAN_CH_AutoMinStepTime * 60000;
+    _fan.dewPointHysteresis = ParamFAN_CH_DewPointHysteresis / 10.0f;
+    if (ParamFAN_CH_HeatRecoveryAdaptive)
+    {
+        _fan.heatRecoveryMinSeconds = ParamFAN_CH_HeatRecoveryMinPeriod;
+        _fan.heatRecoveryMaxSeconds = ParamFAN_CH_HeatRecoveryMaxPeriod;
+        _fan.heatRecoveryFrostSeconds = ParamFAN_CH_HeatRecoveryFrostPeriod;
+    }
     
     // Set up callback to update KO feedback when fan speed changes
     _fan.setSpeedChangeCallback([this](int16_t newSpeed) {
-        KoFAN_CH_LevelFeedback.value(newSpeed, DPT_Value_1_Ucount);
+        KoFAN_CH_LevelFeedback.value(_fan.speedToStep(newSpeed), DPT_Value_1_Ucount);
+        KoFAN_CH_LevelPercentFeedback.value(_fan.speedToPercent(newSpeed), DPT_Scaling);
+        if (_history)
+            _history->set(FanHistory::Step, _fan.speedToStep(newSpeed), millis());
+        updateShadow();
+    });
+    _fan.setSourceChangeCallback([this](Fan::Source source) {
+        KoFAN_CH_ActiveSource.value((uint8_t)source, DPT_Value_1_Ucount);
+        updateShadow();
     });
 
+    _schedule.clear();
+    if (ParamFAN_CH_SchedActive)
+        setupSchedule();
+    setupSensors();
+    if (ParamFAN_CH_ShadowEnable)
+        setupShadow();
+    setupHistory();
+}
+
+void FanChannel::setupHistory()
+{
+    if (!ParamFAN_CH_HistoryEnable)
+    {
+        // a checkpoint of a history that was switched off since
+        delete _history;
+        _history = nullptr;
+        return;
+    }
+    if (_history == nullptr)
+    {
+        _history = new FanHistory();
+        _history->begin(millis());
+    }
+    _historyCheckpointMs = millis();
+    _history->set(FanHistory::Step, _fan.speedToStep(_fan.getFanSpeed()), millis());
+}
+
+FanHistory* FanChannel::history()
+{
+    if (_history)
+        _history->advance(millis());
+    return _history;
+}
+
+void FanChannel::restoreHistory(FanHistory* history)
+{
+    delete _history;
+    _history = history;
+}
+
+bool FanChannel::historyCheckpointEnabled()
+{
+    return _history && ParamFAN_CH_HistoryCheckpoint > 0;
+}
+
+bool FanChannel::historyCheckpointDue()
+{
+    if (!historyCheckpointEnabled() || millis() - _historyCheckpointMs < ParamFAN_CH_HistoryCheckpoint * 3600000UL)
+        return false;
+    _historyCheckpointMs = millis();
+    return true;
+}
+
+void FanChannel::setupShadow()
+{
+    _shadow = new FanShadow([]() -> uint32_t { return millis(); });
+    Fan& shadow = _shadow->fan();
+    // the policy under test, the shadow runs in steps
+    shadow.setOperatingMode(Fan::OperatingMode::Automatic);
+    switch (ParamFAN_CH_ShadowControlMode)
+    {
+    case 1:
+        shadow.setControlMode(Fan::ControlMode::Adaptive);
+        break;
+    case 2:
+        shadow.setControlMode(Fan::ControlMode::Predictive);
+        break;
+    case 3:
+        // the shadow runs in steps, the curve of the live fan may have a finer range
+        if (_speedCurve && _fan.getMaxSpeed() == shadow.getMaxSpeed())
+            shadow.speedCurve = _speedCurve;
+        else
+        {
+            _shadowSpeedCurve = createSpeedCurve(shadow.getMaxSpeed());
+            shadow.speedCurve = _shadowSpeedCurve;
+        }
+        shadow.setControlMode(Fan::ControlMode::Curve);
+        break;
+    default:
+        break;
+    }
+    if (ParamFAN_CH_ShadowHumSensMode == 1)
+        shadow.humiditySensorMode = Fan::HumiditySensorMode::Absolute;
+    shadow.thresholdHumidityOn = ParamFAN_CH_ShadowThresholdOn;
+    shadow.thresholdHumidityOff = ParamFAN_CH_ShadowThresholdOff;
+    shadow.thresholdSpeed = ParamFAN_CH_ShadowThresholdSpeed;
+    // everything else as the live fan, so the comparison shows the effect of these parameters
+    shadow.controlGain = _fan.controlGain;
+    shadow.trendRiseRate = _fan.trendRiseRate;
+    shadow.trendMargin = _fan.trendMargin;
+    shadow.trendSpeed = ParamFAN_CH_TrendSpeed;
+    shadow.predictiveDeadlineMs = _fan.predictiveDeadlineMs;
+    shadow.predictiveTimeConstantMs = _fan.predictiveTimeConstantMs;
+    shadow.automaticMinOnMs = _fan.automaticMinOnMs;
+    shadow.automaticMinOffMs = _fan.automaticMinOffMs;
+    shadow.automaticMinStepMs = _fan.automaticMinStepMs;
+    shadow.dewPointHysteresis = _fan.dewPointHysteresis;
+
+    _shadow->setStepChangeCallback([this](int16_t step) {
+        KoFAN_CH_ShadowLevel.value(step, DPT_Value_1_Ucount);
+        updateShadow();
+    });
+    updateShadow();
+}
+
+void FanChannel::updateShadow()
+{
+    if (_shadow == nullptr)
+        return;
+    // manual override, timer, auto-tune and off are no decisions of the policy, the comparison pauses
+    _shadow->setLive(_fan.speedToStep(_fan.getFanSpeed()), _fan.getActiveSource() <= Fan::Source_Automatic);
+    // sent when a step changes and every ShadowPublishMs while diverging
+    _shadowPublishedMs = millis();
+    uint32_t minutes = _shadow->divergentMinutes();
+    if ((uint32_t)KoFAN_CH_ShadowDivergenceTime.value(DPT_Value_4_Ucount) != minutes)
+        KoFAN_CH_ShadowDivergenceTime.value(minutes, DPT_Value_4_Ucount);
+    uint32_t stepMinutes = _shadow->stepMinutes();
+    if ((uint32_t)KoFAN_CH_ShadowDivergenceSteps.value(DPT_Value_4_Ucount) != stepMinutes)
+        KoFAN_CH_ShadowDivergenceSteps.value(stepMinutes, DPT_Value_4_Ucount);
+}
+
+void FanChannel::setupSensors()
+{
+    SensorAggregate::Mode mode = (SensorAggregate::Mode)ParamFAN_CH_SensorAggregation;
+    uint32_t staleMs = ParamFAN_CH_SensorStaleTime * 60000;
+    _insideHumidity.configure(mode, ParamFAN_CH_SensorCount, staleMs);
+    // the temperatures belong to the dew point, a maximum of them has no meaning
+    _insideTemperature.configure(mode == SensorAggregate::Max ? SensorAggregate::Mean : mode, ParamFAN_CH_SensorCount, staleMs);
+    const uint8_t weights[SensorAggregate::MaxSensors] = {ParamFAN_CH_SensorWeight1, ParamFAN_CH_SensorWeight2, ParamFAN_CH_SensorWeight3};
+    for (uint8_t i = 0; i < SensorAggregate::MaxSensors; i++)
+    {
+        _insideHumidity.setWeight(i, weights[i]);
+        _insideTemperature.setWeight(i, weights[i]);
+    }
+}
+
+void FanChannel::applyInsideHumidity()
+{
+    if (!_insideHumidity.valid())
+        return;
+    _humidityAppliedMs = millis();
+    int32_t hundredths = _insideHumidity.hundredths();
+    EnvValue humidity = EnvValue::fromHundredths(hundredths);
+    _fan.setInsideHumdity(humidity);
+    if (_shadow)
+        _shadow->fan().setInsideHumdity(humidity);
+    if (_history)
+        _history->set(FanHistory::Humidity, hundredthsToTenths(hundredths), millis());
+    _autoTune.setHumidity(humidity.toFloat());
+}
+
+void FanChannel::setInsideTemperature(int32_t hundredths)
+{
+    EnvValue temperature = EnvValue::fromHundredths(hundredths);
+    _fan.setInsideTemperature(temperature);
+    if (_shadow)
+        _shadow->fan().setInsideTemperature(temperature);
+    if (_history)
+        _history->set(FanHistory::Temperature, hundredthsToTenths(hundredths), millis());
+}
+
+int16_t FanChannel::hundredthsToTenths(int32_t hundredths)
+{
+    // rounded half away from zero like lroundf()
+    return (hundredths >= 0 ? hundredths + 5 : hundredths - 5) / 10;
+}
+
+void FanChannel::setupSchedule()
+{
+    // switch points are stored as consecutive blocks of day, hour, minute and speed
+    for (uint8_t i = 0; i < FanSchedule::MaxSwitchPoints; i++)
+    {
+        uint16_t offset = FAN_ParamCalcIndex(FAN_CH_Sched1Day) + i * 4;
+        _schedule.addSwitchPoint(knx.paramByte(offset), knx.paramByte(offset + 1), knx.paramByte(offset + 2), (int8_t)knx.paramByte(offset + 3));
+    }
+
+    _schedule.setSwitchCallback([this](int16_t speed) {
+        _fan.setScheduleSpeed(_fan.stepToSpeed(speed));
+        if (_shadow)
+            _shadow->fan().setScheduleSpeed(speed);
+    });
+}
+
+FanSpeedCurve* FanChannel::createSpeedCurve(int16_t maxSpeed)
+{
+    // breakpoints are stored as consecutive blocks of value, hysteresis and step, step 0 = unused
+    FanSpeedCurve* curve = new FanSpeedCurve();
+    for (uint8_t i = 0; i < FanSpeedCurve::MaxPoints; i++)
+    {
+        uint16_t offset = FAN_ParamCalcIndex(FAN_CH_Curve1Value) + i * 3;
+        if (knx.paramByte(offset + 2) > 0)
+            curve->addPoint(knx.paramByte(offset), knx.paramByte(offset + 1), knx.paramByte(offset + 2));
+    }
+    curve->compile(maxSpeed, ParamFAN_CH_CurveLinear);
+    return curve;
+}
+
+void FanChannel::loop()
+{
+    _schedule.loop(millis());
+    _fan.loop();
+    if (_shadow)
+        _shadow->fan().loop();
+
+    // operating mode off cancels a running auto-tune, the measurement would be useless
+    if (_autoTune.state() == FanAutoTune::Running && _fan.isSourceActive(Fan::Source_Off))
+    {
+        _autoTune.abort();
+        updateAutoTune();
+    }
+    if (_autoTune.loop(millis()))
+        updateAutoTune();
+
+    // a paused run keeps its remaining time, it was sent with the pause
+    if (ParamFAN_CH_TimerRemainingInterval && _fan.isSourceActive(Fan::Source_Timer) && !_fan.isTimerPaused() &&
+        millis() - _timerRemainingSentMs >= ParamFAN_CH_TimerRemainingInterval * 1000UL)
+        sendTimerRemaining();
+
+    // a long divergence is reported while it lasts, not only when it ends
+    if (_shadow && _shadow->diverging() && millis() - _shadowPublishedMs >= ShadowPublishMs)
+        updateShadow();
+
+    // a stale sensor leaves the aggregate, the others take over
+    if (_insideHumidity.expire(millis()))
+        applyInsideHumidity();
+    if (_insideTemperature.expire(millis()) && _insideTemperature.valid())
+        setInsideTemperature(_insideTemperature.hundredths());
+
+    // sent after all KOs and timers of this loop, a change of several states is one telegram
+    if (ParamFAN_CH_StatusCompound)
+        updateStatus();
+}
+
+uint32_t FanChannel::status()
+{
+    int16_t speed = _fan.getFanSpeed();
+    uint32_t status = _fan.speedToPercent(speed);
+    status |= (uint32_t)_fan.speedToStep(speed) << Status_StepShift;
+    status |= (uint32_t)_fan.getVentilationMode() << Status_VentModeShift;
+    status |= (uint32_t)_fan.getOperatingMode() << Status_OpModeShift;
+    if (_fan.isSourceActive(Fan::Source_Automatic))
+        status |= Status_AutomaticActive;
+    if (_fan.isSourceActive(Fan::Source_Manual))
+        status |= Status_OverrideActive;
+    if (_fan.isSourceActive(Fan::Source_Timer))
+        status |= Status_TimerActive;
+    if (_hardwareFault)
+        status |= Status_FaultHardware;
+    if (_fan.getOperatingMode() == Fan::OperatingMode::Automatic && !_insideHumidity.valid())
+        status |= Status_FaultHumidity;
+    if (_autoTuneStatus == FanAutoTune::Failed)
+        status |= Status_FaultAutoTune;
+    return status;
+}
+
+void FanChannel::updateStatus()
+{
+    uint32_t current = status();
+    if (_statusSent && current == _status)
+        return;
+    _status = current;
+    _statusSent = true;
+    KoFAN_CH_Status.value(_status, DPT_Value_4_Ucount);
+}
+
+uint32_t FanChannel::msUntilNextEvent()
+{
+    uint32_t now = millis();
+    // results of telegrams processed after this loop() are due right away
+    if (_tunedGainChanged || (ParamFAN_CH_StatusCompound && (!_statusSent || status() != _status)))
+        return 0;
+
+    uint32_t next = _autoTune.msUntilNextEvent(now);
+    uint32_t stale = _insideHumidity.msUntilExpiry(now);
+    if (stale < next)
+        next = stale;
+    stale = _insideTemperature.msUntilExpiry(now);
+    if (stale < next)
+        next = stale;
+    uint32_t dwell = _fan.msUntilDwellEnd();
+    if (dwell < next)
+        next = dwell;
+    if (_shadow)
+    {
+        dwell = _shadow->fan().msUntilDwellEnd();
+        if (dwell < next)
+            next = dwell;
+        if (_shadow->diverging())
+        {
+            uint32_t elapsed = now - _shadowPublishedMs;
+            uint32_t publish = elapsed >= ShadowPublishMs ? 0 : ShadowPublishMs - elapsed;
+            if (publish < next)
+                next = publish;
+        }
+    }
+    if (ParamFAN_CH_TimerRemainingInterval && _fan.isSourceActive(Fan::Source_Timer) && !_fan.isTimerPaused())
+    {
+        uint32_t elapsed = now - _timerRemainingSentMs;
+        uint32_t interval = ParamFAN_CH_TimerRemainingInterval * 1000UL;
+        uint32_t remaining = elapsed >= interval ? 0 : interval - elapsed;
+        if (remaining < next)
+            next = remaining;
+    }
+    if (historyCheckpointEnabled())
+    {
+        uint32_t elapsed = now - _historyCheckpointMs;
+        uint32_t interval = ParamFAN_CH_HistoryCheckpoint * 3600000UL;
+        uint32_t checkpoint = elapsed >= interval ? 0 : interval - elapsed;
+        if (checkpoint < next)
+            next = checkpoint;
+    }
+    if (_schedule.isSynced() && _schedule.size() > 0)
+    {
+        uint32_t schedule = _schedule.msUntilNextSwitch(now);
+        if (schedule < next)
+            next = schedule;
+    }
+    return next;
+}
+
+void FanChannel::syncHeatRecovery(uint32_t periodMs, uint32_t cycleStartMs)
+{
+    if (!ParamFAN_CH_SyncEnable)
+        return;
+    // offset in percent of the cycle of two reversal periods, 50 % runs opposite to the master
+    _fan.syncHeatRecovery(periodMs, cycleStartMs + 2 * periodMs / 100 * ParamFAN_CH_SyncOffset);
+}
+
+void FanChannel::updateAutoTune()
+{
+    FanAutoTune::State state = _autoTune.state();
+    if (state == FanAutoTune::Running)
+    {
+        _fan.setTuningSpeed(_fan.stepToSpeed(_autoTune.requestedStep()));
+    }
+    else
+    {
+        if (state == FanAutoTune::Done)
+        {
+            // the identification runs on the relative humidity, the gain is in steps per %RH
+            setTunedGain(_autoTune.gain(), Fan::HumiditySensorMode::Relative);
+            _tunedGainChanged = true;
+        }
+        _fan.clearTuningSpeed();
+    }
+
+    if (state != _autoTuneStatus)
+    {
+        _autoTuneStatus = state;
+        KoFAN_CH_AutoTuneStatus.value(_autoTuneStatus, DPT_Value_1_Ucount);
+    }
+}
+
+void FanChannel::setTunedGain(float gain, Fan::HumiditySensorMode mode)
+{
+    if (gain <= 0)
+        return;
+    // kept for the flash even when unused, it applies again after switching back
+    _tunedGain = gain;
+    _tunedGainMode = mode;
+    if (_fan.humiditySensorMode == mode)
+        _fan.controlGain = gain;
+    if (_shadow && _shadow->fan().humiditySensorMode == mode)
+        _shadow->fan().controlGain = gain;
+}
+
+bool FanChannel::tunedGainChanged()
+{
+    bool changed = _tunedGainChanged;
+    _tunedGainChanged = false;
+    return changed;
+}
+
+void FanChannel::setTime(uint8_t weekday, uint8_t hour, uint8_t minute, uint8_t second)
+{
+    _schedule.setClock(weekday, hour, minute, second, millis());
 }
 
 void FanChannel::resetFan()
 {
-    _fan.setFanSpeed(0);
+    _fan.resetFanSpeed();
+    // publish the state after startup, the callbacks only report changes
+    KoFAN_CH_LevelFeedback.value(_fan.speedToStep(_fan.getFanSpeed()), DPT_Value_1_Ucount);
+    KoFAN_CH_LevelPercentFeedback.value(_fan.speedToPercent(_fan.getFanSpeed()), DPT_Scaling);
+    KoFAN_CH_ActiveSource.value((uint8_t)_fan.getActiveSource(), DPT_Value_1_Ucount);
+    if (_shadow)
+        KoFAN_CH_ShadowLevel.value(_shadow->step(), DPT_Value_1_Ucount);
 }
 
 int16_t FanChannel::getFanSpeed()
@@ -92,6 +505,12 @@ void FanChannel::setControlMode(uint8_t controlModeIdx)
     case 1:
         _fan.setControlMode(Fan::ControlMode::Adaptive);
         break;
+    case 2:
+        _fan.setControlMode(Fan::ControlMode::Predictive);
+        break;
+    case 3:
+        _fan.setControlMode(Fan::ControlMode::Curve);
+        break;
     default:
         break;
     }
@@ -118,21 +537,30 @@ void FanChannel::processInputKo(GroupObject& ko)
     if (!ko.initialized())
         return;
     uint16_t kobj = ko.asap();
-    switch (FAN_KoCalcIndex(kobj))
+    int16_t index = FAN_KoCalcIndex(kobj);
+    switch (index)
     {
         case FAN_KoCH_Level:
         {
-            int8_t speed = ko.value(DPT_Value_1_Ucount);
-            _fan.setFanSpeed(speed);
+            int8_t step = ko.value(DPT_Value_1_Ucount);
+            _fan.setFanSpeed(_fan.stepToSpeed(step));
             break;
         }
         case FAN_KoCH_LevelUpDown:
         {
             int8_t updown = ko.value(DPT_Step);
+            int16_t step = _fan.speedToStep(_fan.getFanSpeed());
             if(updown == 1)
-                _fan.setFanSpeed(_fan.getFanSpeed() + 1);
+                step = step < Fan::StepCount ? step + 1 : Fan::StepCount;
             else
-                _fan.setFanSpeed(_fan.getFanSpeed() - 1);
+                step = step > 0 ? step - 1 : 0;
+            _fan.setFanSpeed(_fan.stepToSpeed(step));
+            break;
+        }
+        case FAN_KoCH_LevelPercent:
+        {
+            uint8_t percent = ko.value(DPT_Scaling);
+            _fan.setFanSpeed(_fan.percentToSpeed(percent));
             break;
         }
         case FAN_KoCH_OpMode:
@@ -169,24 +597,64 @@ void FanChannel::processInputKo(GroupObject& ko)
             break;
         }
         case FAN_KoCH_TemperatureInside:
+        case FAN_KoCH_TemperatureInside2:
+        case FAN_KoCH_TemperatureInside3:
         {
-            _fan.setInsideTemperature(ko.value(DPT_Value_Temp));
+            uint8_t sensor = index == FAN_KoCH_TemperatureInside ? 0 : (index == FAN_KoCH_TemperatureInside2 ? 1 : 2);
+            int32_t hundredths;
+            if (!_insideTemperatureInput[sensor].decode(ko.valueRef(), hundredths))
+                break;
+            _insideTemperature.updateHundredths(sensor, hundredths, millis());
+            if (_insideTemperature.valid())
+                setInsideTemperature(_insideTemperature.hundredths());
             break;
         }
         case FAN_KoCH_HumidityInside:
+        case FAN_KoCH_HumidityInside2:
+        case FAN_KoCH_HumidityInside3:
         {
-            float humidity = ko.value(DPT_Value_Humidity);
-            _fan.setInsideHumdity(humidity);
+            uint8_t sensor = index == FAN_KoCH_HumidityInside ? 0 : (index == FAN_KoCH_HumidityInside2 ? 1 : 2);
+            int32_t hundredths;
+            if (!_insideHumidityInput[sensor].decode(ko.valueRef(), hundredths))
+                break;
+            // an unchanged aggregate is passed on once per trend slot, not once per sensor telegram
+            if (_insideHumidity.updateHundredths(sensor, hundredths, millis()) ||
+                millis() - _humidityAppliedMs >= HumidityTrend::SlotMs)
+                applyInsideHumidity();
             break;
         }
         case FAN_KoCH_TemperatureOutside:
         {
-            _fan.setOutsideTemperature(ko.value(DPT_Value_Temp));
+            int32_t hundredths;
+            if (!_outsideTemperatureInput.decode(ko.valueRef(), hundredths))
+                break;
+            EnvValue temperature = EnvValue::fromHundredths(hundredths);
+            _fan.setOutsideTemperature(temperature);
+            if (_shadow)
+                _shadow->fan().setOutsideTemperature(temperature);
             break;
         }
         case FAN_KoCH_HumidityOutside:
         {
-            _fan.setOutsideHumidity(ko.value(DPT_Value_Humidity));
+            int32_t hundredths;
+            if (!_outsideHumidityInput.decode(ko.valueRef(), hundredths))
+                break;
+            EnvValue humidity = EnvValue::fromHundredths(hundredths);
+            _fan.setOutsideHumidity(humidity);
+            if (_shadow)
+                _shadow->fan().setOutsideHumidity(humidity);
+            break;
+        }
+        case FAN_KoCH_AutoTune:
+        {
+            // the fit needs the relative humidity, a gain per K dew point cannot be identified
+            if (ko.value(DPT_Start) && _fan.humiditySensorMode == Fan::HumiditySensorMode::Absolute)
+                _autoTune.fail();
+            else if (ko.value(DPT_Start))
+                _autoTune.start(millis());
+            else
+                _autoTune.abort();
+            updateAutoTune();
             break;
         }
         case FAN_KoCH_TimerActivation:
@@ -199,7 +667,11 @@ void FanChannel::processInputKo(GroupObject& ko)
                 else
                     runtime = ParamFAN_CH_TimerSelection;
 
-                _fan.setTimer(runtime, std::bind(&FanChannel::timerCallback, this));
+                // a retrigger restarts the run or adds the run time to the remaining time
+                if (ParamFAN_CH_TimerRetrigger == 1 && _fan.isSourceActive(Fan::Source_Timer))
+                    _fan.extendTimer(runtime);
+                else
+                    _fan.setTimer(runtime, std::bind(&FanChannel::timerCallback, this));
                 int16_t timeractive = 1;
                 KoFAN_CH_TimerFeedback.value(timeractive, DPT_State);
             }
@@ -208,6 +680,13 @@ void FanChannel::processInputKo(GroupObject& ko)
                 int16_t timeractive = 0;
                 KoFAN_CH_TimerFeedback.value(timeractive, DPT_State);
             }
+            sendTimerRemaining();
+            break;
+        }
+        case FAN_KoCH_TimerPause:
+        {
+            _fan.pauseTimer(ko.value(DPT_Switch));
+            sendTimerRemaining();
             break;
         }
     }
@@ -217,4 +696,13 @@ void FanChannel::timerCallback()
 {
     int16_t timeractive = 0;
     KoFAN_CH_TimerFeedback.value(timeractive, DPT_State);
+    sendTimerRemaining();
+}
+
+void FanChannel::sendTimerRemaining()
+{
+    // DPT 7.005 ends at 65535 s, longer runs count down from there
+    uint64_t seconds = (_fan.timerRemainingMs() + 999) / 1000;
+    KoFAN_CH_TimerRemaining.value(seconds > UINT16_MAX ? UINT16_MAX : (uint16_t)seconds, DPT_TimePeriodSec);
+    _timerRemainingSentMs = millis();
 }
\ No newline at end of file
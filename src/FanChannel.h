@@ -3,22 +3,100 @@
 #include "OpenKNX.h"
 #include "knxprod.h"
 #include "Fan.h"
+#include "FanSchedule.h"
+#include "FanAutoTune.h"
+#include "SensorAggregate.h"
+#include "FanShadow.h"
+#include "FanHistory.h"
+#include "Dpt9Decoder.h"
 
 class FanChannel : public OpenKNX::Channel
 {
     private:
         const std::string name() override;
         Fan& _fan;
+        FanSchedule _schedule;
+        FanAutoTune _autoTune;
+        SensorAggregate _insideHumidity;    // inside sensors of the channel, the fan runs on the aggregate
+        SensorAggregate _insideTemperature;
+        // DPT 9 sensor KOs, decoded straight into 1/100 units
+        Dpt9Decoder _insideHumidityInput[SensorAggregate::MaxSensors];
+        Dpt9Decoder _insideTemperatureInput[SensorAggregate::MaxSensors];
+        Dpt9Decoder _outsideHumidityInput;
+        Dpt9Decoder _outsideTemperatureInput;
+        FanShadow* _shadow = nullptr; // dry-run controller, only allocated when enabled
+        FanSpeedCurve* _speedCurve = nullptr; // control mode curve only, per driver range
+        FanSpeedCurve* _shadowSpeedCurve = nullptr; // only when the live driver has another range
+        FanHistory* _history = nullptr; // only allocated when enabled, may come restored from flash
+        uint32_t _historyCheckpointMs = 0; // last checkpoint or setup
+        static constexpr uint32_t ShadowPublishMs = 5 * 60000; // divergence KOs while diverging
+        uint32_t _shadowPublishedMs = 0;
+        uint32_t _timerRemainingSentMs = 0;
+        uint32_t _humidityAppliedMs = 0; // last aggregate passed to the fan
+        uint8_t _autoTuneStatus = FanAutoTune::Idle;
+        float _tunedGain = 0; // 0 = not tuned, the fan keeps its default gain
+        Fan::HumiditySensorMode _tunedGainMode = Fan::HumiditySensorMode::Relative; // unit of the gain
+        bool _tunedGainChanged = false;
+        bool _hardwareFault = false;
+        uint32_t _status = 0;
+        bool _statusSent = false;
         void setOpMode(uint8_t opModeIdx);
         void setVentilationMode(uint8_t controlModeIdx, Fan::VentilationModeTarget target = Fan::VentilationModeTarget_Manual);
         void setControlMode(uint8_t controlModeIdx);
         void setHumiditySensorMode(uint8_t humiditySensorModeIdx);
+        void setupSchedule();
+        FanSpeedCurve* createSpeedCurve(int16_t maxSpeed);
+        void setupSensors();
+        void setupShadow();
+        void setupHistory();
+        void updateShadow(); // compares the live step with the shadow and publishes the statistics
+        void applyInsideHumidity();
+        void setInsideTemperature(int32_t hundredths); // live fan and shadow
+        static int16_t hundredthsToTenths(int32_t hundredths); // history resolution
+        void updateAutoTune();
+        void sendTimerRemaining();
+        void updateStatus();
 
     public:
+        // bits of the compound status KO (DPT 12.001), one telegram per loop with changes
+        enum StatusBits : uint32_t
+        {
+            Status_SpeedPercentMask = 0xFF,   // speed in percent
+            Status_StepShift = 8,             // 3 bit step
+            Status_VentModeShift = 11,        // 2 bit ventilation mode
+            Status_OpModeShift = 13,          // 2 bit operating mode
+            Status_AutomaticActive = 1UL << 16,
+            Status_OverrideActive = 1UL << 17, // manual override
+            Status_TimerActive = 1UL << 18,
+            Status_FaultHardware = 1UL << 24,  // conflict in the pin or PWM setup of the module
+            Status_FaultHumidity = 1UL << 25,  // automatic mode without inside humidity
+            Status_FaultAutoTune = 1UL << 26,  // last auto-tune failed
+        };
+
         FanChannel(uint8_t iChannelNumber, Fan& fan);
         void resetFan();
         int16_t getFanSpeed();
         void setup(bool configured) override;
+        void loop() override;
+        void setTime(uint8_t weekday, uint8_t hour, uint8_t minute, uint8_t second);
         void processInputKo(GroupObject& ko);
         void timerCallback();
+        // gain of the last successful auto-tune, kept in flash by the module
+        // the gain is only applied to a fan or shadow measuring in the same sensor mode
+        void setTunedGain(float gain, Fan::HumiditySensorMode mode);
+        float tunedGain() const { return _tunedGain; }
+        Fan::HumiditySensorMode tunedGainMode() const { return _tunedGainMode; }
+        bool tunedGainChanged(); // true once after a new result
+        // downsampled history of the inputs and the step, closed up to now; nullptr when disabled
+        FanHistory* history();
+        // a history restored from flash by the module, handed over before setup
+        void restoreHistory(FanHistory* history);
+        bool historyCheckpointEnabled();
+        bool historyCheckpointDue(); // true once per checkpoint interval
+        void setHardwareFault(bool fault) { _hardwareFault = fault; }
+        uint32_t status();
+        // common heat recovery cycle of the devices on the bus, shifted by the phase offset of the channel
+        void syncHeatRecovery(uint32_t periodMs, uint32_t cycleStartMs);
+        // time until loop() has work without new telegrams, the fan timers are in the module wheel
+        uint32_t msUntilNextEvent();
 };
\ No newline at end of file
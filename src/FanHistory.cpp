@@ -0,0 +1,245 @@
+#include "FanHistory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+template <uint16_t N>
+void FanHistory::DeltaRing<N>::clear() {
+  _base = NoValue;
+  _last = NoValue;
+  _head = 0;
+  _count = 0;
+  memset(_delta, 0, sizeof(_delta)); // unused buckets go to flash as well
+}
+
+template <uint16_t N>
+void FanHistory::DeltaRing<N>::push(int16_t value) {
+  if (_count == N) {
+    // the oldest bucket leaves, its value becomes the base of the next one
+    int8_t oldest = _delta[_head];
+    if (oldest != Gap)
+      _base += oldest;
+    _head = _head + 1 < N ? _head + 1 : 0;
+    _count--;
+  }
+
+  int8_t delta = Gap;
+  if (value != NoValue) {
+    if (_last == NoValue) {
+      // first value, all buckets so far are gaps, so the base is free
+      _base = value;
+      _last = value;
+    }
+    int32_t diff = static_cast<int32_t>(value) - _last;
+    delta = diff > MaxDelta ? MaxDelta : (diff < -MaxDelta ? -MaxDelta : diff);
+    _last += delta;
+  }
+  uint16_t tail = _head + _count;
+  _delta[tail < N ? tail : tail - N] = delta;
+  _count++;
+}
+
+template <uint16_t N>
+int16_t FanHistory::DeltaRing<N>::next(uint16_t& index, int16_t& ref) const {
+  uint16_t pos = _head + index;
+  int8_t delta = _delta[pos < N ? pos : pos - N];
+  index++;
+  if (delta == Gap)
+    return NoValue;
+  ref += delta;
+  return ref;
+}
+
+static void writeWord(void (*writeByte)(uint8_t value), uint16_t value) {
+  writeByte(value & 0xFF);
+  writeByte(value >> 8);
+}
+
+static uint16_t readWord(const uint8_t*& data) {
+  uint16_t value = data[0] | data[1] << 8;
+  data += 2;
+  return value;
+}
+
+template <uint16_t N>
+void FanHistory::DeltaRing<N>::write(void (*writeByte)(uint8_t value)) const {
+  writeWord(writeByte, _base);
+  writeWord(writeByte, _last);
+  writeWord(writeByte, _head);
+  writeWord(writeByte, _count);
+  for (uint16_t i = 0; i < N; i++)
+    writeByte(_delta[i]);
+}
+
+template <uint16_t N>
+bool FanHistory::DeltaRing<N>::read(const uint8_t*& data) {
+  _base = readWord(data);
+  _last = readWord(data);
+  _head = readWord(data);
+  _count = readWord(data);
+  for (uint16_t i = 0; i < N; i++)
+    _delta[i] = static_cast<int8_t>(*data++);
+  return _head < N && _count <= N;
+}
+
+void FanHistory::begin(uint32_t nowMs) {
+  for (uint8_t s = 0; s < SeriesCount; s++) {
+    _fine[s].clear();
+    _coarse[s].clear();
+    _held[s] = NoValue;
+    _sum[s] = 0;
+    _samples[s] = 0;
+    _coarseSum[s] = 0;
+    _coarseSamples[s] = 0;
+  }
+  _stepMax = NoValue;
+  _coarseStepMax = NoValue;
+  _coarseBuckets = 0;
+  _bucketStartMs = nowMs;
+}
+
+void FanHistory::set(Series series, int16_t value, uint32_t nowMs) {
+  advance(nowMs);
+  _held[series] = value;
+  if (series == Step) {
+    if (_stepMax == NoValue || value > _stepMax)
+      _stepMax = value;
+    return;
+  }
+  _sum[series] += value;
+  _samples[series]++;
+}
+
+void FanHistory::advance(uint32_t nowMs) {
+  while (nowMs - _bucketStartMs >= FineMs)
+    closeBucket();
+}
+
+static int16_t mean(int32_t sum, uint16_t count) {
+  int32_t half = count / 2;
+  return (sum + (sum >= 0 ? half : -half)) / count;
+}
+
+void FanHistory::closeBucket() {
+  int16_t values[SeriesCount];
+  for (uint8_t s = Humidity; s <= Temperature; s++) {
+    // without a telegram the sensor still reads the last value
+    values[s] = _samples[s] ? mean(_sum[s], _samples[s]) : _held[s];
+    _sum[s] = 0;
+    _samples[s] = 0;
+    if (values[s] != NoValue) {
+      _coarseSum[s] += values[s];
+      _coarseSamples[s]++;
+    }
+  }
+  values[Step] = _stepMax;
+  _stepMax = _held[Step];
+  if (values[Step] != NoValue && (_coarseStepMax == NoValue || values[Step] > _coarseStepMax))
+    _coarseStepMax = values[Step];
+
+  for (uint8_t s = 0; s < SeriesCount; s++)
+    _fine[s].push(values[s]);
+  _bucketStartMs += FineMs;
+  if (++_coarseBuckets == CoarseFactor)
+    closeCoarseBucket();
+}
+
+void FanHistory::closeCoarseBucket() {
+  for (uint8_t s = Humidity; s <= Temperature; s++) {
+    _coarse[s].push(_coarseSamples[s] ? mean(_coarseSum[s], _coarseSamples[s]) : NoValue);
+    _coarseSum[s] = 0;
+    _coarseSamples[s] = 0;
+  }
+  _coarse[Step].push(_coarseStepMax);
+  _coarseStepMax = NoValue;
+  _coarseBuckets = 0;
+}
+
+uint16_t FanHistory::size(Resolution resolution) const {
+  return resolution == Fine ? _fine[0].size() : _coarse[0].size();
+}
+
+void FanHistory::read(Resolution resolution, Series series, int16_t* out) const {
+  uint16_t index = 0;
+  if (resolution == Fine) {
+    int16_t ref = _fine[series].base();
+    while (index < _fine[series].size())
+      *out++ = _fine[series].next(index, ref);
+  } else {
+    int16_t ref = _coarse[series].base();
+    while (index < _coarse[series].size())
+      *out++ = _coarse[series].next(index, ref);
+  }
+}
+
+static void formatTenths(char* text, size_t size, int16_t value) {
+  if (value == FanHistory::NoValue) {
+    text[0] = 0;
+    return;
+  }
+  int32_t magnitude = abs(static_cast<int32_t>(value));
+  snprintf(text, size, "%s%ld.%ld", value < 0 ? "-" : "", (long)(magnitude / 10), (long)(magnitude % 10));
+}
+
+template <uint16_t N>
+void FanHistory::writeRingsCsv(const DeltaRing<N>* rings, uint16_t minutes, void (*line)(const char* text)) {
+  line("min,humidity,temperature,step");
+  // the three rings are filled together, one walk per series in step
+  uint16_t index[SeriesCount] = {};
+  int16_t ref[SeriesCount];
+  for (uint8_t s = 0; s < SeriesCount; s++)
+    ref[s] = rings[s].base();
+  uint16_t count = rings[0].size();
+  for (uint16_t i = 0; i < count; i++) {
+    int16_t humidity = rings[Humidity].next(index[Humidity], ref[Humidity]);
+    int16_t temperature = rings[Temperature].next(index[Temperature], ref[Temperature]);
+    int16_t step = rings[Step].next(index[Step], ref[Step]);
+    char humidityText[8];
+    char temperatureText[8];
+    char stepText[8] = "";
+    formatTenths(humidityText, sizeof(humidityText), humidity);
+    formatTenths(temperatureText, sizeof(temperatureText), temperature);
+    if (step != NoValue)
+      snprintf(stepText, sizeof(stepText), "%d", step);
+    char text[40];
+    snprintf(text, sizeof(text), "%ld,%s,%s,%s", -(long)(count - i) * minutes, humidityText, temperatureText, stepText);
+    line(text);
+  }
+}
+
+void FanHistory::writeCsv(Resolution resolution, void (*line)(const char* text)) const {
+  if (resolution == Fine)
+    writeRingsCsv(_fine, bucketMinutes(Fine), line);
+  else
+    writeRingsCsv(_coarse, bucketMinutes(Coarse), line);
+}
+
+void FanHistory::writeCheckpoint(void (*writeByte)(uint8_t value)) const {
+  writeByte(CheckpointVersion);
+  for (uint8_t s = 0; s < SeriesCount; s++) {
+    _fine[s].write(writeByte);
+    _coarse[s].write(writeByte);
+  }
+}
+
+bool FanHistory::readCheckpoint(const uint8_t* data, uint16_t size, uint32_t nowMs) {
+  begin(nowMs);
+  if (size < CheckpointSize || data[0] != CheckpointVersion)
+    return false;
+  data++;
+  bool valid = true;
+  for (uint8_t s = 0; s < SeriesCount; s++) {
+    valid &= _fine[s].read(data);
+    valid &= _coarse[s].read(data);
+  }
+  if (!valid) {
+    begin(nowMs);
+    return false;
+  }
+  // the time since the checkpoint is unknown, a gap bucket marks the restart
+  for (uint8_t s = 0; s < SeriesCount; s++) {
+    _fine[s].push(NoValue);
+    _coarse[s].push(NoValue);
+  }
+  return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Downsampled history of the inputs and the speed of one channel.
+ * Two resolutions: FineCount buckets of 1 min (6 h) and CoarseCount buckets
+ * of 10 min (72 h). A bucket holds the mean of the humidity and temperature
+ * telegrams in it, or the last value if none came, and the highest step.
+ * Values are stored as 8 bit differences to the previous bucket, a jump of
+ * more than MaxDelta is spread over the following buckets. Buckets are
+ * closed when the next value or a query arrives, so the history needs no
+ * timer while nothing happens. Gap marks buckets without value, e.g. the
+ * time before a value arrived or a restart.
+ *
+ * Units: humidity 0.1 %RH, temperature 0.1 °C, speed in steps.
+ */
+class FanHistory {
+public:
+  enum Series : uint8_t {
+    Humidity = 0,
+    Temperature = 1,
+    Step = 2,
+    SeriesCount = 3,
+  };
+
+  enum Resolution : uint8_t {
+    Fine = 0,   // 1 min buckets
+    Coarse = 1, // 10 min buckets
+  };
+
+  static constexpr uint16_t FineCount = 360;
+  static constexpr uint16_t CoarseCount = 432;
+  static constexpr uint32_t FineMs = 60000;
+  static constexpr uint8_t CoarseFactor = 10; // fine buckets per coarse bucket
+  static constexpr int16_t NoValue = INT16_MIN;
+  static constexpr int8_t MaxDelta = 127;
+  static constexpr int8_t Gap = INT8_MIN;
+  static constexpr uint8_t CheckpointVersion = 1;
+
+  void begin(uint32_t nowMs);
+  void set(Series series, int16_t value, uint32_t nowMs);
+  void advance(uint32_t nowMs); // closes the buckets that ended before nowMs
+
+  uint16_t size(Resolution resolution) const;
+  uint16_t bucketMinutes(Resolution resolution) const { return resolution == Fine ? 1 : CoarseFactor; }
+  // values of the buckets from the oldest one, NoValue for gaps; out holds size() entries
+  void read(Resolution resolution, Series series, int16_t* out) const;
+  // CSV from the oldest bucket, the first column is the bucket start in minutes before the last closed bucket end
+  void writeCsv(Resolution resolution, void (*line)(const char* text)) const;
+
+  // flash checkpoint of the closed buckets, a restored history continues after a gap bucket
+  static constexpr uint16_t CheckpointSize = 1 + SeriesCount * (2 * 8 + FineCount + CoarseCount);
+  void writeCheckpoint(void (*writeByte)(uint8_t value)) const;
+  bool readCheckpoint(const uint8_t* data, uint16_t size, uint32_t nowMs);
+
+private:
+  template <uint16_t N>
+  class DeltaRing {
+  public:
+    void clear();
+    void push(int16_t value); // NoValue is stored as gap
+    uint16_t size() const { return _count; }
+    // walks from the oldest bucket: start with index 0 and ref base(), each call returns the next value
+    int16_t base() const { return _base; }
+    int16_t next(uint16_t& index, int16_t& ref) const;
+    void write(void (*writeByte)(uint8_t value)) const;
+    bool read(const uint8_t*& data);
+
+  private:
+    int16_t _base = NoValue; // value before the oldest bucket
+    int16_t _last = NoValue; // reconstructed value of the newest bucket with a value
+    uint16_t _head = 0;      // oldest bucket
+    uint16_t _count = 0;
+    int8_t _delta[N];
+  };
+
+  void closeBucket();
+  void closeCoarseBucket();
+  template <uint16_t N>
+  static void writeRingsCsv(const DeltaRing<N>* rings, uint16_t minutes, void (*line)(const char* text));
+
+  DeltaRing<FineCount> _fine[SeriesCount];
+  DeltaRing<CoarseCount> _coarse[SeriesCount];
+  uint32_t _bucketStartMs = 0;
+  int16_t _held[SeriesCount] = {NoValue, NoValue, NoValue}; // last value of each series
+  int32_t _sum[SeriesCount] = {};     // humidity and temperature: sum of the telegrams in the bucket
+  uint16_t _samples[SeriesCount] = {};
+  int16_t _stepMax = NoValue;
+  int32_t _coarseSum[SeriesCount] = {};
+  uint8_t _coarseSamples[SeriesCount] = {};
+  int16_t _coarseStepMax = NoValue;
+  uint8_t _coarseBuckets = 0; // fine buckets in the running coarse bucket
+};
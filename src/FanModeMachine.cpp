@@ -0,0 +1,21 @@
+#include "FanModeMachine.h"
+
+#define FAN_MODE_ROW(s)                                                                                        \
+  {                                                                                                            \
+    transition(s, 0), transition(s, 1), transition(s, 2), transition(s, 3), transition(s, 4), transition(s, 5), \
+        transition(s, 6), transition(s, 7), transition(s, 8), transition(s, 9), transition(s, 10),             \
+        transition(s, 11), transition(s, 12)                                                                   \
+  }
+
+static_assert(FanModeMachine::EventCount == 13, "FAN_MODE_ROW has to list every event");
+static_assert(FanModeMachine::StateCount == 24, "table rows have to list every state");
+
+// constant initialised, the table lives in flash
+const FanModeMachine::Transition FanModeMachine::table[StateCount][EventCount] = {
+    FAN_MODE_ROW(0), FAN_MODE_ROW(1), FAN_MODE_ROW(2), FAN_MODE_ROW(3),
+    FAN_MODE_ROW(4), FAN_MODE_ROW(5), FAN_MODE_ROW(6), FAN_MODE_ROW(7),
+    FAN_MODE_ROW(8), FAN_MODE_ROW(9), FAN_MODE_ROW(10), FAN_MODE_ROW(11),
+    FAN_MODE_ROW(12), FAN_MODE_ROW(13), FAN_MODE_ROW(14), FAN_MODE_ROW(15),
+    FAN_MODE_ROW(16), FAN_MODE_ROW(17), FAN_MODE_ROW(18), FAN_MODE_ROW(19),
+    FAN_MODE_ROW(20), FAN_MODE_ROW(21), FAN_MODE_ROW(22), FAN_MODE_ROW(23),
+};
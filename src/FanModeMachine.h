@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Mode state machine of a fan as compile-time transition table.
+ * The state packs the operating mode and the flags of the sources that
+ * change by events: automatic ventilation active, manual override and
+ * run-on timer. Every state/event pair has one entry with the next state
+ * and the actions the fan has to run, so evaluation is a single lookup.
+ * Speeds are not part of the state, the fan keeps them in its requests.
+ */
+class FanModeMachine {
+public:
+  enum StateBit : uint8_t {
+    Timer = 1 << 0,      // run-on timer active
+    Override = 1 << 1,   // manual override active
+    AutoActive = 1 << 2, // humidity control requests ventilation
+  };
+  static constexpr uint8_t ModeShift = 3;
+  static constexpr uint8_t FlagMask = (1 << ModeShift) - 1;
+
+  // operating modes, same values as Fan::OperatingMode
+  enum Mode : uint8_t {
+    Mode_Off = 0,
+    Mode_Manual = 1,
+    Mode_Automatic = 2,
+    ModeCount = 3,
+  };
+  static constexpr uint8_t StateCount = ModeCount << ModeShift;
+
+  enum Event : uint8_t {
+    Event_ModeOff = 0, // Event_ModeOff + mode selects the operating mode
+    Event_ModeManual,
+    Event_ModeAutomatic,
+    Event_HumidityHigh,    // above the on threshold, fast rise or absolute mode without benefit
+    Event_HumidityLow,     // below the off threshold
+    Event_HumidityBand,    // within the hysteresis, keeps the state
+    Event_HumidityCrossed, // threshold crossed or fast rise started
+    Event_ManualCommand,
+    Event_OverrideTimeout,
+    Event_TimerStart,
+    Event_TimerEnd,
+    Event_ScheduleSwitch,
+    Event_Reset, // startup, resting level back to 0
+    EventCount,
+  };
+
+  enum Action : uint8_t {
+    Action_ResetBase = 1 << 0,     // resting level back to 0
+    Action_AutoRequest = 1 << 1,   // (re)calculate the automatic request
+    Action_ManualRequest = 1 << 2, // command becomes the manual request
+    Action_TimerRequest = 1 << 3,  // speed of the event becomes the speed of the run
+  };
+
+  struct Transition {
+    uint8_t next;
+    uint8_t actions;
+  };
+
+  static constexpr uint8_t state(uint8_t mode, uint8_t flags) { return mode << ModeShift | flags; }
+  static constexpr uint8_t modeOf(uint8_t state) { return state >> ModeShift; }
+
+  static const Transition& lookup(uint8_t state, Event event) { return table[state][event]; }
+
+  // rules the table is generated from, evaluated by the compiler only
+  static constexpr Transition transition(uint8_t s, uint8_t e) {
+    return e <= Event_ModeAutomatic ? modeTransition(s, e - Event_ModeOff)
+         : e == Event_HumidityHigh ? (automatic(s) ? Transition{uint8_t(s | AutoActive), Action_AutoRequest} : Transition{s, 0})
+         : e == Event_HumidityLow ? Transition{uint8_t(automatic(s) ? s & ~AutoActive : s), 0}
+         : e == Event_HumidityCrossed ? Transition{uint8_t(automatic(s) ? s & ~Override : s), 0}
+         : e == Event_ManualCommand ? ((s & Timer) ? Transition{s, Action_TimerRequest} : Transition{uint8_t(s | Override), Action_ManualRequest})
+         : e == Event_OverrideTimeout || e == Event_ScheduleSwitch ? Transition{uint8_t(s & ~Override), 0}
+         : e == Event_TimerStart ? Transition{uint8_t(s | Timer), Action_TimerRequest}
+         : e == Event_TimerEnd ? Transition{uint8_t(s & ~(Timer | Override)), Action_ResetBase}
+         : e == Event_Reset ? Transition{uint8_t(s & ~Override), Action_ResetBase}
+         : Transition{s, 0};
+  }
+
+  static const Transition table[StateCount][EventCount];
+
+private:
+  static constexpr bool automatic(uint8_t s) { return modeOf(s) == Mode_Automatic; }
+
+  // a mode change drops the override and keeps the run; automatic ventilation
+  // survives only re-selecting automatic mode. Leaving automatic mode without
+  // override stops the fan.
+  static constexpr Transition modeTransition(uint8_t s, uint8_t mode) {
+    return Transition{uint8_t(state(mode, (s & Timer) | (automatic(s) && mode == Mode_Automatic ? s & AutoActive : 0))),
+                      uint8_t(automatic(s) && mode != Mode_Automatic && !(s & Override) ? Action_ResetBase : 0)};
+  }
+};
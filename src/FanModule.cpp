@@ -1,5 +1,7 @@
 #include "FanModule.h"
 #include "IFanHardware.h"
+#include <string.h>
+#include <stdio.h>
 
 
 const std::string FanModule::name() { return "FanModule"; }
@@ -11,45 +13,218 @@ const std::string FanModule::version() {
 // void FanModule::setup() {}
 
 void FanModule::setup(bool configured) {
-  if(ParamFAN_StatusLED == 1) {
-    _fan1Hw.setDigital(STATUS_LED_PIN, true);
-  } else {
-  _fan1Hw.setDigital(STATUS_LED_PIN, false);
-  }
+  // the status LED belongs to the module, not to one of the fans
+  _statusLedReady = _statusLedReady || _pwmAllocator.claimDigital(STATUS_LED_PIN) == FanPwmAllocator::Ok;
+  if (_statusLedReady)
+    pinMode(STATUS_LED_PIN, OUTPUT);
+
+  setStatusLed(ParamFAN_StatusLED == 1);
+
+  _phaseSync.configure(static_cast<FanPhaseSync::Role>(ParamFAN_SyncRole), ParamFAN_SyncId,
+                       ParamFAN_SyncPeriod * 1000, millis());
 
   _channel[0] = new FanChannel(0, _fan1);
   _channel[1] = new FanChannel(1, _fan2);
 
   for (int i = 0; i < FAN_ChannelCount; i++) {
+    _channel[i]->restoreHistory(_flashHistory[i]);
+    _flashHistory[i] = nullptr;
     _channel[i]->setup(configured);
+    _channel[i]->setTunedGain(_flashGain[i], static_cast<Fan::HumiditySensorMode>(_flashGainMode[i]));
+    _channel[i]->setHardwareFault(_pwmAllocator.firstError() != FanPwmAllocator::Ok);
   }
+
+#ifdef FAN_TRACE_SIZE
+  // parameter snapshot covers the module and all channel blocks
+  _trace.begin(knx.paramData(0), FAN_ParamBlockOffset + FAN_ChannelCount * FAN_ParamBlockSize, millis());
+#endif
 }
 
 void FanModule::loop() {
+  // timer callbacks run here in loop context instead of alarm interrupts
+  _timerWheel.advance(time_us_64() / 1000);
+
   if (!openknx.afterStartupDelay())
     return;
 
-  bool anyFanRunning = false;
+  if (_phaseSync.loop(millis())) {
+    KoFAN_HeatRecoverySync.value(_phaseSync.telegram(), DPT_Value_4_Ucount);
+    syncChannels();
+  }
+
+  bool flashChanged = false;
   for (int i = 0; i < FAN_ChannelCount; i++) {
     _channel[i]->loop();
-    if (_channel[i]->getFanSpeed() > 0) {
-      anyFanRunning = true;
-    }
+    flashChanged |= _channel[i]->tunedGainChanged();
+    flashChanged |= _channel[i]->historyCheckpointDue();
   }
+  if (flashChanged)
+    openknx.flash.save();
+
+  setStatusLed(statusLedTarget());
+}
+
+bool FanModule::statusLedTarget() {
+  if (ParamFAN_StatusLED != 2)
+    return ParamFAN_StatusLED == 1;
+  for (int i = 0; i < FAN_ChannelCount; i++) {
+    if (_channel[i]->getFanSpeed() > 0)
+      return true;
+  }
+  return false;
+}
+
+uint32_t FanModule::msUntilNextEvent() {
+  // startup delay and processAfterStartupDelay() are polled by the framework
+  if (!openknx.afterStartupDelay())
+    return 0;
+
+  // a speed change by telegram is shown by the next loop()
+  if (_statusLedReady && statusLedTarget() != _statusLedOn)
+    return 0;
 
-  if (ParamFAN_StatusLED == 2) {
-    _fan1Hw.setDigital(STATUS_LED_PIN, anyFanRunning);
-  } else {
-    _fan1Hw.setDigital(STATUS_LED_PIN, false);
+  uint64_t now = time_us_64() / 1000;
+  uint64_t timer = _timerWheel.nextDeadlineMs();
+  uint32_t next = timer <= now ? 0 : (timer - now > UINT32_MAX ? UINT32_MAX : (uint32_t)(timer - now));
+  uint32_t sync = _phaseSync.msUntilNextEvent(millis());
+  if (sync < next)
+    next = sync;
+  for (int i = 0; i < FAN_ChannelCount; i++) {
+    uint32_t channel = _channel[i]->msUntilNextEvent();
+    if (channel < next)
+      next = channel;
   }
+  return next;
+}
+
+void FanModule::idle(uint32_t maxMs) {
+  uint32_t sleepMs = msUntilNextEvent();
+  if (sleepMs > maxMs)
+    sleepMs = maxMs;
+  if (sleepMs == 0)
+    return;
+  // wakes on the deadline alarm or any interrupt, loop() checks the clock again
+  best_effort_wfe_or_timeout(make_timeout_time_ms(sleepMs));
+}
+
+void FanModule::setStatusLed(bool on) {
+  if (!_statusLedReady || (_statusLedWritten && on == _statusLedOn))
+    return;
+  _fan1Hw.setDigital(STATUS_LED_PIN, on);
+  _statusLedOn = on;
+  _statusLedWritten = true;
 }
 
 void FanModule::processInputKo(GroupObject &ko) {
+#ifdef FAN_TRACE_SIZE
+  _trace.record(millis(), ko.asap(), ko.valueRef(), ko.valueSize());
+#endif
+
+  if (ko.asap() == KoFAN_Time.asap()) {
+    processTimeKo(ko);
+    return;
+  }
+  if (ko.asap() == KoFAN_HeatRecoverySync.asap()) {
+    processSyncKo(ko);
+    return;
+  }
+
   for (int i = 0; i < FAN_ChannelCount; i++) {
     _channel[i]->processInputKo(ko);
   }
 }
 
+void FanModule::processTimeKo(GroupObject &ko) {
+  // DPT 10.001: NNNHHHHH 00MMMMMM 00SSSSSS, day of week 1 = Monday
+  uint8_t *data = ko.valueRef();
+  uint8_t weekday = data[0] >> 5;
+  uint8_t hour = data[0] & 0x1F;
+  uint8_t minute = data[1] & 0x3F;
+  uint8_t second = data[2] & 0x3F;
+
+  for (int i = 0; i < FAN_ChannelCount; i++) {
+    _channel[i]->setTime(weekday, hour, minute, second);
+  }
+}
+
+void FanModule::processSyncKo(GroupObject &ko) {
+  if (_phaseSync.receive(ko.value(DPT_Value_4_Ucount), millis()))
+    syncChannels();
+}
+
+void FanModule::syncChannels() {
+  uint32_t now = millis();
+  for (int i = 0; i < FAN_ChannelCount; i++) {
+    _channel[i]->syncHeatRecovery(_phaseSync.periodMs(), _phaseSync.cycleStartMs(now));
+  }
+}
+
+uint16_t FanModule::flashSize() {
+  return FAN_ChannelCount * (FlashChannelSize + FanHistory::CheckpointSize);
+}
+
+void FanModule::writeFlash() {
+  for (int i = 0; i < FAN_ChannelCount; i++) {
+    openknx.flash.writeByte(FlashVersion);
+    openknx.flash.writeFloat(_channel[i]->tunedGain());
+    openknx.flash.writeByte(_channel[i]->tunedGainMode());
+  }
+  for (int i = 0; i < FAN_ChannelCount; i++) {
+    if (_channel[i]->historyCheckpointEnabled()) {
+      _channel[i]->history()->writeCheckpoint([](uint8_t value) { openknx.flash.writeByte(value); });
+      continue;
+    }
+    for (uint16_t j = 0; j < FanHistory::CheckpointSize; j++)
+      openknx.flash.writeByte(0);
+  }
+}
+
+void FanModule::readFlash(const uint8_t* data, const uint16_t size) {
+  // an empty or foreign block keeps the default gains, version 1 had no sensor mode
+  for (int i = 0; i < FAN_ChannelCount && (i + 1) * FlashChannelSize <= size; i++) {
+    const uint8_t* block = data + i * FlashChannelSize;
+    if (block[0] != FlashVersion)
+      continue;
+    memcpy(&_flashGain[i], block + 1, sizeof(float));
+    _flashGainMode[i] = block[1 + sizeof(float)];
+  }
+  // histories follow the gains, a block without version byte is unused
+  const uint8_t* history = data + FAN_ChannelCount * FlashChannelSize;
+  for (int i = 0; i < FAN_ChannelCount; i++, history += FanHistory::CheckpointSize) {
+    if (history + FanHistory::CheckpointSize > data + size || history[0] != FanHistory::CheckpointVersion)
+      continue;
+    delete _flashHistory[i];
+    _flashHistory[i] = new FanHistory();
+    if (!_flashHistory[i]->readCheckpoint(history, FanHistory::CheckpointSize, millis())) {
+      delete _flashHistory[i];
+      _flashHistory[i] = nullptr;
+    }
+  }
+}
+
+bool FanModule::processCommand(const std::string cmd, bool diagnoseKo) {
+  if (cmd.compare(0, 8, "fan hist") != 0)
+    return false;
+  unsigned channel = 0;
+  char resolution[8] = "";
+  if (sscanf(cmd.c_str(), "fan hist %u %7s", &channel, resolution) < 1 || channel < 1 || channel > FAN_ChannelCount) {
+    openknx.logger.log("usage: fan hist <channel> [fine|coarse]");
+    return true;
+  }
+  FanHistory* history = _channel[channel - 1]->history();
+  if (history == nullptr) {
+    openknx.logger.log("history of channel " + std::to_string(channel) + " is off");
+    return true;
+  }
+  FanHistory::Resolution res = strcmp(resolution, "coarse") == 0 ? FanHistory::Coarse : FanHistory::Fine;
+  history->writeCsv(res, [](const char* text) { openknx.logger.log(text); });
+  return true;
+}
+
+void FanModule::showHelp() {
+  openknx.console.printHelpLine("fan hist <ch> [coarse]", "History of a channel as CSV, 1 min or 10 min buckets");
+}
+
 // void FanModule::loop(bool configured)
 // {
 //     for(int i = 0; i < FAN_ChannelCount; i++)
@@ -1,11 +1,43 @@
 #pragma once
 
 #include "MaicoPPB30.h"
+#include "EcFan.h"
 #include "FanChannel.h"
 #include "OpenKNX.h"
 #include "hardware.h"
 #include "knxprod.h"
 #include "RP2040FanHardware.h"
+#include "FanTimerWheel.h"
+#include "FanPwmAllocator.h"
+#include "FanPhaseSync.h"
+#include "hardware/clocks.h"
+#ifdef FAN_TRACE_SIZE
+#include "FanTrace.h"
+#endif
+
+// Fan driver and PWM setup of the outputs, can be overridden per fan in
+// hardware.h. FANx_DRIVER_EC selects the continuous EC/0-10 V driver on the
+// S1 output with SW as enable, otherwise the outputs drive a Maico PPB30.
+// FANx_EC_MIN_DUTY is the duty in percent of the EC driver at speed 1, set
+// it to the start voltage of the fan (e.g. 20 for 2 V), most stall below.
+#ifndef FAN1_PWM_FREQ_HZ
+#define FAN1_PWM_FREQ_HZ 10000
+#endif
+#ifndef FAN1_PWM_RESOLUTION
+#define FAN1_PWM_RESOLUTION 10
+#endif
+#ifndef FAN2_PWM_FREQ_HZ
+#define FAN2_PWM_FREQ_HZ 10000
+#endif
+#ifndef FAN2_PWM_RESOLUTION
+#define FAN2_PWM_RESOLUTION 10
+#endif
+#ifndef FAN1_EC_MIN_DUTY
+#define FAN1_EC_MIN_DUTY 0
+#endif
+#ifndef FAN2_EC_MIN_DUTY
+#define FAN2_EC_MIN_DUTY 0
+#endif
 
 class FanModule : public OpenKNX::Module {
 public:
@@ -25,24 +57,79 @@ public:
 
   void processAfterStartupDelay() override;
   void processInputKo(GroupObject &ko) override;
+  void processTimeKo(GroupObject &ko);
+  void processSyncKo(GroupObject &ko);
   bool sendReadRequest(GroupObject &ko);
 
+  // Tickless idle: time until loop() has work again without new telegrams
+  // (fan timers, heat recovery reversal, schedule, auto-tune samples), capped
+  // at UINT32_MAX. idle() sleeps the core with WFE for that time, at most
+  // maxMs; any interrupt, e.g. from the bus, ends the sleep earlier.
+  uint32_t msUntilNextEvent();
+  void idle(uint32_t maxMs);
+
   const std::string name() override;
   const std::string version() override;
 
-  // Wenn das Modul auch Daten im Flash speichern soll, werden folgenden
-  // Methoden benötigt. void writeFlash() override; void readFlash(const
-  // uint8_t* data, const uint16_t size) override; uint16_t flashSize()
-  // override;
+  // pin and slice assignment, firstError() reports conflicts of the hardware setup
+  const FanPwmAllocator& pwmAllocator() const { return _pwmAllocator; }
+
+#ifdef FAN_TRACE_SIZE
+  // received telegrams since setup, replayed on the host by bench/trace_fan.cpp
+  const FanTraceWriter& trace() const { return _trace; }
+#endif
+
+  // console: "fan hist <channel> [coarse]" prints the history of a channel as CSV
+  bool processCommand(const std::string cmd, bool diagnoseKo) override;
+  void showHelp() override;
+
+  // auto-tuned gains of the channels: per channel a version byte and the gain as float,
+  // followed by a history checkpoint per channel, zeros when the channel has none
+  void writeFlash() override;
+  void readFlash(const uint8_t* data, const uint16_t size) override;
+  uint16_t flashSize() override;
+
 private:
-  RP2040FanHardware _fan1Hw;
+  static constexpr uint8_t FlashVersion = 2; // 2: sensor mode of the gain after the gain
+  static constexpr uint8_t FlashChannelSize = 2 + sizeof(float);
+
+  void setStatusLed(bool on); // writes the pin only on changes
+  bool statusLedTarget();
+  void syncChannels(); // hands the reference cycle of the phase sync to the channels
+
+  // all fan timers of the module, advanced from loop()
+  FanTimerWheel _timerWheel;
+  FanPhaseSync _phaseSync; // heat recovery phase shared with other devices
+  // must be constructed before the fans, they claim their pins on construction
+  FanPwmAllocator _pwmAllocator{clock_get_hz(clk_sys)};
+
+  RP2040FanHardware _fan1Hw{_timerWheel, _pwmAllocator, FAN1_PWM_FREQ_HZ, FAN1_PWM_RESOLUTION};
+#ifdef FAN1_DRIVER_EC
+  EcFan _fan1 = EcFan(_fan1Hw, FAN1_S1_PWM_PIN, FAN1_SW_PIN, FAN1_EC_MIN_DUTY);
+#else
   MaicoPPB30 _fan1 = MaicoPPB30(_fan1Hw, FAN1_S1_PWM_PIN, FAN1_S2_PWM_PIN, FAN1_SW_PIN);
+#endif
   
-  RP2040FanHardware _fan2Hw;
+  RP2040FanHardware _fan2Hw{_timerWheel, _pwmAllocator, FAN2_PWM_FREQ_HZ, FAN2_PWM_RESOLUTION};
+#ifdef FAN2_DRIVER_EC
+  EcFan _fan2 = EcFan(_fan2Hw, FAN2_S1_PWM_PIN, FAN2_SW_PIN, FAN2_EC_MIN_DUTY);
+#else
   MaicoPPB30 _fan2 = MaicoPPB30(_fan2Hw, FAN2_S1_PWM_PIN, FAN2_S2_PWM_PIN, FAN2_SW_PIN);
+#endif
   
   FanChannel *_channel[FAN_ChannelCount];
+  float _flashGain[FAN_ChannelCount] = {}; // read before setup creates the channels
+  uint8_t _flashGainMode[FAN_ChannelCount] = {}; // Fan::HumiditySensorMode of the gain
+  FanHistory* _flashHistory[FAN_ChannelCount] = {}; // handed to the channels in setup
   uint32_t readRequestDelay = 0;
+  bool _statusLedReady = false;
+  bool _statusLedOn = false;
+  bool _statusLedWritten = false;
+
+#ifdef FAN_TRACE_SIZE
+  uint8_t _traceBuffer[FAN_TRACE_SIZE];
+  FanTraceWriter _trace{_traceBuffer, FAN_TRACE_SIZE};
+#endif
 };
 
 // Wir benutzen das, um in main besser auf das Modul zugreifen zu können
@@ -0,0 +1,81 @@
+#include "FanPhaseSync.h"
+
+void FanPhaseSync::configure(Role role, uint8_t id, uint32_t periodMs, uint32_t nowMs) {
+  _role = role;
+  _id = id;
+  _ownPeriodMs = periodMs ? periodMs : DefaultPeriodMs;
+  _periodMs = _ownPeriodMs;
+  _masterId = 0;
+  _locked = false;
+  _master = false;
+  _lastHeardMs = nowMs;
+}
+
+uint32_t FanPhaseSync::encode(uint8_t id, uint32_t periodMs) {
+  uint32_t period = periodMs / 100;
+  if (period > 0xFFFF)
+    period = 0xFFFF;
+  return static_cast<uint32_t>(id) << 24 | period;
+}
+
+bool FanPhaseSync::receive(uint32_t telegram, uint32_t nowMs) {
+  uint8_t id = telegram >> 24;
+  uint32_t periodMs = (telegram & 0xFFFF) * 100;
+  if (_role == Off || periodMs == 0 || id == _id)
+    return false;
+  if (_master && id > _id)
+    return false; // the other master follows as soon as it hears this one
+  // while two masters hand over, a higher id only counts once the lower one missed a cycle
+  if (_locked && !_master && id > _masterId && nowMs - _lastHeardMs <= cycleMs() + cycleMs() / 4)
+    return false;
+
+  // a candidate with a lower id takes over, its first telegram continues the phase of the sender
+  _master = _role == Candidate && _id < id;
+  _masterId = _master ? _id : id;
+  _periodMs = periodMs;
+  _cycleStartMs = nowMs;
+  _lastHeardMs = nowMs;
+  _locked = true;
+  return true;
+}
+
+bool FanPhaseSync::loop(uint32_t nowMs) {
+  if (_role == Off)
+    return false;
+  if (!_master) {
+    if (_role != Candidate || nowMs - _lastHeardMs < silenceMs())
+      return false;
+    _master = true;
+    _masterId = _id;
+    if (!_locked) {
+      _locked = true;
+      _periodMs = _ownPeriodMs;
+      _cycleStartMs = nowMs;
+      return true;
+    }
+    // the first telegram follows at the next cycle start of the silent master
+    _cycleStartMs = cycleStartMs(nowMs);
+    return false;
+  }
+
+  uint32_t elapsed = nowMs - _cycleStartMs;
+  if (elapsed < cycleMs())
+    return false;
+  // the grid stays on the cycle starts even if loop() runs late
+  _cycleStartMs += elapsed - elapsed % cycleMs();
+  _periodMs = _ownPeriodMs;
+  return true;
+}
+
+uint32_t FanPhaseSync::cycleStartMs(uint32_t nowMs) const {
+  uint32_t elapsed = nowMs - _cycleStartMs;
+  return _cycleStartMs + (elapsed - elapsed % cycleMs());
+}
+
+uint32_t FanPhaseSync::msUntilNextEvent(uint32_t nowMs) const {
+  if (_role == Off || (!_master && _role != Candidate))
+    return UINT32_MAX;
+  uint32_t elapsed = nowMs - (_master ? _cycleStartMs : _lastHeardMs);
+  uint32_t wait = _master ? cycleMs() : silenceMs();
+  return elapsed >= wait ? 0 : wait - elapsed;
+}
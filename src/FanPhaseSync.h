@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Common phase of the heat recovery reversals of several devices.
+ * One device on the bus is the master: it runs a reference cycle of two
+ * reversal periods and sends a phase telegram at every cycle start. The
+ * others restart their reference cycle on reception, the channels lock
+ * their direction timers to it with their own offset. Devices that may
+ * become master take over after SilentCycles cycles without telegram,
+ * staggered by their id, so the lowest id of the remaining candidates wins.
+ * A candidate with a lower id than the sender takes over at once and keeps
+ * the phase of the old master, a master that hears a lower id follows it.
+ *
+ * Telegram (DPT 12.001): bits 31-24 id of the master, bits 23-16 reserved,
+ * bits 15-0 reversal period in 100 ms.
+ */
+class FanPhaseSync {
+public:
+  enum Role : uint8_t {
+    Off = 0,
+    Follower = 1,  // locks to the master, never sends
+    Candidate = 2, // locks to the master, takes over if it goes silent
+  };
+
+  static constexpr uint8_t SilentCycles = 3;           // cycles without telegram until a candidate takes over
+  static constexpr uint32_t StaggerMs = 1000;          // additional wait per id
+  static constexpr uint32_t DefaultPeriodMs = 60000;   // reversal period without parameter
+
+  void configure(Role role, uint8_t id, uint32_t periodMs, uint32_t nowMs);
+  // received phase telegram, true if the reference cycle restarted with it
+  bool receive(uint32_t telegram, uint32_t nowMs);
+  // true if a telegram is due, telegram() holds it, the reference cycle starts at nowMs
+  bool loop(uint32_t nowMs);
+  uint32_t telegram() const { return encode(_id, _periodMs); }
+  uint32_t msUntilNextEvent(uint32_t nowMs) const;
+
+  bool locked() const { return _locked; } // a reference cycle is known
+  bool master() const { return _master; }
+  uint8_t masterId() const { return _masterId; }
+  uint32_t periodMs() const { return _periodMs; }
+  uint32_t cycleStartMs(uint32_t nowMs) const; // start of the running reference cycle
+
+  static uint32_t encode(uint8_t id, uint32_t periodMs);
+
+private:
+  uint32_t cycleMs() const { return 2 * _periodMs; }
+  uint32_t silenceMs() const { return SilentCycles * cycleMs() + _id * StaggerMs; }
+
+  Role _role = Off;
+  uint8_t _id = 0;
+  uint8_t _masterId = 0;
+  bool _locked = false;
+  bool _master = false;
+  uint32_t _ownPeriodMs = DefaultPeriodMs;
+  uint32_t _periodMs = DefaultPeriodMs;
+  uint32_t _cycleStartMs = 0; // a cycle start of the reference, the last telegram or the master's grid
+  uint32_t _lastHeardMs = 0;
+};
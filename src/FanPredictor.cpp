@@ -0,0 +1,117 @@
+#include "FanPredictor.h"
+
+void FanPredictor::start(uint32_t timeMs) {
+  _startMs = timeMs;
+}
+
+void FanPredictor::reset() {
+  _referenceValid = false;
+  _load = 0;
+}
+
+void FanPredictor::addSample(uint32_t timeMs, int32_t humidity, int16_t step, uint32_t timeConstantMs) {
+  if (!_referenceValid || timeMs - _referenceMs > MaxSpanMs) {
+    if (!_referenceValid)
+      _floor = humidity;
+    _referenceMs = timeMs;
+    _referenceHumidity = humidity;
+    _referenceValid = true;
+    return;
+  }
+  uint32_t span = timeMs - _referenceMs;
+  if (span < MinSpanMs)
+    return;
+
+  // lowest humidity seen, it follows a rising level only while the fan is off
+  if (humidity < _floor)
+    _floor = humidity;
+  else if (step == 0)
+    _floor += (humidity - _floor) >> FloorShift;
+
+  // the observed slope is the load minus the exchange of the running step
+  int32_t slope = static_cast<int32_t>(static_cast<int64_t>(humidity - _referenceHumidity) * 3600000 / span);
+  int32_t excess = (humidity + _referenceHumidity) / 2 - _floor;
+  int32_t exchange = timeConstantMs
+                         ? static_cast<int32_t>(static_cast<int64_t>(excess) * step * 3600000 / (StepCount * timeConstantMs))
+                         : 0;
+  _load += (slope + exchange - _load) >> LoadShift;
+  _referenceMs = timeMs;
+  _referenceHumidity = humidity;
+}
+
+int32_t FanPredictor::advance(const Interval& interval, int32_t excess, int16_t step, uint8_t count) {
+  for (uint8_t i = 0; i < count; i++)
+    excess = static_cast<int32_t>((static_cast<int64_t>(excess) * interval.decay[step]) >> 16) + interval.load;
+  return excess;
+}
+
+int16_t FanPredictor::plan(uint32_t timeMs, int32_t humidity, int32_t target, uint32_t deadlineMs,
+                           uint32_t timeConstantMs) const {
+  if (humidity <= target)
+    return 0;
+
+  // the deadline is fixed at the start, close to it the plan aims at the next interval
+  uint32_t elapsed = timeMs - _startMs;
+  uint32_t remainingMs = elapsed < deadlineMs ? deadlineMs - elapsed : 0;
+  if (remainingMs < deadlineMs / Horizon)
+    remainingMs = deadlineMs / Horizon;
+  uint32_t intervalMs = remainingMs / Horizon;
+  if (intervalMs == 0 || timeConstantMs == 0)
+    return StepCount;
+
+  // implicit Euler per interval, stable for intervals longer than the time constant
+  Interval interval;
+  for (int16_t step = 0; step <= StepCount; step++)
+    interval.decay[step] = static_cast<int32_t>((static_cast<int64_t>(StepCount) * timeConstantMs << 16) /
+                                                (static_cast<int64_t>(StepCount) * timeConstantMs +
+                                                 static_cast<int64_t>(step) * intervalMs));
+  interval.load = static_cast<int32_t>(static_cast<int64_t>(_load) * intervalMs / 3600000);
+
+  int32_t excess = humidity - _floor;
+  int32_t targetExcess = target - _floor;
+  if (targetExcess <= 0)
+    return StepCount; // the floor is above the target, only the most air gets close
+
+  // energy in power * intervals, 1/256 interval resolution at the crossing
+  int16_t lowest = -1; // lowest step that reaches the target in time
+  int16_t best = -1;
+  int64_t bestEnergy = 0;
+  for (int16_t step = 0; step <= StepCount; step++) {
+    int32_t previous = excess;
+    for (uint8_t k = 0; k < Horizon; k++) {
+      int32_t next = advance(interval, previous, step, 1);
+      if (next <= targetExcess) {
+        int64_t intervals = (static_cast<int64_t>(k) << 8) +
+                            (static_cast<int64_t>(previous - targetExcess) << 8) / (previous - next);
+        int64_t energy = power(step) * intervals;
+        if (best < 0 || energy < bestEnergy) {
+          best = step;
+          bestEnergy = energy;
+        }
+        if (lowest < 0)
+          lowest = step;
+        break;
+      }
+      previous = next;
+    }
+  }
+  if (best < 0)
+    return StepCount; // not reachable in time, ventilate as much as possible
+  if (lowest == 0)
+    return 0; // the room dries in time without the fan
+
+  // a mix of the lowest feasible step with the step below it may be cheaper
+  // than the best single step. The higher part runs first: a plan that
+  // postpones it would be renewed with the same postponement at every sample.
+  int16_t low = lowest - 1;
+  int32_t lowExcess = excess;
+  for (uint8_t lowIntervals = 1; lowIntervals < Horizon && best != lowest; lowIntervals++) {
+    lowExcess = advance(interval, lowExcess, low, 1);
+    if (advance(interval, lowExcess, lowest, Horizon - lowIntervals) > targetExcess)
+      break;
+    int64_t mixEnergy = (static_cast<int64_t>(power(low)) * lowIntervals + power(lowest) * (Horizon - lowIntervals)) << 8;
+    if (mixEnergy < bestEnergy)
+      return lowest;
+  }
+  return best;
+}
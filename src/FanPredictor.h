@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Energy-optimal step planning of the predictive control mode.
+ * The inside humidity is modelled per channel as a first order room: the fan
+ * exchanges the excess over a floor humidity with a time constant that is
+ * a parameter at the highest step and grows inversely with the step, a
+ * moisture load adds to it. Floor and load are estimated from the samples.
+ * Fan power grows with the cube of the step and the exchange only linearly,
+ * so the planner compares runs at one step and mixes of the lowest step that
+ * meets the deadline with the step below it. Each candidate is simulated over
+ * the remaining time split into Horizon intervals, the cheapest one that
+ * brings the humidity down to the target in time wins. Everything is integer
+ * arithmetic in 0.01 %RH, a plan costs at most (StepCount + 1 + Horizon) *
+ * Horizon interval updates.
+ */
+class FanPredictor {
+public:
+  static constexpr int16_t StepCount = 5;            // steps of the plan, same as Fan::StepCount
+  static constexpr uint8_t Horizon = 16;             // intervals the remaining time is split into
+  static constexpr uint32_t MinSpanMs = 60000;       // slope is evaluated over at least this span
+  static constexpr uint32_t MaxSpanMs = 30 * 60000;  // older references are dropped without estimate
+  static constexpr uint8_t LoadShift = 2;            // load follows the observations with 1/4
+  static constexpr uint8_t FloorShift = 9;           // floor rises with 1/512 per observation without fan
+
+  void start(uint32_t timeMs); // automatic ventilation starts, the deadline runs from here
+  void reset();
+
+  // humidity in 0.01 %RH, step that ran since the last sample
+  void addSample(uint32_t timeMs, int32_t humidity, int16_t step, uint32_t timeConstantMs);
+  // timeConstantMs is the time constant of the excess at the highest step, returns the step to run now
+  int16_t plan(uint32_t timeMs, int32_t humidity, int32_t target, uint32_t deadlineMs,
+               uint32_t timeConstantMs) const;
+
+  int32_t load() const { return _load; }   // moisture load in 0.01 %RH per hour
+  int32_t floorHumidity() const { return _floor; } // humidity the ventilation leads to, 0.01 %RH
+
+  static int32_t power(int16_t step) { return step * step * step; } // relative fan power
+
+private:
+  struct Interval {
+    int32_t decay[StepCount + 1]; // remaining excess after one interval, 1/65536
+    int32_t load;                 // moisture added per interval
+  };
+
+  // excess after the given intervals at step, from excess
+  static int32_t advance(const Interval& interval, int32_t excess, int16_t step, uint8_t count);
+
+  uint32_t _startMs = 0;
+  uint32_t _referenceMs = 0;
+  int32_t _referenceHumidity = 0;
+  bool _referenceValid = false;
+  int32_t _floor = 0;
+  int32_t _load = 0;
+};
@@ -0,0 +1,56 @@
+#include "FanPwmAllocator.h"
+
+FanPwmAllocator::FanPwmAllocator(uint32_t sysClockHz)
+    : _sysClockHz(sysClockHz) {
+}
+
+FanPwmAllocator::Result FanPwmAllocator::claimPwm(uint8_t pin, uint32_t frequencyHz, uint8_t resolutionBits) {
+  if (pin >= PinCount)
+    return fail(InvalidPin, pin);
+  if (_pinsUsed & (1UL << pin))
+    return fail(PinInUse, pin);
+  if (resolutionBits < MinResolutionBits || resolutionBits > MaxResolutionBits)
+    return fail(InvalidResolution, pin);
+
+  // divider in 1/16 steps: f = sysclk / (div * 2^bits)
+  uint64_t counts = (uint64_t)frequencyHz << resolutionBits;
+  if (counts == 0)
+    return fail(UnreachableFrequency, pin);
+  uint64_t div16 = ((uint64_t)_sysClockHz * 16 + counts / 2) / counts;
+  if (div16 < 16 || div16 > 0xFFF)
+    return fail(UnreachableFrequency, pin);
+
+  SliceConfig& slice = _slices[sliceOf(pin)];
+  uint8_t channel = 1 << channelOf(pin);
+  if (slice.channels) {
+    // GPIO n and n + 16 share a channel, both would show the same duty
+    if ((slice.channels & channel) || slice.frequencyHz != frequencyHz || slice.resolutionBits != resolutionBits)
+      return fail(SliceConflict, pin);
+  } else {
+    slice.frequencyHz = frequencyHz;
+    slice.resolutionBits = resolutionBits;
+    slice.wrap = (1 << resolutionBits) - 1;
+    slice.divInt = div16 >> 4;
+    slice.divFrac = div16 & 0x0F;
+  }
+  slice.channels |= channel;
+  _pinsUsed |= 1UL << pin;
+  return Ok;
+}
+
+FanPwmAllocator::Result FanPwmAllocator::claimDigital(uint8_t pin) {
+  if (pin >= PinCount)
+    return fail(InvalidPin, pin);
+  if (_pinsUsed & (1UL << pin))
+    return fail(PinInUse, pin);
+  _pinsUsed |= 1UL << pin;
+  return Ok;
+}
+
+FanPwmAllocator::Result FanPwmAllocator::fail(Result result, uint8_t pin) {
+  if (_firstError == Ok) {
+    _firstError = result;
+    _errorPin = pin;
+  }
+  return result;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Assigns the RP2040 PWM slices and output pins to the fans of the module.
+ * GPIO n is driven by slice (n / 2) % 8, channel n % 2. Both channels of a
+ * slice share counter and divider, so pins on one slice must use the same
+ * frequency and resolution. Conflicting claims are refused at startup and
+ * the first one is kept for diagnostics, the hardware layer then leaves the
+ * affected outputs alone. The allocator only computes the slice setup, the
+ * registers are written by the hardware implementation.
+ */
+class FanPwmAllocator {
+public:
+  static constexpr uint8_t PinCount = 30; // GPIO 0-29
+  static constexpr uint8_t SliceCount = 8;
+  static constexpr uint8_t MinResolutionBits = 4;
+  static constexpr uint8_t MaxResolutionBits = 14; // 100 % duty = 2^bits has to fit into int16_t
+  static constexpr uint32_t DefaultSysClockHz = 125000000;
+
+  enum Result : uint8_t {
+    Ok = 0,
+    InvalidPin,
+    PinInUse,
+    SliceConflict, // other frequency/resolution or same channel on this slice
+    InvalidResolution,
+    UnreachableFrequency, // divider outside 1.0 - 255.9375
+  };
+
+  struct SliceConfig {
+    uint32_t frequencyHz;
+    uint16_t wrap;    // counter top, resolution 2^bits = wrap + 1
+    uint8_t divInt;   // clock divider, integer part
+    uint8_t divFrac;  // clock divider, 1/16 units
+    uint8_t resolutionBits;
+    uint8_t channels; // bit per claimed channel A/B, 0 = slice unused
+  };
+
+  FanPwmAllocator(uint32_t sysClockHz = DefaultSysClockHz);
+
+  Result claimPwm(uint8_t pin, uint32_t frequencyHz, uint8_t resolutionBits);
+  Result claimDigital(uint8_t pin);
+
+  static uint8_t sliceOf(uint8_t pin) { return (pin >> 1) & (SliceCount - 1); }
+  static uint8_t channelOf(uint8_t pin) { return pin & 1; }
+  const SliceConfig& slice(uint8_t index) const { return _slices[index]; }
+
+  Result firstError() const { return _firstError; }
+  uint8_t errorPin() const { return _errorPin; }
+
+private:
+  Result fail(Result result, uint8_t pin);
+
+  uint32_t _sysClockHz;
+  uint32_t _pinsUsed = 0;
+  SliceConfig _slices[SliceCount] = {};
+  Result _firstError = Ok;
+  uint8_t _errorPin = 0;
+};
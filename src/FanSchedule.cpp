@@ -0,0 +1,121 @@
+#include "FanSchedule.h"
+
+void FanSchedule::clear() {
+  _count = 0;
+  _synced = false;
+  _appliedSpeed = -1;
+}
+
+bool FanSchedule::addSwitchPoint(uint8_t daySelection, uint8_t hour, uint8_t minute, int16_t speed) {
+  if (daySelection == Inactive || daySelection > Daily || hour > 23 || minute > 59)
+    return false;
+
+  uint8_t firstDay = daySelection;
+  uint8_t lastDay = daySelection;
+  if (daySelection == Weekdays) {
+    firstDay = Monday;
+    lastDay = 5;
+  } else if (daySelection == Weekend) {
+    firstDay = 6;
+    lastDay = Sunday;
+  } else if (daySelection == Daily) {
+    firstDay = Monday;
+    lastDay = Sunday;
+  }
+
+  if (_count + (lastDay - firstDay + 1) > MaxEntries)
+    return false;
+
+  for (uint8_t day = firstDay; day <= lastDay; day++) {
+    insertEntry((day - 1) * 1440 + hour * 60 + minute, speed);
+  }
+  _synced = false; // table changed, next clock telegram re-arms the deadline
+  return true;
+}
+
+void FanSchedule::insertEntry(uint16_t minuteOfWeek, int8_t speed) {
+  // keep table sorted, a later switch point at the same minute wins
+  uint8_t pos = _count;
+  while (pos > 0 && _entries[pos - 1].minuteOfWeek > minuteOfWeek)
+    pos--;
+  if (pos > 0 && _entries[pos - 1].minuteOfWeek == minuteOfWeek) {
+    _entries[pos - 1].speed = speed;
+    return;
+  }
+  for (uint8_t i = _count; i > pos; i--)
+    _entries[i] = _entries[i - 1];
+  _entries[pos].minuteOfWeek = minuteOfWeek;
+  _entries[pos].speed = speed;
+  _count++;
+}
+
+void FanSchedule::setClock(uint8_t weekday, uint8_t hour, uint8_t minute, uint8_t second, uint32_t nowMs) {
+  // DPT 10.001 without day of week (0) cannot be placed in the week
+  if (_count == 0 || weekday < Monday || weekday > Sunday || hour > 23 || minute > 59 || second > 59)
+    return;
+
+  uint16_t now = (weekday - 1) * 1440 + hour * 60 + minute;
+
+  // binary search for the first switch point after now
+  uint8_t lo = 0;
+  uint8_t hi = _count;
+  while (lo < hi) {
+    uint8_t mid = (lo + hi) / 2;
+    if (_entries[mid].minuteOfWeek <= now)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  _nextIndex = lo % _count;
+  _activeIndex = (lo + _count - 1) % _count;
+
+  uint32_t minutes = (_entries[_nextIndex].minuteOfWeek + MinutesPerWeek - now) % MinutesPerWeek;
+  if (minutes == 0)
+    minutes = MinutesPerWeek;
+  _deadlineMs = nowMs + minutes * 60000 - second * 1000;
+
+  bool wasSynced = _synced;
+  _synced = true;
+  applyActive(!wasSynced);
+}
+
+void FanSchedule::loop(uint32_t nowMs) {
+  if (!_synced || (int32_t)(nowMs - _deadlineMs) < 0)
+    return;
+
+  _activeIndex = _nextIndex;
+  _nextIndex = (_nextIndex + 1) % _count;
+  _deadlineMs += minutesToNext(_activeIndex) * 60000;
+  applyActive(false);
+}
+
+uint32_t FanSchedule::minutesToNext(uint8_t fromIndex) const {
+  uint8_t next = (fromIndex + 1) % _count;
+  uint32_t minutes = (_entries[next].minuteOfWeek + MinutesPerWeek - _entries[fromIndex].minuteOfWeek) % MinutesPerWeek;
+  return minutes == 0 ? MinutesPerWeek : minutes;
+}
+
+void FanSchedule::applyActive(bool force) {
+  int16_t speed = _entries[_activeIndex].speed;
+  if (!force && speed == _appliedSpeed)
+    return;
+  _appliedSpeed = speed;
+  if (_switchCallback) {
+    _switchCallback(speed);
+  }
+}
+
+void FanSchedule::setSwitchCallback(std::function<void(int16_t)> callback) {
+  _switchCallback = callback;
+}
+
+int16_t FanSchedule::activeSpeed() const {
+  return _synced ? _entries[_activeIndex].speed : -1;
+}
+
+uint32_t FanSchedule::msUntilNextSwitch(uint32_t nowMs) const {
+  if (!_synced)
+    return 0;
+  int32_t remaining = (int32_t)(_deadlineMs - nowMs);
+  return remaining > 0 ? remaining : 0;
+}
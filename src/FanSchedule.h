@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+
+/**
+ * @brief Weekly time program of a fan channel.
+ * Switch points are expanded to a compact table sorted by minute of the week.
+ * On every clock sync the active entry is located once and a single deadline
+ * for the next switch point is armed, loop() only compares against it.
+ */
+class FanSchedule {
+public:
+  enum DaySelection {
+    Inactive = 0,
+    Monday = 1, // 1..7 = single weekday as in DPT 10.001
+    Sunday = 7,
+    Weekdays = 8,
+    Weekend = 9,
+    Daily = 10,
+  };
+
+  struct Entry {
+    uint16_t minuteOfWeek; // 0 = Monday 00:00
+    int8_t speed;
+  };
+
+  static constexpr uint8_t MaxSwitchPoints = 8;
+  static constexpr uint8_t MaxEntries = MaxSwitchPoints * 7;
+  static constexpr uint16_t MinutesPerWeek = 7 * 24 * 60;
+
+  void clear();
+  bool addSwitchPoint(uint8_t daySelection, uint8_t hour, uint8_t minute, int16_t speed);
+  void setClock(uint8_t weekday, uint8_t hour, uint8_t minute, uint8_t second, uint32_t nowMs);
+  void loop(uint32_t nowMs);
+  void setSwitchCallback(std::function<void(int16_t)> callback);
+
+  uint8_t size() const { return _count; }
+  const Entry& entry(uint8_t index) const { return _entries[index]; }
+  bool isSynced() const { return _synced; }
+  int16_t activeSpeed() const;
+  uint32_t msUntilNextSwitch(uint32_t nowMs) const;
+
+private:
+  void insertEntry(uint16_t minuteOfWeek, int8_t speed);
+  uint32_t minutesToNext(uint8_t fromIndex) const;
+  void applyActive(bool force);
+
+  Entry _entries[MaxEntries];
+  uint8_t _count = 0;
+  uint8_t _activeIndex = 0;
+  uint8_t _nextIndex = 0;
+  bool _synced = false;
+  int16_t _appliedSpeed = -1;
+  uint32_t _deadlineMs = 0;
+
+  std::function<void(int16_t)> _switchCallback;
+};
@@ -0,0 +1,41 @@
+#include "FanShadow.h"
+#include <stdlib.h>
+
+FanShadow::FanShadow(uint32_t (*clock)())
+    : _hw(clock), _fan(_hw) {
+  _sinceMs = _hw.getMillis();
+  _fan.setSpeedChangeCallback([this](int16_t speed) {
+    accumulate(); // the interval up to now still ran with the old step
+    _shadowStep = speed;
+    if (_stepChangeCallback)
+      _stepChangeCallback(speed);
+  });
+}
+
+void FanShadow::setLive(int16_t step, bool compared) {
+  if (step == _liveStep && compared == _compared)
+    return;
+  accumulate();
+  _liveStep = step;
+  _compared = compared;
+}
+
+void FanShadow::accumulate() {
+  uint32_t now = _hw.getMillis();
+  uint32_t elapsed = now - _sinceMs;
+  _sinceMs = now;
+  if (!diverging())
+    return;
+  _divergentMs += elapsed;
+  _stepMs += static_cast<uint64_t>(elapsed) * abs(_liveStep - _shadowStep);
+}
+
+uint32_t FanShadow::divergentMinutes() {
+  accumulate();
+  return _divergentMs / 60000;
+}
+
+uint32_t FanShadow::stepMinutes() {
+  accumulate();
+  return _stepMs / 60000;
+}
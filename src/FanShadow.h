@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+#include "Fan.h"
+#include "IFanHardware.h"
+
+/**
+ * @brief Dry-run controller beside the live fan of a channel.
+ * A second Fan logic in automatic mode gets the same sensor values with its
+ * own control parameters. Its hardware is silent: no pins, no timers, only
+ * the clock, so it never touches the outputs or the timers of the live fan.
+ * Manual and timer stay with the live fan, the schedule switch points go to
+ * both, so the shadow weighs its automatic request against the same schedule
+ * level. The divergence is integrated between the step changes of both:
+ * the time with different steps and the step difference over time, paused
+ * while the live fan follows a source the shadow does not know.
+ */
+class FanShadow {
+public:
+  explicit FanShadow(uint32_t (*clock)());
+
+  Fan& fan() { return _fan; } // parameters and sensor values of the shadow
+  int16_t step() const { return _shadowStep; }
+  // step of the live fan, compared = false pauses the statistics, e.g. during a manual override
+  void setLive(int16_t step, bool compared);
+  void setStepChangeCallback(std::function<void(int16_t)> callback) { _stepChangeCallback = callback; }
+
+  // totals up to now, the running interval included
+  uint32_t divergentMinutes();
+  uint32_t stepMinutes(); // sum of the step difference times minutes
+  bool diverging() const { return _compared && _liveStep != _shadowStep; }
+
+private:
+  class SilentHardware : public IFanHardware {
+  public:
+    explicit SilentHardware(uint32_t (*clock)()) : _clock(clock) {}
+    void init(uint8_t, uint8_t, uint8_t) override {}
+    void setPWM(uint8_t, int16_t) override {}
+    void setDigital(uint8_t, bool) override {}
+    void startDirectionTimer(uint32_t, std::function<void()>) override {}
+    void stopDirectionTimer() override {}
+    void startOneShotTimer(uint64_t, std::function<void()>) override {}
+    void stopOneShotTimer() override {}
+    void startOverrideTimer(uint64_t, std::function<void()>) override {}
+    void stopOverrideTimer() override {}
+    uint32_t getMillis() override { return _clock(); }
+
+  private:
+    uint32_t (*_clock)();
+  };
+
+  // speeds are steps, the shadow reports what a stepped fan would run
+  class ShadowFan : public Fan {
+  public:
+    explicit ShadowFan(IFanHardware& hw) : Fan(hw) {}
+    int16_t getFanSpeed() override { return _speed; }
+
+  protected:
+    void changeFanSpeedDelegate(int16_t fanSpeed) override { _speed = fanSpeed; }
+    void updateMode() override {}
+
+  private:
+    int16_t _speed = 0;
+  };
+
+  void accumulate(); // adds the interval since the last change
+
+  SilentHardware _hw;
+  ShadowFan _fan;
+  std::function<void(int16_t)> _stepChangeCallback;
+  int16_t _liveStep = 0;
+  int16_t _shadowStep = 0;
+  bool _compared = true;
+  uint32_t _sinceMs = 0;
+  uint64_t _divergentMs = 0;
+  uint64_t _stepMs = 0;
+};
@@ -0,0 +1,45 @@
+#include "FanSpeedCurve.h"
+
+void FanSpeedCurve::clear() {
+  _count = 0;
+}
+
+void FanSpeedCurve::addPoint(uint8_t value, uint8_t hysteresis, int16_t step) {
+  if (_count == MaxPoints)
+    return;
+  // kept sorted by value
+  uint8_t i = _count++;
+  for (; i > 0 && _points[i - 1].value > value; i--)
+    _points[i] = _points[i - 1];
+  _points[i] = Point{value, hysteresis, step};
+}
+
+int16_t FanSpeedCurve::evaluate(int32_t input, bool falling, int16_t maxSpeed, bool linear) const {
+  int32_t previous = 0;
+  int16_t previousStep = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    int32_t position = (_points[i].value - (falling ? _points[i].hysteresis : 0)) * 100;
+    if (position < previous)
+      position = previous; // a larger hysteresis must not move a breakpoint below the one before
+    if (input < position) {
+      if (!linear || i == 0 || position == previous)
+        break;
+      // speed * StepCount, rounded like Fan::stepToSpeed()
+      int32_t span = position - previous;
+      int32_t scaled = (previousStep * span + (_points[i].step - previousStep) * (input - previous)) * maxSpeed;
+      return (scaled + span * StepCount / 2) / (span * StepCount);
+    }
+    previous = position;
+    previousStep = _points[i].step;
+  }
+  return (previousStep * maxSpeed + StepCount / 2) / StepCount;
+}
+
+void FanSpeedCurve::compile(int16_t maxSpeed, bool linear) {
+  for (uint16_t i = 0; i < TableSize; i++) {
+    int32_t input = i * Quantum;
+    int16_t up = evaluate(input, false, maxSpeed, linear);
+    int16_t down = evaluate(input, true, maxSpeed, linear);
+    _table[i] = Entry{static_cast<int8_t>(up), static_cast<int8_t>(down > up ? down : up)};
+  }
+}
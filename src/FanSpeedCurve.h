@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Speed curve of the automatic mode from up to MaxPoints breakpoints.
+ * A breakpoint gives the step from an input value on, the input is the
+ * inside humidity in %RH or the dew point difference inside - outside in K.
+ * Between breakpoints the curve holds the step or, linear, interpolates in
+ * the speed range of the driver. Falling, a breakpoint is left only its
+ * hysteresis below its value. compile() evaluates both curves once per
+ * Quantum of the input, at runtime the speed is a single table lookup. The
+ * breakpoints are whole units, so a Quantum of 1 only rounds the linear part.
+ */
+class FanSpeedCurve {
+public:
+  static constexpr uint8_t MaxPoints = 4;
+  static constexpr int16_t StepCount = 5;    // steps of the breakpoints, same as Fan::StepCount
+  static constexpr int32_t Quantum = 100;    // input per table entry in 0.01 units (1 %RH or K)
+  static constexpr uint16_t TableSize = 101; // inputs from 0 to 100, above uses the last entry
+
+  void clear();
+  // value and hysteresis in whole %RH or K, points may come in any order
+  void addPoint(uint8_t value, uint8_t hysteresis, int16_t step);
+  uint8_t size() const { return _count; }
+  void compile(int16_t maxSpeed, bool linear); // maxSpeed of the driver, at most 127
+
+  // speed for the input in 0.01 units, current is the running speed for the hysteresis
+  int16_t speed(int32_t input, int16_t current) const {
+    const Entry& entry = _table[input <= 0 ? 0 : (input / Quantum < TableSize ? input / Quantum : TableSize - 1)];
+    return current < entry.up ? entry.up : (current > entry.down ? entry.down : current);
+  }
+
+private:
+  struct Point {
+    uint8_t value;
+    uint8_t hysteresis;
+    int16_t step;
+  };
+  struct Entry {
+    int8_t up;   // rising curve
+    int8_t down; // falling curve, at least up
+  };
+
+  int16_t evaluate(int32_t input, bool falling, int16_t maxSpeed, bool linear) const;
+
+  Point _points[MaxPoints];
+  uint8_t _count = 0;
+  Entry _table[TableSize] = {};
+};
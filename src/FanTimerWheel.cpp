@@ -0,0 +1,158 @@
+#include "FanTimerWheel.h"
+
+FanTimer::~FanTimer() {
+  if (_wheel)
+    _wheel->cancel(*this);
+}
+
+FanTimerWheel::FanTimerWheel(uint64_t nowMs)
+    : _now(nowMs), _next(nowMs + 1) {
+}
+
+FanTimerWheel::~FanTimerWheel() {
+  for (uint8_t level = 0; level < Levels; level++) {
+    for (uint8_t slot = 0; slot < Slots; slot++) {
+      while (_slots[level][slot])
+        unlink(*_slots[level][slot]);
+    }
+  }
+}
+
+void FanTimerWheel::arm(FanTimer& timer, uint64_t delayMs, std::function<void()> callback, uint32_t periodMs) {
+  if (timer._wheel)
+    timer._wheel->unlink(timer);
+  timer._callback = callback;
+  timer._periodMs = periodMs;
+  // saturate instead of wrapping for "practically never" delays
+  timer._deadlineMs = delayMs > UINT64_MAX - _now ? UINT64_MAX : _now + delayMs;
+  insert(timer);
+}
+
+void FanTimerWheel::cancel(FanTimer& timer) {
+  if (timer._wheel == this)
+    unlink(timer);
+}
+
+void FanTimerWheel::insert(FanTimer& timer) {
+  uint64_t expires = timer._deadlineMs < _next ? _next : timer._deadlineMs;
+  uint64_t ticks = expires - _next;
+
+  uint8_t level = 0;
+  while (level < Levels - 1 && ticks >= (1ULL << (SlotBits * (level + 1))))
+    level++;
+  if (ticks >= (1ULL << (SlotBits * Levels))) {
+    // beyond the wheel range: park in the furthest top level slot, cascading re-sorts it
+    expires = _next + (1ULL << (SlotBits * Levels)) - 1;
+  }
+
+  uint8_t slot = (expires >> (SlotBits * level)) & (Slots - 1);
+  timer._level = level;
+  timer._slot = slot;
+  timer._prev = nullptr;
+  timer._next = _slots[level][slot];
+  if (timer._next)
+    timer._next->_prev = &timer;
+  _slots[level][slot] = &timer;
+  _occupied[level] |= 1ULL << slot;
+  timer._wheel = this;
+  _armedCount++;
+}
+
+void FanTimerWheel::unlink(FanTimer& timer) {
+  if (timer._prev)
+    timer._prev->_next = timer._next;
+  else
+    _slots[timer._level][timer._slot] = timer._next;
+  if (timer._next)
+    timer._next->_prev = timer._prev;
+  if (!_slots[timer._level][timer._slot])
+    _occupied[timer._level] &= ~(1ULL << timer._slot);
+  timer._prev = nullptr;
+  timer._next = nullptr;
+  timer._wheel = nullptr;
+  _armedCount--;
+}
+
+uint8_t FanTimerWheel::cascade(uint8_t level) {
+  uint8_t slot = (_next >> (SlotBits * level)) & (Slots - 1);
+  FanTimer* timer = _slots[level][slot];
+  _slots[level][slot] = nullptr;
+  _occupied[level] &= ~(1ULL << slot);
+  while (timer) {
+    FanTimer* next = timer->_next;
+    _armedCount--;
+    insert(*timer);
+    timer = next;
+  }
+  return slot;
+}
+
+void FanTimerWheel::advance(uint64_t nowMs) {
+  while (_next <= nowMs) {
+    if (_armedCount == 0) {
+      _next = nowMs + 1;
+      break;
+    }
+
+    // jump over ticks where nothing fires or cascades
+    uint64_t work = nextWorkTick();
+    if (work > _next) {
+      _next = work > nowMs ? nowMs + 1 : work;
+      continue;
+    }
+
+    uint8_t slot = _next & (Slots - 1);
+    if (slot == 0) {
+      for (uint8_t level = 1; level < Levels; level++) {
+        if (cascade(level) != 0)
+          break;
+      }
+    }
+
+    _now = _next;
+    while (_slots[0][slot])
+      fire(*_slots[0][slot]);
+    _next++;
+  }
+  _now = nowMs;
+}
+
+// bit of slot "first" moves to position 0
+static inline uint64_t rotate(uint64_t occupied, uint8_t first) {
+  return first ? (occupied >> first) | (occupied << (FanTimerWheel::Slots - first)) : occupied;
+}
+
+uint64_t FanTimerWheel::nextWorkTick() const {
+  uint64_t result = UINT64_MAX;
+  // level 0 holds the next 64 ticks, one slot per tick
+  uint8_t slot = _next & (Slots - 1);
+  if (_occupied[0])
+    result = _next + __builtin_ctzll(rotate(_occupied[0], slot));
+
+  for (uint8_t level = 1; level < Levels; level++) {
+    if (!_occupied[level])
+      continue;
+    // first cascade boundary not processed yet and the bucket it cascades
+    uint8_t shift = SlotBits * level;
+    uint64_t boundary = ((_next + (1ULL << shift) - 1) >> shift) << shift;
+    uint8_t bucket = (boundary >> shift) & (Slots - 1);
+    uint64_t tick = boundary + ((uint64_t)__builtin_ctzll(rotate(_occupied[level], bucket)) << shift);
+    if (tick < result)
+      result = tick;
+  }
+  return result;
+}
+
+void FanTimerWheel::fire(FanTimer& timer) {
+  unlink(timer);
+  if (timer._periodMs) {
+    timer._deadlineMs += timer._periodMs;
+    if (timer._deadlineMs <= _now)
+      timer._deadlineMs = _now + timer._periodMs; // do not catch up missed periods
+    insert(timer);
+  }
+  // copy, the callback may re-arm the timer and replace its callback
+  std::function<void()> callback = timer._callback;
+  if (callback)
+    callback();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+
+class FanTimerWheel;
+
+/**
+ * @brief Software timer handled by a FanTimerWheel.
+ * The owner keeps the object alive while it is armed, the wheel only links it.
+ */
+class FanTimer {
+public:
+  FanTimer() = default;
+  ~FanTimer();
+  FanTimer(const FanTimer&) = delete;
+  FanTimer& operator=(const FanTimer&) = delete;
+
+  bool isArmed() const { return _wheel != nullptr; }
+  uint64_t deadlineMs() const { return _deadlineMs; }
+
+private:
+  friend class FanTimerWheel;
+
+  FanTimerWheel* _wheel = nullptr;
+  FanTimer* _prev = nullptr;
+  FanTimer* _next = nullptr;
+  uint64_t _deadlineMs = 0;
+  uint32_t _periodMs = 0; // 0 = one-shot
+  uint8_t _level = 0;
+  uint8_t _slot = 0;
+  std::function<void()> _callback;
+};
+
+/**
+ * @brief Hierarchical timer wheel multiplexing all fan timers of the module.
+ * Five levels of 64 slots with 1 ms resolution cover about 12 days directly,
+ * later deadlines are parked in the top level and re-sorted on cascade.
+ * Arming and cancelling are O(1). The wheel has no clock of its own, it is
+ * advanced from the loop tick (or a single hardware alarm) on the device and
+ * from virtual time in the native tests.
+ */
+class FanTimerWheel {
+public:
+  static constexpr uint8_t Levels = 5;
+  static constexpr uint8_t SlotBits = 6;
+  static constexpr uint8_t Slots = 1 << SlotBits;
+
+  FanTimerWheel(uint64_t nowMs = 0);
+  ~FanTimerWheel();
+
+  void arm(FanTimer& timer, uint64_t delayMs, std::function<void()> callback, uint32_t periodMs = 0);
+  void cancel(FanTimer& timer);
+  void advance(uint64_t nowMs);
+
+  uint64_t now() const { return _now; }
+  // first tick advance() has work for, a firing or a cascade, UINT64_MAX without timers
+  uint64_t nextDeadlineMs() const { return _armedCount ? nextWorkTick() : UINT64_MAX; }
+  uint16_t armedCount() const { return _armedCount; }
+
+private:
+  void insert(FanTimer& timer);
+  void unlink(FanTimer& timer);
+  uint8_t cascade(uint8_t level);
+  uint64_t nextWorkTick() const;
+  void fire(FanTimer& timer);
+
+  FanTimer* _slots[Levels][Slots] = {};
+  uint64_t _occupied[Levels] = {}; // bit per non-empty slot
+  uint64_t _now;                   // current time seen by callbacks and arm()
+  uint64_t _next;                  // next tick to be processed
+  uint16_t _armedCount = 0;
+};
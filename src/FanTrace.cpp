@@ -0,0 +1,107 @@
+#include "FanTrace.h"
+#include <string.h>
+
+FanTraceWriter::FanTraceWriter(uint8_t* buffer, size_t capacity)
+    : _buffer(buffer), _capacity(capacity) {
+}
+
+bool FanTraceWriter::begin(const uint8_t* params, uint16_t paramSize, uint32_t startMs) {
+  _size = 0;
+  _lastTimeMs = startMs;
+  _overflow = false;
+  if ((size_t)FanTrace::HeaderSize + paramSize > _capacity) {
+    _overflow = true;
+    return false;
+  }
+
+  memcpy(_buffer, FanTrace::Magic, sizeof(FanTrace::Magic));
+  _buffer[4] = FanTrace::Version;
+  _buffer[5] = paramSize & 0xFF;
+  _buffer[6] = paramSize >> 8;
+  memcpy(_buffer + FanTrace::HeaderSize, params, paramSize);
+  _size = FanTrace::HeaderSize + paramSize;
+  return true;
+}
+
+bool FanTraceWriter::record(uint32_t timeMs, uint16_t asap, const uint8_t* data, uint8_t size) {
+  if (_overflow || _size == 0 || size > FanTrace::MaxPayload)
+    return false;
+
+  size_t start = _size;
+  if (!putVarint(timeMs - _lastTimeMs) || !putVarint(asap) || !put(size) ||
+      _size + size > _capacity) {
+    // drop the partial record, keep the trace readable
+    _size = start;
+    _overflow = true;
+    return false;
+  }
+  memcpy(_buffer + _size, data, size);
+  _size += size;
+  _lastTimeMs = timeMs;
+  return true;
+}
+
+bool FanTraceWriter::put(uint8_t value) {
+  if (_size >= _capacity)
+    return false;
+  _buffer[_size++] = value;
+  return true;
+}
+
+bool FanTraceWriter::putVarint(uint32_t value) {
+  while (value >= 0x80) {
+    if (!put((value & 0x7F) | 0x80))
+      return false;
+    value >>= 7;
+  }
+  return put(value);
+}
+
+FanTraceReader::FanTraceReader(const uint8_t* data, size_t size)
+    : _data(data), _size(size) {
+  if (size < FanTrace::HeaderSize || memcmp(data, FanTrace::Magic, sizeof(FanTrace::Magic)) != 0 ||
+      data[4] != FanTrace::Version)
+    return;
+  _paramSize = data[5] | (data[6] << 8);
+  _valid = (size_t)FanTrace::HeaderSize + _paramSize <= size;
+  rewind();
+}
+
+void FanTraceReader::rewind() {
+  _pos = FanTrace::HeaderSize + _paramSize;
+  _timeMs = 0;
+}
+
+bool FanTraceReader::next(FanTrace::Record& record) {
+  if (!_valid)
+    return false;
+
+  uint32_t delta;
+  uint32_t asap;
+  if (!getVarint(delta) || !getVarint(asap) || _pos >= _size)
+    return false;
+  uint8_t size = _data[_pos++];
+  if (size > FanTrace::MaxPayload || _pos + size > _size)
+    return false;
+
+  _timeMs += delta;
+  record.timeMs = _timeMs;
+  record.asap = asap;
+  record.size = size;
+  record.data = _data + _pos;
+  _pos += size;
+  return true;
+}
+
+bool FanTraceReader::getVarint(uint32_t& value) {
+  value = 0;
+  for (uint8_t shift = 0; shift < 35; shift += 7) {
+    if (_pos >= _size)
+      return false;
+    uint8_t byte = _data[_pos++];
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Compact binary trace of received group telegrams.
+ * The header holds a snapshot of the parameter memory, so a replay starts
+ * with the configuration of the recording device. Each record is
+ *   varint time delta [ms], varint KO number, payload size, payload
+ * which is 5-6 bytes for typical DPT 1/5/9 telegrams.
+ */
+namespace FanTrace {
+  static constexpr uint8_t Magic[4] = {'F', 'T', 'R', 'C'};
+  static constexpr uint8_t Version = 1;
+  static constexpr uint8_t HeaderSize = 7; // magic, version, parameter size
+  static constexpr uint8_t MaxPayload = 14;
+
+  struct Record {
+    uint32_t timeMs; // since begin() of the recording
+    uint16_t asap;
+    uint8_t size;
+    const uint8_t* data;
+  };
+}
+
+class FanTraceWriter {
+public:
+  FanTraceWriter(uint8_t* buffer, size_t capacity);
+
+  // record times are stored relative to startMs
+  bool begin(const uint8_t* params, uint16_t paramSize, uint32_t startMs);
+  // false if the buffer is full, the trace then ends with the last complete record
+  bool record(uint32_t timeMs, uint16_t asap, const uint8_t* data, uint8_t size);
+
+  const uint8_t* data() const { return _buffer; }
+  size_t size() const { return _size; }
+  bool overflow() const { return _overflow; }
+
+private:
+  bool put(uint8_t value);
+  bool putVarint(uint32_t value);
+
+  uint8_t* _buffer;
+  size_t _capacity;
+  size_t _size = 0;
+  uint32_t _lastTimeMs = 0;
+  bool _overflow = false;
+};
+
+class FanTraceReader {
+public:
+  FanTraceReader(const uint8_t* data, size_t size);
+
+  bool valid() const { return _valid; }
+  const uint8_t* params() const { return _data + FanTrace::HeaderSize; }
+  uint16_t paramSize() const { return _paramSize; }
+
+  // false at the end of the trace or on a truncated record
+  bool next(FanTrace::Record& record);
+  void rewind();
+
+private:
+  bool getVarint(uint32_t& value);
+
+  const uint8_t* _data;
+  size_t _size;
+  size_t _pos = 0;
+  uint16_t _paramSize = 0;
+  uint32_t _timeMs = 0;
+  bool _valid = false;
+};
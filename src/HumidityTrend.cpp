@@ -0,0 +1,63 @@
+#include "HumidityTrend.h"
+
+static_assert((HumidityTrend::BufferSize - 1) * HumidityTrend::SlotMs > HumidityTrend::WindowMs,
+              "the slots have to cover the slope window at any telegram rate");
+
+bool HumidityTrend::addSample(uint32_t timeMs, EnvValue relHumidity, EnvValue riseRate, EnvValue margin) {
+  if (_count > 0 && timeMs - _slotStartMs < SlotMs) {
+    _samples[(_head + BufferSize - 1) % BufferSize] = {timeMs, relHumidity};
+  } else {
+    _samples[_head] = {timeMs, relHumidity};
+    _head = (_head + 1) % BufferSize;
+    if (_count < BufferSize)
+      _count++;
+    _slotStartMs = timeMs;
+  }
+
+  _slope = calculateSlope();
+
+  if (_boosting) {
+    if (relHumidity <= _baseline + margin)
+      _boosting = false;
+    return false;
+  }
+
+  if (riseRate > EnvValue(0) && _slope >= riseRate) {
+    _baseline = minimum(); // lowest buffered value is the pre-event level
+    _boosting = true;
+    return true;
+  }
+  return false;
+}
+
+EnvValue HumidityTrend::calculateSlope() const {
+  if (_count < 2)
+    return 0;
+
+  const Sample& newest = _samples[(_head + BufferSize - 1) % BufferSize];
+  const Sample* reference = nullptr;
+  for (uint8_t i = 1; i < _count; i++) {
+    const Sample& sample = _samples[(_head + BufferSize - 1 - i) % BufferSize];
+    if (newest.timeMs - sample.timeMs > WindowMs) {
+      // sensor sent nothing within the window, fall back to the last known value
+      if (!reference)
+        reference = &sample;
+      break;
+    }
+    reference = &sample;
+  }
+
+  uint32_t span = newest.timeMs - reference->timeMs;
+  if (span < MinSpanMs)
+    return 0;
+  return (newest.relHumidity - reference->relHumidity).mulDiv(60000, span);
+}
+
+EnvValue HumidityTrend::minimum() const {
+  EnvValue result = _samples[0].relHumidity;
+  for (uint8_t i = 1; i < _count; i++) {
+    if (_samples[i].relHumidity < result)
+      result = _samples[i].relHumidity;
+  }
+  return result;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <stdint.h>
+#include "EnvValue.h"
+
+/**
+ * @brief Rate-of-rise detector for the inside humidity.
+ * Keeps the last samples with timestamps in a small ring buffer and reports
+ * a boost as soon as the slope exceeds the configured rate. The boost ends
+ * once the humidity falls back to the pre-event baseline plus a margin.
+ * The buffer holds one slot per SlotMs with the last sample in it, so it
+ * covers more than WindowMs however often the sensor sends.
+ */
+class HumidityTrend {
+public:
+  static constexpr uint8_t BufferSize = 8;
+  static constexpr uint32_t SlotMs = 30000;       // samples within a slot replace each other
+  static constexpr uint32_t WindowMs = 3 * 60000; // slope is evaluated over this span
+  static constexpr uint32_t MinSpanMs = 60000;    // ignore spikes of single telegrams
+
+  // returns true when a boost was started by this sample
+  bool addSample(uint32_t timeMs, EnvValue relHumidity, EnvValue riseRate, EnvValue margin);
+
+  bool isBoosting() const { return _boosting; }
+  EnvValue baseline() const { return _baseline; }
+  EnvValue slope() const { return _slope; } // %RH per minute
+
+private:
+  struct Sample {
+    uint32_t timeMs;
+    EnvValue relHumidity;
+  };
+
+  EnvValue calculateSlope() const;
+  EnvValue minimum() const;
+
+  Sample _samples[BufferSize];
+  uint8_t _head = 0;
+  uint8_t _count = 0;
+  uint32_t _slotStartMs = 0; // first sample of the newest slot
+  bool _boosting = false;
+  EnvValue _baseline = 0;
+  EnvValue _slope = 0;
+};
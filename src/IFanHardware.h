@@ -9,13 +9,15 @@
  */
 class IFanHardware {
 public:
+    static constexpr uint8_t NoPin = 0xFF; // output not used by the fan
+
     virtual ~IFanHardware() = default;
 
     /**
      * @brief Initialize the hardware pins.
      * 
      * @param s1_pin Pin for S1 PWM
-     * @param s2_pin Pin for S2 PWM
+     * @param s2_pin Pin for S2 PWM, NoPin if unused
      * @param sw_pin Pin for Switch
      */
     virtual void init(uint8_t s1_pin, uint8_t s2_pin, uint8_t sw_pin) = 0;
@@ -24,10 +26,17 @@ public:
      * @brief Set PWM duty cycle for a specific pin.
      * 
      * @param pin The GPIO pin number.
-     * @param value The PWM value (0-1024 typically, depending on resolution).
+     * @param value The PWM value, 0 to getPWMRange() for 0-100 % duty.
      */
     virtual void setPWM(uint8_t pin, int16_t value) = 0;
 
+    /**
+     * @brief Get the PWM value for 100 % duty cycle.
+     * 
+     * @return 2^resolution of the PWM outputs, 1024 unless the hardware says otherwise.
+     */
+    virtual uint16_t getPWMRange() { return 1024; }
+
     /**
      * @brief Set digital output for a specific pin.
      * 
@@ -42,7 +51,7 @@ public:
      * @param intervalMs Interval in milliseconds.
      * @param callback Function to call when timer expires.
      */
-    virtual void startDirectionTimer(long intervalMs, std::function<void()> callback) = 0;
+    virtual void startDirectionTimer(uint32_t intervalMs, std::function<void()> callback) = 0;
 
     /**
      * @brief Stop the repeating direction timer.
@@ -52,13 +61,33 @@ public:
     /**
      * @brief Start a one-shot timer.
      * 
-     * @param delayMs Delay in milliseconds.
+     * @param delayMs Delay in milliseconds, 64 bit to allow long run times.
      * @param callback Function to call when timer expires.
      */
-    virtual void startOneShotTimer(long delayMs, std::function<void()> callback) = 0;
+    virtual void startOneShotTimer(uint64_t delayMs, std::function<void()> callback) = 0;
 
     /**
      * @brief Stop the one-shot timer if it is running.
      */
     virtual void stopOneShotTimer() = 0;
+
+    /**
+     * @brief Start the one-shot timer limiting a manual override.
+     * 
+     * @param delayMs Delay in milliseconds.
+     * @param callback Function to call when timer expires.
+     */
+    virtual void startOverrideTimer(uint64_t delayMs, std::function<void()> callback) = 0;
+
+    /**
+     * @brief Stop the manual override timer if it is running.
+     */
+    virtual void stopOverrideTimer() = 0;
+
+    /**
+     * @brief Get the monotonic time since startup.
+     * 
+     * @return Time in milliseconds, wraps after ~49 days.
+     */
+    virtual uint32_t getMillis() = 0;
 };
@@ -7,6 +7,7 @@ constexpr std::array<int16_t, 6> MaicoPPB30::_FanSteps;
 MaicoPPB30::MaicoPPB30(IFanHardware& hw, uint8_t S1_PIN, uint8_t S2_PIN, uint8_t SW_PIN)
     : Fan(hw), _S1_PWM_PIN(S1_PIN), _S2_PWM_PIN(S2_PIN), _SW_PIN(SW_PIN) {
   _hw.init(_S1_PWM_PIN, _S2_PWM_PIN, _SW_PIN);
+  _pwmRange = _hw.getPWMRange();
   
   _fanStep = _FanSteps[0];
   setPWM();
@@ -39,6 +40,52 @@ void MaicoPPB30::onDirectionTimer() {
   _directionS1 *= -1;
   _directionS2 *= -1;
   setPWM();
+  // a new period only starts with a full cycle, so supply and exhaust phase
+  // stay equal and the room pressure balanced
+  if (!_syncPeriodMs && _directionS1 == 1)
+    _reversalPeriodMs = heatRecoveryPeriodMs(_fanStep * 1000 / _FanSteps.back());
+  if (_reversalPeriodMs != _directionPeriodMs)
+    armDirectionTimer(_reversalPeriodMs);
+}
+
+void MaicoPPB30::startDirectionTimer() {
+  if (_syncPeriodMs) {
+    alignDirection();
+    return;
+  }
+  _reversalPeriodMs = heatRecoveryPeriodMs(_fanStep * 1000 / _FanSteps.back());
+  armDirectionTimer(_reversalPeriodMs);
+}
+
+void MaicoPPB30::armDirectionTimer(uint32_t intervalMs) {
+  _directionPeriodMs = intervalMs;
+  _hw.startDirectionTimer(intervalMs, [this]() {
+      this->onDirectionTimer();
+  });
+}
+
+void MaicoPPB30::syncHeatRecovery(uint32_t periodMs, uint32_t cycleStartMs) {
+  _syncPeriodMs = periodMs;
+  _syncCycleStartMs = cycleStartMs;
+  if (_directionTimerActive)
+    alignDirection();
+}
+
+void MaicoPPB30::alignDirection() {
+  // with a phase offset the cycle start may lie ahead of now
+  int32_t cycleMs = 2 * _syncPeriodMs;
+  int32_t phaseMs = static_cast<int32_t>(_hw.getMillis() - _syncCycleStartMs) % cycleMs;
+  if (phaseMs < 0)
+    phaseMs += cycleMs;
+  int16_t direction = phaseMs < static_cast<int32_t>(_syncPeriodMs) ? 1 : -1;
+  if (direction != _directionS1) {
+    _directionS1 = direction;
+    _directionS2 = direction;
+    setPWM();
+  }
+  // the first interval ends on the grid of the cycle, onDirectionTimer continues with the period
+  _reversalPeriodMs = _syncPeriodMs;
+  armDirectionTimer(_syncPeriodMs - phaseMs % _syncPeriodMs);
 }
 
 void MaicoPPB30::updateMode() {
@@ -53,7 +100,8 @@ void MaicoPPB30::updateMode() {
   if (_ventilationMode == VentilationMode::SupplyAir) {
     _directionS1 = -1;
     _directionS2 = -1;
-  } else { // HeatRecovery and ExhaustAir modes
+  } else if (_ventilationMode != VentilationMode::HeatRecovery || !_directionTimerActive || !_syncPeriodMs) {
+    // HeatRecovery and ExhaustAir modes, a synchronised reversal keeps its phase
     _directionS1 = 1;
     _directionS2 = 1;
   }
@@ -61,9 +109,7 @@ void MaicoPPB30::updateMode() {
   if (_ventilationMode == VentilationMode::HeatRecovery &&
       !_directionTimerActive && _fanStep > _FanSteps[0]) {
     _directionTimerActive = true;
-    _hw.startDirectionTimer(heatRecoveryPeriodSeconds * 1000, [this]() {
-        this->onDirectionTimer();
-    });
+    startDirectionTimer();
   }
   if ((_ventilationMode != VentilationMode::HeatRecovery &&
        _directionTimerActive) ||
@@ -75,8 +121,9 @@ void MaicoPPB30::updateMode() {
   setPWM();
 }
 
-int16_t MaicoPPB30::getPWMLevel(int16_t fraction, int16_t base, int16_t resolution) {
-  return (fraction * resolution) / base;
+int16_t MaicoPPB30::getPWMLevel(int16_t fraction, int16_t base) const {
+  // finer PWM resolution gives finer duty steps without touching the fan steps
+  return ((int32_t)fraction * _pwmRange) / base;
 }
 
 void MaicoPPB30::setPWM() {
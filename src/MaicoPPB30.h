@@ -8,6 +8,7 @@ public:
 
   void changeFanSpeedDelegate(int16_t fanSpeed) override;
   int16_t getFanSpeed() override;
+  void syncHeatRecovery(uint32_t periodMs, uint32_t cycleStartMs) override;
 
 protected:
   void updateMode() override;
@@ -15,13 +16,20 @@ protected:
 private:
   void setPWM();
   void onDirectionTimer();
-  static int16_t getPWMLevel(int16_t fraction, int16_t base = 24, int16_t resolution = 1024);
+  void startDirectionTimer();
+  void armDirectionTimer(uint32_t intervalMs);
+  void alignDirection(); // direction and next reversal from the synchronised cycle
+  int16_t getPWMLevel(int16_t fraction, int16_t base = 24) const;
 
   const uint8_t _S1_PWM_PIN;
   const uint8_t _S2_PWM_PIN;
   const uint8_t _SW_PIN;
+  uint16_t _pwmRange = 1024; // duty value for 100 %, taken from the hardware after init
 
-  const int8_t heatRecoveryPeriodSeconds = 60;
+  uint32_t _directionPeriodMs = 0; // reversal period of the running direction timer
+  uint32_t _reversalPeriodMs = 0;  // period the timer returns to after a shorter first interval
+  uint32_t _syncPeriodMs = 0;      // 0 = free running
+  uint32_t _syncCycleStartMs = 0;
   static constexpr std::array<int16_t, 6> _FanSteps = {0, 4, 6, 8, 9, 10};
 
   int16_t _fanStep = 0;
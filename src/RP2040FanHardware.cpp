@@ -1,77 +1,54 @@
 #include "RP2040FanHardware.h"
 #include "hardware.h"
+#include "hardware/clocks.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
 
 
-RP2040FanHardware::RP2040FanHardware() {
-}
-
-RP2040FanHardware::~RP2040FanHardware() {
-    stopDirectionTimer();
+RP2040FanHardware::RP2040FanHardware(FanTimerWheel& wheel, FanPwmAllocator& allocator,
+                                     uint32_t pwmFreqHz, uint8_t pwmResolutionBits)
+    : TimerWheelFanHardware(wheel), _allocator(allocator),
+      _pwmFreqHz(pwmFreqHz), _pwmResolutionBits(pwmResolutionBits) {
 }
 
 void RP2040FanHardware::init(uint8_t s1_pin, uint8_t s2_pin, uint8_t sw_pin) {
+    // each fan configures only its own slices, the Arduino analogWrite
+    // settings are global and would be overwritten by the next fan
+    _ready = _allocator.claimPwm(s1_pin, _pwmFreqHz, _pwmResolutionBits) == FanPwmAllocator::Ok &&
+             (s2_pin == NoPin || _allocator.claimPwm(s2_pin, _pwmFreqHz, _pwmResolutionBits) == FanPwmAllocator::Ok) &&
+             _allocator.claimDigital(sw_pin) == FanPwmAllocator::Ok;
+    if (!_ready)
+        return;
+
     pinMode(sw_pin, OUTPUT);
-    pinMode(s1_pin, OUTPUT);
-    pinMode(s2_pin, OUTPUT);
-    pinMode(STATUS_LED_PIN, OUTPUT);
-    
-    analogWriteFreq(pwmFreqHz);
-    analogWriteResolution(10);
+    setupPwmPin(s1_pin);
+    if (s2_pin != NoPin)
+        setupPwmPin(s2_pin);
+}
+
+void RP2040FanHardware::setupPwmPin(uint8_t pin) {
+    uint8_t index = FanPwmAllocator::sliceOf(pin);
+    const FanPwmAllocator::SliceConfig& slice = _allocator.slice(index);
+    pwm_set_wrap(index, slice.wrap);
+    pwm_set_clkdiv_int_frac(index, slice.divInt, slice.divFrac);
+    pwm_set_gpio_level(pin, 0);
+    pwm_set_enabled(index, true);
+    gpio_set_function(pin, GPIO_FUNC_PWM);
 }
 
 void RP2040FanHardware::setPWM(uint8_t pin, int16_t value) {
-    analogWrite(pin, value);
+    if (_ready)
+        pwm_set_gpio_level(pin, value);
 }
 
 void RP2040FanHardware::setDigital(uint8_t pin, bool value) {
     digitalWrite(pin, value ? HIGH : LOW);
 }
 
-bool RP2040FanHardware::staticDirectionCallback(struct repeating_timer *t) {
-    auto hw = static_cast<RP2040FanHardware*>(t->user_data);
-    if (hw && hw->_directionCallback) {
-        hw->_directionCallback();
-    }
-    return true;
-}
-
-void RP2040FanHardware::startDirectionTimer(long intervalMs, std::function<void()> callback) {
-    if (_directionTimerActive) {
-        cancel_repeating_timer(&_directionTimer);
-    }
-    _directionCallback = callback;
-    _directionTimerActive = true;
-    add_repeating_timer_ms(intervalMs, staticDirectionCallback, this, &_directionTimer);
-}
-
-void RP2040FanHardware::stopDirectionTimer() {
-    if (_directionTimerActive) {
-        cancel_repeating_timer(&_directionTimer);
-        _directionTimerActive = false;
-    }
+uint16_t RP2040FanHardware::getPWMRange() {
+    return 1 << _pwmResolutionBits;
 }
 
-int64_t RP2040FanHardware::staticTimeoutCallback(alarm_id_t id, void *user_data) {
-    auto hw = static_cast<RP2040FanHardware*>(user_data);
-    if (hw) {
-        hw->_oneShotTimerActive = false;
-        if (hw->_oneShotCallback) {
-            hw->_oneShotCallback();
-        }
-    }
-    return 0;
+uint32_t RP2040FanHardware::getMillis() {
+    return millis();
 }
-
-void RP2040FanHardware::startOneShotTimer(long delayMs, std::function<void()> callback) {
-    stopOneShotTimer();
-    _oneShotCallback = callback;
-    _oneShotTimerActive = true;
-    _oneShotAlarmID = add_alarm_in_ms(delayMs, staticTimeoutCallback, this, false);
-}
-
-void RP2040FanHardware::stopOneShotTimer() {
-    if (_oneShotTimerActive) {
-        cancel_alarm(_oneShotAlarmID);
-        _oneShotTimerActive = false;
-    }
-}
\ No newline at end of file
@@ -1,33 +1,29 @@
 #pragma once
 
-#include "IFanHardware.h"
+#include "TimerWheelFanHardware.h"
+#include "FanPwmAllocator.h"
 #include <Arduino.h>
 #include "pico/stdlib.h"
 
-class RP2040FanHardware : public IFanHardware {
+class RP2040FanHardware : public TimerWheelFanHardware {
 public:
-    RP2040FanHardware();
-    virtual ~RP2040FanHardware();
+    RP2040FanHardware(FanTimerWheel& wheel, FanPwmAllocator& allocator,
+                      uint32_t pwmFreqHz = 10000, uint8_t pwmResolutionBits = 10);
 
     void init(uint8_t s1_pin, uint8_t s2_pin, uint8_t sw_pin) override;
     void setPWM(uint8_t pin, int16_t value) override;
     void setDigital(uint8_t pin, bool value) override;
-    void startDirectionTimer(long intervalMs, std::function<void()> callback) override;
-    void stopDirectionTimer() override;
-    void startOneShotTimer(long delayMs, std::function<void()> callback) override;
-    void stopOneShotTimer() override;
+    uint16_t getPWMRange() override;
+    uint32_t getMillis() override;
+
+    // false if one of the pins could not be allocated, outputs stay untouched then
+    bool isReady() const { return _ready; }
 
 private:
-    static bool staticDirectionCallback(struct repeating_timer *t);
-    static int64_t staticTimeoutCallback(alarm_id_t id, void *user_data);
+    void setupPwmPin(uint8_t pin);
 
-    struct repeating_timer _directionTimer;
-    bool _directionTimerActive = false;
-    std::function<void()> _directionCallback;
-    std::function<void()> _oneShotCallback;
-    alarm_id_t _oneShotAlarmID = 0;
-    bool _oneShotTimerActive = false;
-    
-    // PWM frequency from original Fan.h
-    const uint16_t pwmFreqHz = 10000; // 10kHz
+    FanPwmAllocator& _allocator;
+    const uint32_t _pwmFreqHz;
+    const uint8_t _pwmResolutionBits;
+    bool _ready = false;
 };
@@ -0,0 +1,111 @@
+#include "SensorAggregate.h"
+#include <math.h>
+
+void SensorAggregate::configure(Mode mode, uint8_t sensorCount, uint32_t staleMs) {
+  _mode = mode;
+  _sensorCount = sensorCount < 1 ? 1 : (sensorCount > MaxSensors ? MaxSensors : sensorCount);
+  _staleMs = staleMs;
+  for (uint8_t i = 0; i < MaxSensors; i++)
+    _weights[i] = 1;
+  _freshMask = 0;
+  _freshCount = 0;
+  _maxSensor = -1;
+  _weightedSum = 0;
+  _weightSum = 0;
+}
+
+void SensorAggregate::setWeight(uint8_t sensor, uint8_t weight) {
+  if (sensor >= MaxSensors || _mode != Weighted || weight == 0)
+    return;
+  bool wasFresh = fresh(sensor);
+  if (wasFresh)
+    remove(sensor);
+  _weights[sensor] = weight;
+  if (wasFresh)
+    add(sensor);
+}
+
+bool SensorAggregate::update(uint8_t sensor, float value, uint32_t nowMs) {
+  return updateHundredths(sensor, static_cast<int32_t>(lroundf(value * 100)), nowMs);
+}
+
+bool SensorAggregate::updateHundredths(uint8_t sensor, int32_t value, uint32_t nowMs) {
+  if (sensor >= _sensorCount)
+    return false;
+  int32_t previous = valid() ? aggregate() : INT32_MIN;
+  if (fresh(sensor))
+    remove(sensor);
+  _values[sensor] = value;
+  _timesMs[sensor] = nowMs;
+  add(sensor);
+  return aggregate() != previous;
+}
+
+bool SensorAggregate::expire(uint32_t nowMs) {
+  if (!_staleMs || !_freshCount)
+    return false;
+  int32_t previous = aggregate();
+  bool expired = false;
+  for (uint8_t i = 0; i < _sensorCount; i++) {
+    if (fresh(i) && nowMs - _timesMs[i] >= _staleMs) {
+      remove(i);
+      expired = true;
+    }
+  }
+  return expired && (!valid() || aggregate() != previous);
+}
+
+float SensorAggregate::value() const {
+  return aggregate() / 100.0f;
+}
+
+uint32_t SensorAggregate::msUntilExpiry(uint32_t nowMs) const {
+  uint32_t next = UINT32_MAX;
+  if (!_staleMs)
+    return next;
+  for (uint8_t i = 0; i < _sensorCount; i++) {
+    if (!fresh(i))
+      continue;
+    uint32_t age = nowMs - _timesMs[i];
+    uint32_t remaining = age < _staleMs ? _staleMs - age : 0;
+    if (remaining < next)
+      next = remaining;
+  }
+  return next;
+}
+
+void SensorAggregate::add(uint8_t sensor) {
+  _freshMask |= 1 << sensor;
+  _freshCount++;
+  _weightedSum += _values[sensor] * _weights[sensor];
+  _weightSum += _weights[sensor];
+  if (_maxSensor < 0 || _values[sensor] > _values[_maxSensor])
+    _maxSensor = sensor;
+}
+
+void SensorAggregate::remove(uint8_t sensor) {
+  _freshMask &= ~(1 << sensor);
+  _freshCount--;
+  _weightedSum -= _values[sensor] * _weights[sensor];
+  _weightSum -= _weights[sensor];
+  if (_maxSensor == sensor)
+    findMax();
+}
+
+void SensorAggregate::findMax() {
+  _maxSensor = -1;
+  for (uint8_t i = 0; i < _sensorCount; i++) {
+    if (fresh(i) && (_maxSensor < 0 || _values[i] > _values[_maxSensor]))
+      _maxSensor = i;
+  }
+}
+
+int32_t SensorAggregate::aggregate() const {
+  if (!_freshCount)
+    return 0;
+  if (_mode == Max)
+    return _values[_maxSensor];
+  // weights stay 1 in mode Mean, rounded to the nearest 1/100
+  int32_t half = _weightSum / 2;
+  return (_weightedSum >= 0 ? _weightedSum + half : _weightedSum - half) / _weightSum;
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <stdint.h>
+
+/**
+ * @brief Combines the readings of up to MaxSensors sensors of one quantity.
+ * Values are kept in 1/100 units, so the running sums of the mean modes are
+ * exact and a telegram only replaces the contribution of its sensor. The
+ * maximum follows the largest sensor and is searched again only when that
+ * sensor drops, which is bounded by MaxSensors. A sensor without a telegram
+ * for the stale time is excluded until it sends again.
+ */
+class SensorAggregate {
+public:
+  enum Mode : uint8_t {
+    Max = 0,
+    Mean = 1,
+    Weighted = 2,
+  };
+
+  static constexpr uint8_t MaxSensors = 3;
+
+  // staleMs 0 keeps the last value of a sensor forever
+  void configure(Mode mode, uint8_t sensorCount, uint32_t staleMs);
+  void setWeight(uint8_t sensor, uint8_t weight); // only in mode Weighted, 1 otherwise; call after configure()
+  // returns true when the aggregate changed
+  bool update(uint8_t sensor, float value, uint32_t nowMs);
+  bool updateHundredths(uint8_t sensor, int32_t value, uint32_t nowMs); // value in 1/100 units
+  bool expire(uint32_t nowMs);
+
+  bool valid() const { return _freshCount > 0; }
+  float value() const; // aggregate, only meaningful while valid()
+  int32_t hundredths() const { return aggregate(); } // value() in 1/100 units
+  uint8_t freshCount() const { return _freshCount; }
+  uint32_t msUntilExpiry(uint32_t nowMs) const; // UINT32_MAX without a fresh sensor or stale time
+
+private:
+  bool fresh(uint8_t sensor) const { return _freshMask & (1 << sensor); }
+  void add(uint8_t sensor);
+  void remove(uint8_t sensor);
+  void findMax();
+  int32_t aggregate() const;
+
+  // per sensor arrays instead of an array of structs, saves the padding
+  int32_t _values[MaxSensors] = {}; // 1/100 units
+  uint32_t _timesMs[MaxSensors] = {};
+  int32_t _weightedSum = 0;
+  uint32_t _staleMs = 0;
+  uint8_t _weights[MaxSensors] = {1, 1, 1};
+  uint8_t _weightSum = 0;
+  uint8_t _freshMask = 0;
+  uint8_t _freshCount = 0;
+  int8_t _maxSensor = -1;
+  uint8_t _sensorCount = 1;
+  Mode _mode = Max;
+};
@@ -0,0 +1,33 @@
+#include "TimerWheelFanHardware.h"
+
+TimerWheelFanHardware::TimerWheelFanHardware(FanTimerWheel& wheel)
+    : _wheel(wheel) {
+}
+
+void TimerWheelFanHardware::startDirectionTimer(uint32_t intervalMs, std::function<void()> callback) {
+    _wheel.arm(_directionTimer, intervalMs, callback, intervalMs);
+}
+
+void TimerWheelFanHardware::stopDirectionTimer() {
+    _wheel.cancel(_directionTimer);
+}
+
+void TimerWheelFanHardware::startOneShotTimer(uint64_t delayMs, std::function<void()> callback) {
+    _wheel.arm(_oneShotTimer, delayMs, callback);
+}
+
+void TimerWheelFanHardware::stopOneShotTimer() {
+    _wheel.cancel(_oneShotTimer);
+}
+
+void TimerWheelFanHardware::startOverrideTimer(uint64_t delayMs, std::function<void()> callback) {
+    _wheel.arm(_overrideTimer, delayMs, callback);
+}
+
+void TimerWheelFanHardware::stopOverrideTimer() {
+    _wheel.cancel(_overrideTimer);
+}
+
+uint32_t TimerWheelFanHardware::getMillis() {
+    return static_cast<uint32_t>(_wheel.now());
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "IFanHardware.h"
+#include "FanTimerWheel.h"
+
+/**
+ * @brief IFanHardware timer methods implemented on a shared FanTimerWheel.
+ * Hardware specific classes derive from it and only provide the pin access,
+ * so all fans of the module share one tick source instead of hardware alarms.
+ */
+class TimerWheelFanHardware : public IFanHardware {
+public:
+    TimerWheelFanHardware(FanTimerWheel& wheel);
+
+    void startDirectionTimer(uint32_t intervalMs, std::function<void()> callback) override;
+    void stopDirectionTimer() override;
+    void startOneShotTimer(uint64_t delayMs, std::function<void()> callback) override;
+    void stopOneShotTimer() override;
+    void startOverrideTimer(uint64_t delayMs, std::function<void()> callback) override;
+    void stopOverrideTimer() override;
+    uint32_t getMillis() override;
+
+protected:
+    FanTimerWheel& _wheel;
+    FanTimer _directionTimer;
+    FanTimer _oneShotTimer;
+    FanTimer _overrideTimer;
+};
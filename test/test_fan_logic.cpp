@@ -1,8 +1,28 @@
 #include <unity.h>
 #include "Fan.h"
 #include "MaicoPPB30.h"
+#include "EcFan.h"
 #include "IFanHardware.h"
+#include "FanSchedule.h"
+#include "FanTimerWheel.h"
+#include "FanPwmAllocator.h"
+#include "TimerWheelFanHardware.h"
+#include "FanModule.h"
+#include "FanTrace.h"
+#include "FanTraceReplay.h"
+#include "FanFleet.h"
+#include "FanAutoTune.h"
+#include "FanPredictor.h"
+#include "SensorAggregate.h"
+#include "FanPhaseSync.h"
+#include "FanShadow.h"
+#include "FanHistory.h"
+#include "FanSpeedCurve.h"
+#include "Dpt9Decoder.h"
+#include "FanBus.h"
+#include "hardware/gpio.h"
 #include <map>
+#include <vector>
 #include <string>
 
 // Mock Hardware Implementation
@@ -20,6 +40,9 @@ public:
     std::function<void()> directionCallback;
     long directionInterval = 0;
     bool directionTimerRunning = false;
+    std::function<void()> overrideCallback;
+    uint32_t nowMs = 0;
+    uint16_t pwmRange = 1024;
 
     void init(uint8_t s1, uint8_t s2, uint8_t sw) override {
         logs.push_back({"init", s1, s2});
@@ -35,7 +58,7 @@ public:
         logs.push_back({"setDigital", pin, (int)value});
     }
 
-    void startDirectionTimer(long intervalMs, std::function<void()> callback) override {
+    void startDirectionTimer(uint32_t intervalMs, std::function<void()> callback) override {
         directionInterval = intervalMs;
         directionCallback = callback;
         directionTimerRunning = true;
@@ -47,7 +70,7 @@ public:
         logs.push_back({"stopDirectionTimer", 0, 0});
     }
 
-    void startOneShotTimer(long delayMs, std::function<void()> callback) override {
+    void startOneShotTimer(uint64_t delayMs, std::function<void()> callback) override {
         logs.push_back({"startOneShotTimer", (int)delayMs, 0});
         // Auto-fire for simplicity in synchronous tests if needed, or store to fire manually
     }
@@ -56,6 +79,24 @@ public:
         logs.push_back({"stopOneShotTimer", 0, 0});
     }
 
+    void startOverrideTimer(uint64_t delayMs, std::function<void()> callback) override {
+        overrideCallback = callback;
+        logs.push_back({"startOverrideTimer", (int)delayMs, 0});
+    }
+
+    void stopOverrideTimer() override {
+        overrideCallback = nullptr;
+        logs.push_back({"stopOverrideTimer", 0, 0});
+    }
+
+    uint16_t getPWMRange() override {
+        return pwmRange;
+    }
+
+    uint32_t getMillis() override {
+        return nowMs;
+    }
+
     void printLogs() {
         printf("MockFanHardware Logs:\n");
         for (const auto& log : logs) {
@@ -64,6 +105,19 @@ public:
     }
 };
 
+// Virtual-time hardware, timers run on a FanTimerWheel advanced by the test
+class VirtualFanHardware : public TimerWheelFanHardware {
+public:
+    VirtualFanHardware(FanTimerWheel& wheel) : TimerWheelFanHardware(wheel) {}
+
+    std::map<uint8_t, int16_t> pwmValues;
+    std::map<uint8_t, bool> digitalValues;
+
+    void init(uint8_t s1, uint8_t s2, uint8_t sw) override {}
+    void setPWM(uint8_t pin, int16_t value) override { pwmValues[pin] = value; }
+    void setDigital(uint8_t pin, bool value) override { digitalValues[pin] = value; }
+};
+
 void test_fan_initialization() {
     MockFanHardware mockHw;
     MaicoPPB30 fan(mockHw, 1, 2, 3);
@@ -162,6 +216,91 @@ void test_automatic_mode_logic() {
     TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
 }
 
+void test_automatic_dwell_times() {
+    MockFanHardware mockHw;
+    MaicoPPB30 fan(mockHw, 1, 2, 3);
+    fan.thresholdHumidityOn = 65;
+    fan.thresholdHumidityOff = 60;
+    fan.automaticMinOnMs = 10 * 60000;
+    fan.automaticMinOffMs = 5 * 60000;
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+
+    // the first decision has no dwell time to respect
+    fan.setInsideHumdity(70);
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    TEST_ASSERT_EQUAL(UINT32_MAX, fan.msUntilDwellEnd());
+
+    // dry again after a minute, the fan keeps the minimum run time
+    mockHw.nowMs = 60000;
+    fan.setInsideHumdity(55);
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    TEST_ASSERT_EQUAL(9 * 60000, fan.msUntilDwellEnd());
+    mockHw.nowMs = 10 * 60000 - 1;
+    fan.loop();
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    // the decision is taken again without a new telegram
+    mockHw.nowMs = 10 * 60000;
+    fan.loop();
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    TEST_ASSERT_EQUAL(UINT32_MAX, fan.msUntilDwellEnd());
+
+    // humid again within the pause, the humidity falls before its end
+    mockHw.nowMs = 11 * 60000;
+    fan.setInsideHumdity(70);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    mockHw.nowMs = 12 * 60000;
+    fan.setInsideHumdity(62); // within the band, the held start is still due
+    mockHw.nowMs = 15 * 60000;
+    fan.loop();
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    fan.setInsideHumdity(70);
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+
+    // adaptive speeds hold each step for the minimum step time
+    fan.setControlMode(Fan::ControlMode::Adaptive);
+    fan.controlGain = 0.5f;
+    fan.automaticMinStepMs = 2 * 60000;
+    mockHw.nowMs = 30 * 60000;
+    fan.setInsideHumdity(68); // 1.5 -> step 1
+    TEST_ASSERT_EQUAL(1, fan.getFanSpeed());
+    mockHw.nowMs = 31 * 60000;
+    fan.setInsideHumdity(71); // 3 -> step 3, held
+    TEST_ASSERT_EQUAL(1, fan.getFanSpeed());
+    mockHw.nowMs = 32 * 60000;
+    fan.loop();
+    TEST_ASSERT_EQUAL(3, fan.getFanSpeed());
+}
+
+void test_dew_point_hysteresis() {
+    MockFanHardware mockHw;
+    MaicoPPB30 fan(mockHw, 1, 2, 3);
+    fan.thresholdHumidityOn = 65;
+    fan.thresholdHumidityOff = 60;
+    fan.humiditySensorMode = Fan::HumiditySensorMode::Absolute;
+    fan.dewPointHysteresis = 1.0f;
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+    fan.setInsideTemperature(20);
+    fan.setOutsideTemperature(20);
+    fan.setInsideHumdity(70);
+
+    // outside dew point 0.45 K and 0.9 K lower: within the band
+    fan.setOutsideHumidity(68);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    fan.setOutsideHumidity(66);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    // 1.14 K lower starts, it keeps running down to no difference
+    fan.setOutsideHumidity(65);
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    fan.setOutsideHumidity(68);
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    fan.setOutsideHumidity(69);
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    fan.setOutsideHumidity(71);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    fan.setOutsideHumidity(68);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+}
+
 void test_heat_recovery_timer() {
     MockFanHardware mockHw;
     MaicoPPB30 fan(mockHw, 1, 2, 3);
@@ -183,6 +322,133 @@ void test_heat_recovery_timer() {
     // For now, just verifying the timer interaction is good.
 }
 
+void test_heat_recovery_period_sequence() {
+    FanTimerWheel wheel;
+    VirtualFanHardware hw(wheel);
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    fan.heatRecoveryMinSeconds = 30;
+    fan.heatRecoveryMaxSeconds = 120;
+    fan.heatRecoveryFrostSeconds = 20;
+    fan.setVentilationMode(Fan::VentilationMode::HeatRecovery);
+    fan.setFanSpeed(5);
+
+    // seconds of the direction changes, S1 above half range is exhaust air
+    std::vector<int> reversals;
+    bool exhaust = hw.pwmValues[1] > 512;
+    auto runUntil = [&](int seconds) {
+        for (int t = (int)(wheel.now() / 1000) + 1; t <= seconds; t++) {
+            wheel.advance(t * 1000ull);
+            bool now = hw.pwmValues[1] > 512;
+            if (now != exhaust)
+                reversals.push_back(t);
+            exhaust = now;
+        }
+    };
+
+    // highest step without temperatures: shortest period
+    runUntil(100);
+    // 6 K difference, the new period starts with the next exhaust phase
+    fan.setInsideTemperature(21);
+    fan.setOutsideTemperature(15);
+    runUntil(300);
+    // lowest step saturates the core later
+    fan.setFanSpeed(1);
+    runUntil(700);
+    // frost outside, the long period of the large difference is limited
+    fan.setOutsideTemperature(-5);
+    runUntil(950);
+
+    const int expected[] = {30, 60, 90, 120, 204, 288, 372, 456, 558, 660, 762, 864, 884, 904, 924, 944};
+    TEST_ASSERT_EQUAL(sizeof(expected) / sizeof(expected[0]), reversals.size());
+    for (size_t i = 0; i < reversals.size(); i++)
+        TEST_ASSERT_EQUAL(expected[i], reversals[i]);
+
+    // equal bounds keep the fixed period of the driver
+    FanTimerWheel fixedWheel;
+    VirtualFanHardware fixedHw(fixedWheel);
+    MaicoPPB30 fixed(fixedHw, 1, 2, 3);
+    fixed.setInsideTemperature(21);
+    fixed.setOutsideTemperature(-10);
+    fixed.setVentilationMode(Fan::VentilationMode::HeatRecovery);
+    fixed.setFanSpeed(2);
+    fixedWheel.advance(59999);
+    TEST_ASSERT_TRUE(fixedHw.pwmValues[1] > 512);
+    fixedWheel.advance(60000);
+    TEST_ASSERT_TRUE(fixedHw.pwmValues[1] < 512);
+}
+
+void test_phase_sync_election() {
+    // a synchronised fan reverses on the grid of the common cycle, speed changes keep the phase
+    FanTimerWheel wheel;
+    VirtualFanHardware hw(wheel);
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    fan.setVentilationMode(Fan::VentilationMode::HeatRecovery);
+    fan.setFanSpeed(3);
+    wheel.advance(10000);
+    fan.syncHeatRecovery(30000, 45000); // 25 s into the exhaust phase of the cycle from -15 s
+    TEST_ASSERT_TRUE(hw.pwmValues[1] > 512);
+    wheel.advance(14999);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] > 512);
+    wheel.advance(15000);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] < 512);
+    wheel.advance(45000);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] > 512);
+    fan.setFanSpeed(5);
+    wheel.advance(74999);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] > 512);
+    wheel.advance(75000);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] < 512);
+    // a restart joins the cycle in its supply phase
+    fan.setFanSpeed(0);
+    wheel.advance(80000);
+    fan.setFanSpeed(2);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] < 512);
+    wheel.advance(104999);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] < 512);
+    wheel.advance(105000);
+    TEST_ASSERT_TRUE(hw.pwmValues[1] > 512);
+
+    // a candidate waits three cycles and its stagger before it takes over
+    FanPhaseSync second;
+    second.configure(FanPhaseSync::Candidate, 2, 60000, 0);
+    TEST_ASSERT_EQUAL(362000, second.msUntilNextEvent(0));
+    TEST_ASSERT_FALSE(second.loop(361999));
+    TEST_ASSERT_TRUE(second.loop(362000));
+    TEST_ASSERT_TRUE(second.master());
+    TEST_ASSERT_EQUAL_HEX32(0x02000258, second.telegram());
+    TEST_ASSERT_EQUAL(120000, second.msUntilNextEvent(362000));
+    TEST_ASSERT_FALSE(second.loop(481999));
+    TEST_ASSERT_TRUE(second.loop(482100)); // late loop, the grid stays
+    TEST_ASSERT_EQUAL(482000, second.cycleStartMs(482100));
+
+    // a lower id takes over with the phase of the sender, the old master follows it
+    FanPhaseSync first;
+    first.configure(FanPhaseSync::Candidate, 1, 30000, 400000);
+    TEST_ASSERT_TRUE(first.receive(second.telegram(), 482100));
+    TEST_ASSERT_TRUE(first.master());
+    TEST_ASSERT_EQUAL(60000, first.periodMs());
+    TEST_ASSERT_FALSE(first.loop(602099));
+    TEST_ASSERT_TRUE(first.loop(602100));
+    TEST_ASSERT_EQUAL(30000, first.periodMs());
+    TEST_ASSERT_EQUAL_HEX32(0x0100012C, first.telegram());
+    TEST_ASSERT_TRUE(second.loop(602100));
+    TEST_ASSERT_FALSE(first.receive(second.telegram(), 602100));
+    TEST_ASSERT_TRUE(second.receive(first.telegram(), 602100));
+    TEST_ASSERT_FALSE(second.master());
+    TEST_ASSERT_EQUAL(1, second.masterId());
+
+    // a follower never sends, it ignores a higher id while its master is heard
+    FanPhaseSync follower;
+    follower.configure(FanPhaseSync::Follower, 3, 60000, 0);
+    TEST_ASSERT_EQUAL(UINT32_MAX, follower.msUntilNextEvent(0));
+    TEST_ASSERT_FALSE(follower.loop(10000000));
+    TEST_ASSERT_TRUE(follower.receive(first.telegram(), 10000000));
+    TEST_ASSERT_FALSE(follower.receive(second.telegram(), 10030000));
+    TEST_ASSERT_EQUAL(10060000, follower.cycleStartMs(10061000));
+    TEST_ASSERT_TRUE(follower.receive(second.telegram(), 10080000)); // id 1 missed its cycle
+    TEST_ASSERT_EQUAL(2, follower.masterId());
+}
+
 void test_threshold_crossing_detection() {
     MockFanHardware mockHw;
     MaicoPPB30 fan(mockHw, 1, 2, 3);
@@ -242,15 +508,1884 @@ void test_manual_override() {
     TEST_ASSERT_EQUAL(fan.thresholdSpeed, fan.getFanSpeed());
 }
 
+void test_arbitration_interleaved_sources() {
+    FanTimerWheel wheel;
+    VirtualFanHardware hw(wheel);
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    std::vector<Fan::Source> sources;
+    fan.setSourceChangeCallback([&sources](Fan::Source source) { sources.push_back(source); });
+
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+    fan.setVentilationMode(Fan::VentilationMode::ExhaustAir, Fan::VentilationModeTarget_Automatic);
+    fan.setScheduleSpeed(1);
+    TEST_ASSERT_EQUAL(Fan::Source_Schedule, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(1, fan.getFanSpeed());
+
+    fan.setInsideHumdity(80.0);
+    TEST_ASSERT_EQUAL(Fan::Source_Automatic, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(Fan::VentilationMode::ExhaustAir, fan.getVentilationMode());
+
+    // manual command, then run-on timer: speed commands go to the run
+    fan.setFanSpeed(2);
+    TEST_ASSERT_EQUAL(Fan::Source_Manual, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(Fan::VentilationMode::HeatRecovery, fan.getVentilationMode());
+    fan.setTimer(600, nullptr);
+    TEST_ASSERT_EQUAL(Fan::Source_Timer, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(2, fan.getFanSpeed());
+    fan.setFanSpeed(5);
+    TEST_ASSERT_EQUAL(5, fan.getFanSpeed());
+
+    // automatic ventilation ends during the run, the run keeps its speed
+    fan.setInsideHumdity(40.0);
+    TEST_ASSERT_EQUAL(5, fan.getFanSpeed());
+    fan.setScheduleSpeed(3);
+    TEST_ASSERT_EQUAL(5, fan.getFanSpeed());
+
+    // run ends at the current schedule level, not at a saved speed
+    wheel.advance(600000);
+    TEST_ASSERT_EQUAL(Fan::Source_Schedule, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(3, fan.getFanSpeed());
+
+    // time limited manual override falls back to the automatic request
+    fan.manualOverrideTimeoutMs = 60000;
+    fan.setInsideHumdity(80.0);
+    TEST_ASSERT_EQUAL(fan.thresholdSpeed, fan.getFanSpeed());
+    fan.setFanSpeed(1);
+    TEST_ASSERT_EQUAL(1, fan.getFanSpeed());
+    wheel.advance(659999);
+    TEST_ASSERT_EQUAL(1, fan.getFanSpeed());
+    wheel.advance(660000);
+    TEST_ASSERT_EQUAL(Fan::Source_Automatic, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(fan.thresholdSpeed, fan.getFanSpeed());
+
+    fan.setOperatingMode(Fan::OperatingMode::Off);
+    TEST_ASSERT_EQUAL(Fan::Source_Off, fan.getActiveSource());
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+
+    const Fan::Source expected[] = {Fan::Source_Schedule, Fan::Source_Automatic, Fan::Source_Manual, Fan::Source_Timer,
+                                    Fan::Source_Schedule, Fan::Source_Automatic, Fan::Source_Manual, Fan::Source_Automatic,
+                                    Fan::Source_Off};
+    TEST_ASSERT_EQUAL(sizeof(expected) / sizeof(expected[0]), sources.size());
+    for (size_t i = 0; i < sources.size(); i++)
+        TEST_ASSERT_EQUAL(expected[i], sources[i]);
+}
+
+// reference rules of the mode machine, written as plain conditions
+static FanModeMachine::Transition modeSpec(uint8_t state, uint8_t event) {
+    uint8_t mode = FanModeMachine::modeOf(state);
+    bool automatic = mode == FanModeMachine::Mode_Automatic;
+    bool timer = state & FanModeMachine::Timer;
+    bool override = state & FanModeMachine::Override;
+    bool autoActive = state & FanModeMachine::AutoActive;
+    uint8_t actions = 0;
+
+    switch (event) {
+    case FanModeMachine::Event_ModeOff:
+    case FanModeMachine::Event_ModeManual:
+    case FanModeMachine::Event_ModeAutomatic: {
+        uint8_t newMode = event - FanModeMachine::Event_ModeOff;
+        if (automatic && newMode != FanModeMachine::Mode_Automatic && !override)
+            actions |= FanModeMachine::Action_ResetBase;
+        autoActive = autoActive && automatic && newMode == FanModeMachine::Mode_Automatic;
+        override = false;
+        mode = newMode;
+        break;
+    }
+    case FanModeMachine::Event_HumidityHigh:
+        if (automatic) {
+            autoActive = true;
+            actions |= FanModeMachine::Action_AutoRequest;
+        }
+        break;
+    case FanModeMachine::Event_HumidityLow:
+        if (automatic)
+            autoActive = false;
+        break;
+    case FanModeMachine::Event_HumidityCrossed:
+        if (automatic)
+            override = false;
+        break;
+    case FanModeMachine::Event_ManualCommand:
+        if (timer) {
+            actions |= FanModeMachine::Action_TimerRequest;
+        } else {
+            override = true;
+            actions |= FanModeMachine::Action_ManualRequest;
+        }
+        break;
+    case FanModeMachine::Event_OverrideTimeout:
+    case FanModeMachine::Event_ScheduleSwitch:
+        override = false;
+        break;
+    case FanModeMachine::Event_TimerStart:
+        timer = true;
+        actions |= FanModeMachine::Action_TimerRequest;
+        break;
+    case FanModeMachine::Event_TimerEnd:
+        timer = false;
+        override = false;
+        actions |= FanModeMachine::Action_ResetBase;
+        break;
+    case FanModeMachine::Event_Reset:
+        override = false;
+        actions |= FanModeMachine::Action_ResetBase;
+        break;
+    default: // Event_HumidityBand
+        break;
+    }
+    uint8_t flags = (timer ? FanModeMachine::Timer : 0) | (override ? FanModeMachine::Override : 0) |
+                    (autoActive ? FanModeMachine::AutoActive : 0);
+    return {FanModeMachine::state(mode, flags), actions};
+}
+
+// exposes the machine of the fan to drive it event by event
+class ModeTestFan : public MaicoPPB30 {
+public:
+    using MaicoPPB30::MaicoPPB30;
+    using Fan::dispatch;
+    using Fan::modeState;
+};
+
+void test_mode_machine_exhaustive() {
+    for (uint8_t state = 0; state < FanModeMachine::StateCount; state++) {
+        for (uint8_t event = 0; event < FanModeMachine::EventCount; event++) {
+            const FanModeMachine::Transition& actual = FanModeMachine::lookup(state, (FanModeMachine::Event)event);
+            FanModeMachine::Transition expected = modeSpec(state, event);
+            char message[48];
+            snprintf(message, sizeof(message), "state %u event %u", state, event);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.next, actual.next, message);
+            TEST_ASSERT_EQUAL_MESSAGE(expected.actions, actual.actions, message);
+            TEST_ASSERT_TRUE_MESSAGE(FanModeMachine::modeOf(actual.next) < FanModeMachine::ModeCount, message);
+        }
+    }
+
+    // the fan applies every transition: bring it into each reachable state,
+    // run each event and compare the state derived from its requests
+    for (uint8_t state = 0; state < FanModeMachine::StateCount; state++) {
+        uint8_t mode = FanModeMachine::modeOf(state);
+        if ((state & FanModeMachine::AutoActive) && mode != FanModeMachine::Mode_Automatic)
+            continue; // automatic ventilation exists only in automatic mode
+        for (uint8_t event = 0; event < FanModeMachine::EventCount; event++) {
+            FanTimerWheel wheel;
+            VirtualFanHardware hw(wheel);
+            ModeTestFan fan(hw, 1, 2, 3);
+            fan.setOperatingMode((Fan::OperatingMode)mode);
+            if (state & FanModeMachine::AutoActive)
+                fan.dispatch(FanModeMachine::Event_HumidityHigh, 4);
+            if (state & FanModeMachine::Override)
+                fan.dispatch(FanModeMachine::Event_ManualCommand, 2);
+            if (state & FanModeMachine::Timer)
+                fan.dispatch(FanModeMachine::Event_TimerStart, 3);
+            TEST_ASSERT_EQUAL(state, fan.modeState());
+
+            fan.dispatch((FanModeMachine::Event)event, 1);
+            TEST_ASSERT_EQUAL(FanModeMachine::lookup(state, (FanModeMachine::Event)event).next, fan.modeState());
+        }
+    }
+}
+
+void test_schedule_next_switch() {
+    FanSchedule schedule;
+    std::vector<int16_t> switches;
+    schedule.setSwitchCallback([&switches](int16_t speed) { switches.push_back(speed); });
+
+    schedule.addSwitchPoint(FanSchedule::Weekdays, 7, 30, 2);
+    schedule.addSwitchPoint(FanSchedule::Daily, 22, 0, 1);
+    schedule.addSwitchPoint(FanSchedule::Weekend, 9, 0, 3);
+    TEST_ASSERT_EQUAL(14, schedule.size());
+    for (uint8_t i = 1; i < schedule.size(); i++) {
+        TEST_ASSERT_TRUE(schedule.entry(i - 1).minuteOfWeek < schedule.entry(i).minuteOfWeek);
+    }
+
+    // Monday 06:00:30 -> night level from Sunday 22:00 active, next switch 07:30
+    schedule.setClock(1, 6, 0, 30, 1000);
+    TEST_ASSERT_EQUAL(1, switches.size());
+    TEST_ASSERT_EQUAL(1, switches.back());
+    TEST_ASSERT_EQUAL((89 * 60 + 30) * 1000, schedule.msUntilNextSwitch(1000));
+
+    // nothing happens before the deadline
+    schedule.loop(1000 + (89 * 60 + 29) * 1000);
+    TEST_ASSERT_EQUAL(1, switches.size());
+    schedule.loop(1000 + (89 * 60 + 30) * 1000);
+    TEST_ASSERT_EQUAL(2, switches.size());
+    TEST_ASSERT_EQUAL(2, switches.back());
+    TEST_ASSERT_EQUAL((14 * 60 + 30) * 60000, schedule.msUntilNextSwitch(1000 + (89 * 60 + 30) * 1000));
+
+    // clock jumps to Saturday 08:00 -> Friday 22:00 level is applied
+    schedule.setClock(6, 8, 0, 0, 5000);
+    TEST_ASSERT_EQUAL(3, switches.size());
+    TEST_ASSERT_EQUAL(1, switches.back());
+
+    // resync within the same switch interval does not repeat the level
+    schedule.setClock(6, 8, 30, 0, 5000);
+    TEST_ASSERT_EQUAL(3, switches.size());
+    TEST_ASSERT_EQUAL(30 * 60000, schedule.msUntilNextSwitch(5000));
+
+    // Sunday 23:00 wraps to Monday 07:30
+    schedule.setClock(7, 23, 0, 0, 0);
+    TEST_ASSERT_EQUAL(1, schedule.activeSpeed());
+    TEST_ASSERT_EQUAL((8 * 60 + 30) * 60000, schedule.msUntilNextSwitch(0));
+
+    // clock telegrams without day of week are ignored
+    FanSchedule unsynced;
+    unsynced.addSwitchPoint(FanSchedule::Daily, 8, 0, 2);
+    unsynced.setClock(0, 9, 0, 0, 0);
+    TEST_ASSERT_FALSE(unsynced.isSynced());
+}
+
+void test_schedule_priorities() {
+    MockFanHardware mockHw;
+    MaicoPPB30 fan(mockHw, 1, 2, 3);
+
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+    fan.setScheduleSpeed(2);
+    TEST_ASSERT_EQUAL(2, fan.getFanSpeed());
+
+    // automatic ventilation wins, switch point is applied when it ends
+    fan.setInsideHumdity(80.0);
+    TEST_ASSERT_EQUAL(fan.thresholdSpeed, fan.getFanSpeed());
+    fan.setScheduleSpeed(1);
+    TEST_ASSERT_EQUAL(fan.thresholdSpeed, fan.getFanSpeed());
+    fan.setInsideHumdity(40.0);
+    TEST_ASSERT_EQUAL(1, fan.getFanSpeed());
+
+    // manual override is replaced by the next switch point
+    fan.setFanSpeed(5);
+    TEST_ASSERT_EQUAL(5, fan.getFanSpeed());
+    fan.setScheduleSpeed(3);
+    TEST_ASSERT_EQUAL(3, fan.getFanSpeed());
+
+    // timer run keeps its speed and falls back to the schedule level
+    fan.setTimer(60, nullptr);
+    fan.setFanSpeed(5);
+    fan.setScheduleSpeed(2);
+    TEST_ASSERT_EQUAL(5, fan.getFanSpeed());
+    fan.stopTimer();
+    TEST_ASSERT_EQUAL(2, fan.getFanSpeed());
+}
+
+// Bathroom sensor trace, one telegram per minute, shower starts at minute 10
+static const float showerTrace[] = {
+    55.2, 55.0, 55.1, 55.3, 55.1, 55.0, 55.2, 55.1, 55.3, 55.2,
+    56.8, 59.1, 61.9, 64.6, 67.0, 69.3, 71.2, 73.0, 74.4, 75.6,
+    76.1, 75.0, 72.8, 70.1, 67.6, 65.3, 63.4, 61.8, 60.5, 59.4,
+    58.6, 57.9, 57.4, 57.0, 56.7, 56.4, 56.2, 56.0, 55.9, 55.8,
+};
+
+// Kitchen sensor trace, slower rise while cooking starts at minute 5
+static const float cookingTrace[] = {
+    52.0, 52.1, 51.9, 52.0, 52.1, 53.0, 54.2, 55.5, 56.7, 57.8,
+    58.8, 59.7, 60.5, 61.2, 61.8, 62.3, 62.5, 62.4, 61.8, 60.9,
+    59.9, 58.8, 57.8, 56.9, 56.0, 55.2, 54.5, 53.9, 53.4, 53.0,
+};
+
+// Replays a trace and returns the minute the fan started, or -1. With a
+// shorter spacing the sensor sends the interpolated trace more often.
+static int replayTrace(const float* trace, size_t length, float riseRate, int* stopMinute = nullptr,
+                       uint32_t spacingMs = 60000) {
+    MockFanHardware mockHw;
+    MaicoPPB30 fan(mockHw, 1, 2, 3);
+    fan.thresholdHumidityOn = 70;
+    fan.thresholdHumidityOff = 60;
+    fan.trendRiseRate = riseRate;
+    fan.trendMargin = 3;
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+
+    int startMinute = -1;
+    for (uint32_t nowMs = 0; nowMs <= (length - 1) * 60000; nowMs += spacingMs) {
+        size_t minute = nowMs / 60000;
+        float fraction = (nowMs % 60000) / 60000.0f;
+        float humidity = minute + 1 < length ? trace[minute] + (trace[minute + 1] - trace[minute]) * fraction : trace[minute];
+        mockHw.nowMs = nowMs;
+        fan.setInsideHumdity(humidity);
+        if (startMinute < 0 && fan.getFanSpeed() > 0)
+            startMinute = minute;
+        if (startMinute >= 0 && stopMinute && *stopMinute < 0 && fan.getFanSpeed() == 0)
+            *stopMinute = minute;
+    }
+    return startMinute;
+}
+
+void test_humidity_trend_latency() {
+    const size_t showerLength = sizeof(showerTrace) / sizeof(showerTrace[0]);
+    int thresholdStop = -1;
+    int trendStop = -1;
+    int thresholdStart = replayTrace(showerTrace, showerLength, 0, &thresholdStop);
+    int trendStart = replayTrace(showerTrace, showerLength, 1.5, &trendStop);
+    printf("shower: threshold only starts at minute %d, trend detection at minute %d\n",
+           thresholdStart, trendStart);
+
+    TEST_ASSERT_EQUAL(16, thresholdStart);
+    TEST_ASSERT_EQUAL(12, trendStart);
+    // boost ends at baseline (55.0) + margin, after the threshold logic released at 60 %
+    TEST_ASSERT_EQUAL(29, thresholdStop);
+    TEST_ASSERT_EQUAL(31, trendStop);
+
+    // cooking never reaches the absolute threshold
+    const size_t cookingLength = sizeof(cookingTrace) / sizeof(cookingTrace[0]);
+    int cookingStop = -1;
+    TEST_ASSERT_EQUAL(-1, replayTrace(cookingTrace, cookingLength, 0));
+    TEST_ASSERT_EQUAL(7, replayTrace(cookingTrace, cookingLength, 1.0, &cookingStop));
+    TEST_ASSERT_EQUAL(26, cookingStop);
+}
+
+void test_humidity_trend_sampling_rate() {
+    // send-on-change sensors report every few seconds during a shower
+    const size_t showerLength = sizeof(showerTrace) / sizeof(showerTrace[0]);
+    const uint32_t spacings[] = {5000, 10000, 20000};
+    for (uint32_t spacingMs : spacings) {
+        int trendStop = -1;
+        int trendStart = replayTrace(showerTrace, showerLength, 1.5, &trendStop, spacingMs);
+        printf("shower every %lu s: trend detection at minute %d, stop at minute %d\n",
+               (unsigned long)(spacingMs / 1000), trendStart, trendStop);
+        TEST_ASSERT_TRUE(trendStart >= 11 && trendStart <= 12);
+        // the baseline is the level before the shower, not the start of the rise
+        TEST_ASSERT_TRUE(trendStop >= 30 && trendStop <= 31);
+    }
+}
+
+void test_humidity_trend_ignores_noise() {
+    HumidityTrend trend;
+    // single jumping telegrams within a few seconds are no trend
+    TEST_ASSERT_FALSE(trend.addSample(0, 53, 1.0, 2));
+    TEST_ASSERT_FALSE(trend.addSample(5000, 56, 1.0, 2));
+    TEST_ASSERT_FALSE(trend.addSample(10000, 53, 1.0, 2));
+    TEST_ASSERT_FALSE(trend.isBoosting());
+    // slow drift stays below the configured rate
+    for (uint32_t minute = 1; minute < 20; minute++) {
+        TEST_ASSERT_FALSE(trend.addSample(minute * 60000, 53 + minute * 0.2f, 1.0, 2));
+    }
+    TEST_ASSERT_FALSE(trend.isBoosting());
+}
+
+void test_timer_wheel_deadlines() {
+    FanTimerWheel wheel(1000);
+    const int count = 400;
+    FanTimer timers[count];
+    uint64_t deadlines[count];
+    uint64_t fired[count];
+    int fireCount = 0;
+    uint64_t lastFired = 0;
+    bool ordered = true;
+
+    // pseudo random delays from 0 ms up to ~50 days, crossing every wheel level
+    uint32_t seed = 12345;
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint64_t delay = (uint64_t)(seed >> 8) >> ((seed >> 3) % 24);
+        if (i % 50 == 0)
+            delay = 50ULL * 24 * 3600 * 1000 + i;
+        deadlines[i] = 1000 + delay;
+        fired[i] = 0;
+        wheel.arm(timers[i], delay, [&, i]() {
+            fired[i] = wheel.now();
+            ordered = ordered && wheel.now() >= lastFired;
+            lastFired = wheel.now();
+            fireCount++;
+        });
+    }
+    TEST_ASSERT_EQUAL(count, wheel.armedCount());
+
+    // advance in uneven steps, including large jumps
+    uint64_t now = 1000;
+    while (fireCount < count) {
+        seed = seed * 1103515245 + 12345;
+        now += 1 + ((seed >> 4) % 3 == 0 ? (seed >> 10) % 40000000 : (seed >> 10) % 97);
+        wheel.advance(now);
+    }
+    TEST_ASSERT_TRUE(ordered);
+    for (int i = 0; i < count; i++) {
+        // already expired timers fire on the next tick
+        TEST_ASSERT_EQUAL(deadlines[i] > 1000 ? deadlines[i] : 1001, fired[i]);
+    }
+    TEST_ASSERT_EQUAL(0, wheel.armedCount());
+}
+
+void test_timer_wheel_periodic_and_cancel() {
+    FanTimerWheel wheel;
+    FanTimer periodic;
+    FanTimer oneShot;
+    int periodicCount = 0;
+    int oneShotCount = 0;
+
+    wheel.arm(periodic, 60000, [&]() { periodicCount++; }, 60000);
+    wheel.arm(oneShot, 150000, [&]() { oneShotCount++; });
+    wheel.advance(599999);
+    TEST_ASSERT_EQUAL(9, periodicCount);
+    TEST_ASSERT_EQUAL(1, oneShotCount);
+    TEST_ASSERT_FALSE(oneShot.isArmed());
+
+    wheel.advance(600000);
+    TEST_ASSERT_EQUAL(10, periodicCount);
+    wheel.cancel(periodic);
+    TEST_ASSERT_FALSE(periodic.isArmed());
+    wheel.advance(10000000);
+    TEST_ASSERT_EQUAL(10, periodicCount);
+
+    // short delay wrapping around the first wheel level
+    wheel.advance(10000050);
+    wheel.arm(oneShot, 40, [&]() { oneShotCount++; });
+    wheel.advance(10000089);
+    TEST_ASSERT_EQUAL(1, oneShotCount);
+    wheel.advance(10000100);
+    TEST_ASSERT_EQUAL(2, oneShotCount);
+    oneShotCount = 1;
+
+    // re-arming replaces the pending deadline
+    wheel.arm(oneShot, 1000, [&]() { oneShotCount++; });
+    wheel.arm(oneShot, 5000, [&]() { oneShotCount += 10; });
+    TEST_ASSERT_EQUAL(1, wheel.armedCount());
+    wheel.advance(10005099);
+    TEST_ASSERT_EQUAL(1, oneShotCount);
+    wheel.advance(10005100);
+    TEST_ASSERT_EQUAL(11, oneShotCount);
+}
+
+void test_fan_timer_virtual_time() {
+    FanTimerWheel wheel;
+    VirtualFanHardware hw(wheel);
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    bool expired = false;
+
+    fan.setFanSpeed(3);
+    fan.setTimer(86400, [&expired]() { expired = true; });
+    wheel.advance(86399999);
+    TEST_ASSERT_EQUAL(3, fan.getFanSpeed());
+    TEST_ASSERT_FALSE(expired);
+    wheel.advance(86400000);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    TEST_ASSERT_TRUE(expired);
+
+    // run times beyond 32 bit milliseconds do not overflow
+    expired = false;
+    fan.setFanSpeed(2);
+    fan.setTimer(60ULL * 24 * 3600, [&expired]() { expired = true; });
+    wheel.advance(86400000ULL + 60ULL * 24 * 3600 * 1000 - 1);
+    TEST_ASSERT_EQUAL(2, fan.getFanSpeed());
+    wheel.advance(86400000ULL + 60ULL * 24 * 3600 * 1000);
+    TEST_ASSERT_TRUE(expired);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+}
+
+void test_fan_timer_extend_pause() {
+    FanTimerWheel wheel;
+    VirtualFanHardware hw(wheel);
+    MaicoPPB30 fan(hw, 1, 2, 3);
+    bool expired = false;
+
+    // the run starts with the timer speed, not with the current one
+    fan.timerSpeed = 4;
+    fan.setFanSpeed(1);
+    TEST_ASSERT_EQUAL(0, fan.timerRemainingMs());
+    fan.setTimer(600, [&expired]() { expired = true; });
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    wheel.advance(100000);
+    TEST_ASSERT_EQUAL(500000, fan.timerRemainingMs());
+
+    // extending adds to the remaining time
+    fan.extendTimer(600);
+    TEST_ASSERT_EQUAL(1100000, fan.timerRemainingMs());
+
+    // paused, the time stands still and the run goes on
+    wheel.advance(300000);
+    fan.pauseTimer(true);
+    TEST_ASSERT_TRUE(fan.isTimerPaused());
+    wheel.advance(5300000);
+    TEST_ASSERT_EQUAL(900000, fan.timerRemainingMs());
+    TEST_ASSERT_EQUAL(4, fan.getFanSpeed());
+    TEST_ASSERT_FALSE(expired);
+
+    fan.pauseTimer(false);
+    wheel.advance(5300000 + 899999);
+    TEST_ASSERT_FALSE(expired);
+    TEST_ASSERT_EQUAL(1, fan.timerRemainingMs());
+    wheel.advance(5300000 + 900000);
+    TEST_ASSERT_TRUE(expired);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    TEST_ASSERT_EQUAL(0, fan.timerRemainingMs());
+    TEST_ASSERT_FALSE(fan.isTimerPaused());
+
+    // without a run extend and pause do nothing
+    fan.extendTimer(600);
+    fan.pauseTimer(true);
+    TEST_ASSERT_FALSE(fan.isSourceActive(Fan::Source_Timer));
+    TEST_ASSERT_FALSE(fan.isTimerPaused());
+}
+
+// host side module stack: parameters and KOs as set up by the ETS
+static void receiveKo(FanModule& module, GroupObject& ko, const KNXValue& value, const Dpt& type) {
+    ko.receive(value, type);
+    module.processInputKo(ko);
+}
+
+static const KnxTelegram* lastTelegram(uint16_t asap) {
+    for (auto it = knx.sent.rbegin(); it != knx.sent.rend(); ++it) {
+        if (it->asap == asap)
+            return &*it;
+    }
+    return nullptr;
+}
+
+static void resetHost() {
+    knx.reset();
+    HostState::reset();
+    openknx.setAfterStartupDelay(true);
+    openknx.flash = OpenKNX::Flash();
+    openknx.logger = OpenKNX::Logger();
+}
+
+void test_ec_fan_continuous_speed() {
+    MockFanHardware mockHw;
+    EcFan fan(mockHw, 1, 3);
+    TEST_ASSERT_EQUAL(0, mockHw.pwmValues[1]);
+    TEST_ASSERT_EQUAL(0, mockHw.pwmValues.count((uint8_t)IFanHardware::NoPin));
+
+    fan.setFanSpeed(47);
+    TEST_ASSERT_EQUAL(47, fan.getFanSpeed());
+    TEST_ASSERT_EQUAL(47 * 1024 / 100, mockHw.pwmValues[1]);
+    TEST_ASSERT_TRUE(mockHw.digitalValues[3]);
+
+    // speed 1 starts at the minimum duty, full speed stays at 100 %
+    fan.minimumDuty = 20;
+    fan.setFanSpeed(1);
+    TEST_ASSERT_EQUAL(20 * 1024 / 100, mockHw.pwmValues[1]);
+    fan.setFanSpeed(150);
+    TEST_ASSERT_EQUAL(100, fan.getFanSpeed());
+    TEST_ASSERT_EQUAL(1024, mockHw.pwmValues[1]);
+
+    fan.setFanSpeed(0);
+    TEST_ASSERT_EQUAL(0, mockHw.pwmValues[1]);
+    TEST_ASSERT_FALSE(mockHw.digitalValues[3]);
+
+    fan.setFanSpeed(60);
+    fan.setOperatingMode(Fan::OperatingMode::Off);
+    TEST_ASSERT_EQUAL(0, fan.getFanSpeed());
+    TEST_ASSERT_FALSE(mockHw.digitalValues[3]);
+
+    // the module passes FANx_EC_MIN_DUTY from hardware.h to the constructor
+    MockFanHardware startHw;
+    EcFan startFan(startHw, 1, 3, 25);
+    startFan.setFanSpeed(1);
+    TEST_ASSERT_EQUAL(25 * 1024 / 100, startHw.pwmValues[1]);
+}
+
+void test_speed_scaling_between_drivers() {
+    MockFanHardware hw1;
+    MockFanHardware hw2;
+    MaicoPPB30 stepped(hw1, 1, 2, 3);
+    EcFan continuous(hw2, 1, 3);
+
+    TEST_ASSERT_EQUAL(4, stepped.stepToSpeed(4));
+    TEST_ASSERT_EQUAL(80, continuous.stepToSpeed(4));
+    TEST_ASSERT_EQUAL(2, continuous.speedToStep(47));
+    TEST_ASSERT_EQUAL(3, stepped.percentToSpeed(50));
+    TEST_ASSERT_EQUAL(60, stepped.speedToPercent(3));
+    TEST_ASSERT_EQUAL(47, continuous.percentToSpeed(47));
+
+    // adaptive control uses the full range of the driver
+    Fan* fans[] = {&stepped, &continuous};
+    for (Fan* fan : fans) {
+        fan->setOperatingMode(Fan::OperatingMode::Automatic);
+        fan->setControlMode(Fan::ControlMode::Adaptive);
+        fan->thresholdHumidityOn = 60;
+        fan->thresholdHumidityOff = 55;
+        fan->setInsideHumdity(70.0);
+    }
+    TEST_ASSERT_EQUAL(1, stepped.getFanSpeed());    // 0.18 * 10 %RH = 1.8 steps
+    TEST_ASSERT_EQUAL(36, continuous.getFanSpeed()); // 1.8 steps = 36 %
+    continuous.setInsideHumdity(71.0);
+    TEST_ASSERT_EQUAL(39, continuous.getFanSpeed());
+}
+
+void test_pwm_allocator_conflicts() {
+    FanPwmAllocator allocator;
+
+    // fan 1 on GPIO 2/3 shares slice 1, 10 kHz at 10 bit: divider 12 3/16
+    TEST_ASSERT_EQUAL(FanPwmAllocator::Ok, allocator.claimPwm(2, 10000, 10));
+    TEST_ASSERT_EQUAL(FanPwmAllocator::Ok, allocator.claimPwm(3, 10000, 10));
+    TEST_ASSERT_EQUAL(FanPwmAllocator::Ok, allocator.claimDigital(4));
+    const FanPwmAllocator::SliceConfig& slice = allocator.slice(1);
+    TEST_ASSERT_EQUAL(1023, slice.wrap);
+    TEST_ASSERT_EQUAL(12, slice.divInt);
+    TEST_ASSERT_EQUAL(3, slice.divFrac);
+    TEST_ASSERT_EQUAL(FanPwmAllocator::Ok, allocator.firstError());
+
+    // fan 2 with its own frequency and resolution on slice 3
+    TEST_ASSERT_EQUAL(FanPwmAllocator::Ok, allocator.claimPwm(6, 25000, 12));
+    TEST_ASSERT_EQUAL(4095, allocator.slice(3).wrap);
+    TEST_ASSERT_EQUAL(1, allocator.slice(3).divInt);
+
+    TEST_ASSERT_EQUAL(FanPwmAllocator::PinInUse, allocator.claimDigital(3));
+    TEST_ASSERT_EQUAL(FanPwmAllocator::SliceConflict, allocator.claimPwm(7, 10000, 10)); // other setup on slice 3
+    TEST_ASSERT_EQUAL(FanPwmAllocator::SliceConflict, allocator.claimPwm(18, 10000, 10)); // GPIO 18 = slice 1 channel A
+    TEST_ASSERT_EQUAL(FanPwmAllocator::UnreachableFrequency, allocator.claimPwm(10, 10000, 14));
+    TEST_ASSERT_EQUAL(FanPwmAllocator::UnreachableFrequency, allocator.claimPwm(10, 10, 10));
+    TEST_ASSERT_EQUAL(FanPwmAllocator::InvalidResolution, allocator.claimPwm(10, 100, 15));
+    TEST_ASSERT_EQUAL(FanPwmAllocator::InvalidPin, allocator.claimPwm(30, 10000, 10));
+    TEST_ASSERT_EQUAL(0, allocator.slice(5).channels); // failed claims leave the slice free
+
+    TEST_ASSERT_EQUAL(FanPwmAllocator::PinInUse, allocator.firstError());
+    TEST_ASSERT_EQUAL(3, allocator.errorPin());
+}
+
+void test_pwm_duty_follows_resolution() {
+    MockFanHardware coarse;
+    MockFanHardware fine;
+    fine.pwmRange = 4096;
+    MaicoPPB30 fan1(coarse, 1, 2, 3);
+    MaicoPPB30 fan2(fine, 1, 2, 3);
+    fan1.setVentilationMode(Fan::VentilationMode::ExhaustAir);
+    fan2.setVentilationMode(Fan::VentilationMode::ExhaustAir);
+
+    TEST_ASSERT_EQUAL(512, coarse.pwmValues[1]);
+    TEST_ASSERT_EQUAL(2048, fine.pwmValues[1]);
+    // duty is (12 + step) / 24 of the range, the finer range keeps the fraction
+    const int16_t steps[] = {0, 4, 6, 8, 9, 10};
+    for (int16_t speed = 1; speed <= 5; speed++) {
+        fan1.setFanSpeed(speed);
+        fan2.setFanSpeed(speed);
+        TEST_ASSERT_EQUAL((12 + steps[speed]) * 1024 / 24, coarse.pwmValues[1]);
+        TEST_ASSERT_EQUAL((12 + steps[speed]) * 4096 / 24, fine.pwmValues[1]);
+    }
+}
+
+void test_dpt_encoding() {
+    uint8_t data[3];
+    KnxDpt::encode(21.5f, DPT_Value_Temp, data);
+    TEST_ASSERT_EQUAL_HEX8(0x0C, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x33, data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 21.5f, (float)KnxDpt::decode(data, DPT_Value_Temp));
+
+    KnxDpt::encode(-30.0f, DPT_Value_Temp, data);
+    TEST_ASSERT_EQUAL_HEX8(0x8A, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x24, data[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -30.0f, (float)KnxDpt::decode(data, DPT_Value_Temp));
+
+    KnxDpt::encode(50.0f, DPT_Scaling, data);
+    TEST_ASSERT_EQUAL_HEX8(128, data[0]);
+    TEST_ASSERT_EQUAL(50, (uint8_t)KnxDpt::decode(data, DPT_Scaling));
+
+    KnxDpt::encode((uint8_t)4, DPT_Value_1_Ucount, data);
+    TEST_ASSERT_EQUAL_HEX8(4, data[0]);
+    KnxDpt::encode(true, DPT_State, data);
+    TEST_ASSERT_EQUAL_HEX8(1, data[0]);
+}
+
+void test_module_humidity_feedback() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 55);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed), 4);
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+
+    // both fans and the status LED got their pins, each fan set up its own slices
+    TEST_ASSERT_EQUAL(FanPwmAllocator::Ok, module.pwmAllocator().firstError());
+    TEST_ASSERT_EQUAL(GPIO_FUNC_PWM, HostState::pinFunctions[FAN1_S1_PWM_PIN]);
+    TEST_ASSERT_EQUAL(1023, HostState::pwmSlices[FanPwmAllocator::sliceOf(FAN2_S1_PWM_PIN)].wrap);
+    TEST_ASSERT_TRUE(HostState::pwmSlices[FanPwmAllocator::sliceOf(FAN1_S1_PWM_PIN)].enabled);
+    TEST_ASSERT_EQUAL(OUTPUT, HostState::pinModes[STATUS_LED_PIN]);
+
+    receiveKo(module, KoFAN_CH_HumidityInside, 70.0f, DPT_Value_Humidity);
+    const KnxTelegram* feedback = lastTelegram(KoFAN_CH_LevelFeedback.asap());
+    TEST_ASSERT_NOT_NULL(feedback);
+    TEST_ASSERT_EQUAL(1, feedback->size);
+    TEST_ASSERT_EQUAL(4, feedback->data[0]);
+    TEST_ASSERT_EQUAL(Fan::Source_Automatic, lastTelegram(KoFAN_CH_ActiveSource.asap())->data[0]);
+    TEST_ASSERT_TRUE(HostState::digital[FAN1_SW_PIN]);
+
+    // second channel ignores KOs of the first one
+    _channelIndex = 1;
+    const KnxTelegram* other = lastTelegram(KoFAN_CH_LevelFeedback.asap());
+    TEST_ASSERT_TRUE(other == nullptr || other->data[0] == 0);
+
+    _channelIndex = 0;
+    receiveKo(module, KoFAN_CH_HumidityInside, 50.0f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+
+    // percent command on the step driver: 60 % = step 3
+    receiveKo(module, KoFAN_CH_LevelPercent, (uint8_t)60, DPT_Scaling);
+    TEST_ASSERT_EQUAL(3, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+    TEST_ASSERT_EQUAL(153, lastTelegram(KoFAN_CH_LevelPercentFeedback.asap())->data[0]); // 60 % on the bus
+}
+
+void test_module_timer_feedback() {
+    resetHost();
+    uint8_t _channelIndex = 1;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 1 << FAN_CH_OpModeShift); // manual
+    knx.setParamWord(FAN_ParamCalcIndex(FAN_CH_TimerSelection), 0);
+    knx.setParamInt(FAN_ParamCalcIndex(FAN_CH_TimerValue), 600);
+
+    FanModule module;
+    module.setup(true);
+    receiveKo(module, KoFAN_CH_Level, (uint8_t)3, DPT_Value_1_Ucount);
+    receiveKo(module, KoFAN_CH_TimerActivation, true, DPT_Start);
+    TEST_ASSERT_EQUAL(1, lastTelegram(KoFAN_CH_TimerFeedback.asap())->data[0]);
+
+    HostState::advanceMillis(599999);
+    module.loop();
+    TEST_ASSERT_EQUAL(1, lastTelegram(KoFAN_CH_TimerFeedback.asap())->data[0]);
+    TEST_ASSERT_EQUAL(3, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+
+    HostState::advanceMillis(1);
+    module.loop();
+    const KnxTelegram* feedback = lastTelegram(KoFAN_CH_TimerFeedback.asap());
+    TEST_ASSERT_EQUAL(0, feedback->data[0]);
+    TEST_ASSERT_EQUAL(600000, feedback->timeMs);
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+}
+
+void test_module_time_ko_schedule() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 1 << FAN_CH_OpModeShift);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SchedActive), 1);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched1Day), FanSchedule::Daily);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched1Hour), 6);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched1Speed), 2);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched2Day), FanSchedule::Daily);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched2Hour), 8);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Sched2Speed), 1);
+
+    FanModule module;
+    module.setup(true);
+
+    // Monday 07:59:30
+    const uint8_t time[] = {(1 << 5) | 7, 59, 30};
+    KoFAN_Time.receiveRaw(time, sizeof(time));
+    module.processInputKo(KoFAN_Time);
+    TEST_ASSERT_EQUAL(2, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+
+    HostState::advanceMillis(30000);
+    module.loop();
+    TEST_ASSERT_EQUAL(1, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+}
+
+static size_t countTelegrams(uint16_t asap) {
+    size_t count = 0;
+    for (const KnxTelegram& telegram : knx.sent)
+        count += telegram.asap == asap;
+    return count;
+}
+
+static uint32_t statusOf(const KnxTelegram* telegram) {
+    return telegram && telegram->size == 4 ? (uint32_t)KnxDpt::decode(telegram->data, DPT_Value_4_Ucount) : 0xFFFFFFFF;
+}
+
+void test_module_compound_status() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_VentModeAutomatic), 2 << FAN_CH_VentModeAutomaticShift); // exhaust air
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 55);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed), 4);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_StatusCompound), 1);
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+    module.loop();
+    uint16_t statusAsap = KoFAN_CH_Status.asap();
+    // initial state, automatic without inside humidity is reported as fault
+    TEST_ASSERT_EQUAL(1, countTelegrams(statusAsap));
+    uint32_t status = statusOf(lastTelegram(statusAsap));
+    TEST_ASSERT_EQUAL(0, status & FanChannel::Status_SpeedPercentMask);
+    TEST_ASSERT_EQUAL(Fan::OperatingMode::Automatic, (status >> FanChannel::Status_OpModeShift) & 0x03);
+    TEST_ASSERT_TRUE(status & FanChannel::Status_FaultHumidity);
+    TEST_ASSERT_FALSE(status & FanChannel::Status_FaultHardware);
+    // the second channel has it switched off
+    _channelIndex = 1;
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_Status.asap()));
+    _channelIndex = 0;
+
+    // automatic activation: speed, ventilation mode and source change in one telegram
+    knx.sent.clear();
+    receiveKo(module, KoFAN_CH_HumidityInside, 70.0f, DPT_Value_Humidity);
+    TEST_ASSERT_NOT_NULL(lastTelegram(KoFAN_CH_LevelFeedback.asap()));
+    TEST_ASSERT_NOT_NULL(lastTelegram(KoFAN_CH_ActiveSource.asap()));
+    module.loop();
+    module.loop();
+    TEST_ASSERT_EQUAL(1, countTelegrams(statusAsap));
+    status = statusOf(lastTelegram(statusAsap));
+    TEST_ASSERT_EQUAL(80, status & FanChannel::Status_SpeedPercentMask);
+    TEST_ASSERT_EQUAL(4, (status >> FanChannel::Status_StepShift) & 0x07);
+    TEST_ASSERT_EQUAL(Fan::VentilationMode::ExhaustAir, (status >> FanChannel::Status_VentModeShift) & 0x03);
+    TEST_ASSERT_TRUE(status & FanChannel::Status_AutomaticActive);
+    TEST_ASSERT_FALSE(status & (FanChannel::Status_OverrideActive | FanChannel::Status_TimerActive));
+    TEST_ASSERT_FALSE(status & FanChannel::Status_FaultHumidity);
+
+    // timer on top, the individual feedback stays
+    knx.sent.clear();
+    receiveKo(module, KoFAN_CH_TimerActivation, true, DPT_Start);
+    TEST_ASSERT_EQUAL(1, lastTelegram(KoFAN_CH_TimerFeedback.asap())->data[0]);
+    module.loop();
+    TEST_ASSERT_EQUAL(1, countTelegrams(statusAsap));
+    TEST_ASSERT_TRUE(statusOf(lastTelegram(statusAsap)) & FanChannel::Status_TimerActive);
+}
+
+static uint16_t remainingOf(const KnxTelegram* telegram) {
+    return telegram->data[0] << 8 | telegram->data[1];
+}
+
+void test_module_timer_remaining() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 1 << FAN_CH_OpModeShift); // manual
+    knx.setParamWord(FAN_ParamCalcIndex(FAN_CH_TimerSelection), 900);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TimerSpeed), 5);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TimerRetrigger), 1);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TimerRemainingInterval), 60);
+
+    FanModule module;
+    module.setup(true);
+    receiveKo(module, KoFAN_CH_TimerActivation, true, DPT_Start);
+    TEST_ASSERT_EQUAL(5, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+    TEST_ASSERT_EQUAL(900, remainingOf(lastTelegram(KoFAN_CH_TimerRemaining.asap())));
+
+    // sent once a minute while the run counts down
+    knx.sent.clear();
+    TEST_ASSERT_TRUE(module.msUntilNextEvent() <= 60000);
+    HostState::advanceMillis(30000);
+    module.loop();
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_TimerRemaining.asap()));
+    HostState::advanceMillis(30000);
+    module.loop();
+    TEST_ASSERT_EQUAL(840, remainingOf(lastTelegram(KoFAN_CH_TimerRemaining.asap())));
+
+    // a second activation adds the run time
+    receiveKo(module, KoFAN_CH_TimerActivation, true, DPT_Start);
+    TEST_ASSERT_EQUAL(1740, remainingOf(lastTelegram(KoFAN_CH_TimerRemaining.asap())));
+
+    // paused: no cyclic telegrams, the time stands still
+    receiveKo(module, KoFAN_CH_TimerPause, true, DPT_Switch);
+    knx.sent.clear();
+    HostState::advanceMillis(3600000);
+    module.loop();
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_TimerRemaining.asap()));
+    receiveKo(module, KoFAN_CH_TimerPause, false, DPT_Switch);
+    TEST_ASSERT_EQUAL(1740, remainingOf(lastTelegram(KoFAN_CH_TimerRemaining.asap())));
+
+    HostState::advanceMillis(1740000);
+    module.loop();
+    TEST_ASSERT_EQUAL(0, remainingOf(lastTelegram(KoFAN_CH_TimerRemaining.asap())));
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_TimerFeedback.asap())->data[0]);
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+}
+
+static uint32_t shadowClockMs = 0;
+static uint32_t shadowClock() { return shadowClockMs; }
+
+void test_shadow_divergence_statistics() {
+    shadowClockMs = 1000;
+    FanShadow shadow(shadowClock);
+    Fan& fan = shadow.fan();
+    fan.setOperatingMode(Fan::OperatingMode::Automatic);
+    fan.thresholdHumidityOn = 60;
+    fan.thresholdHumidityOff = 55;
+    fan.thresholdSpeed = 3;
+    std::vector<int16_t> steps;
+    shadow.setStepChangeCallback([&steps](int16_t step) { steps.push_back(step); });
+
+    // live fan on step 1 from the schedule, the shadow stays off: one step apart
+    shadow.setLive(1, true);
+    shadowClockMs += 10 * 60000;
+    TEST_ASSERT_EQUAL(10, shadow.divergentMinutes());
+    TEST_ASSERT_EQUAL(10, shadow.stepMinutes());
+
+    // the shadow policy switches on at 70 %RH, two steps above the live fan
+    fan.setInsideHumdity(70.0f);
+    TEST_ASSERT_EQUAL(1, steps.size());
+    TEST_ASSERT_EQUAL(3, shadow.step());
+    shadowClockMs += 5 * 60000;
+    TEST_ASSERT_EQUAL(15, shadow.divergentMinutes());
+    TEST_ASSERT_EQUAL(20, shadow.stepMinutes());
+
+    // a manual override is no decision of the policy, the comparison pauses
+    shadow.setLive(5, false);
+    TEST_ASSERT_FALSE(shadow.diverging());
+    shadowClockMs += 60 * 60000;
+    TEST_ASSERT_EQUAL(15, shadow.divergentMinutes());
+    TEST_ASSERT_EQUAL(20, shadow.stepMinutes());
+
+    // same step, then 30 s three steps apart: the totals keep milliseconds between changes
+    shadow.setLive(3, true);
+    shadowClockMs += 30000;
+    shadow.setLive(0, true);
+    TEST_ASSERT_TRUE(shadow.diverging());
+    shadowClockMs += 30000;
+    TEST_ASSERT_EQUAL(15, shadow.divergentMinutes());
+    TEST_ASSERT_EQUAL(21, shadow.stepMinutes());
+    fan.setInsideHumdity(50.0f);
+    TEST_ASSERT_EQUAL(2, steps.size());
+    TEST_ASSERT_EQUAL(0, steps.back());
+    TEST_ASSERT_FALSE(shadow.diverging());
+}
+
+void test_module_shadow_controller() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 1 << FAN_CH_OpModeShift); // manual, the fan stays off
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowEnable), 1);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdOn), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdOff), 55);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ShadowThresholdSpeed), 3);
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+    module.loop();
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_ShadowLevel.asap())->data[0]);
+    // the second channel has no shadow
+    _channelIndex = 1;
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_ShadowLevel.asap()));
+    _channelIndex = 0;
+
+    // the shadow would switch on, the outputs of the live fan stay untouched
+    knx.sent.clear();
+    int16_t pwm = HostState::pwm[FAN1_S1_PWM_PIN];
+    bool sw = HostState::digital[FAN1_SW_PIN];
+    receiveKo(module, KoFAN_CH_HumidityInside, 70.0f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(3, lastTelegram(KoFAN_CH_ShadowLevel.asap())->data[0]);
+    TEST_ASSERT_NULL(lastTelegram(KoFAN_CH_LevelFeedback.asap()));
+    TEST_ASSERT_EQUAL(pwm, HostState::pwm[FAN1_S1_PWM_PIN]);
+    TEST_ASSERT_EQUAL(sw, HostState::digital[FAN1_SW_PIN]);
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_ShadowDivergenceTime.asap()));
+
+    // three steps apart, the statistics (DPT 12.001 like the status) are sent every 5 min while diverging
+    TEST_ASSERT_TRUE(module.msUntilNextEvent() <= 5 * 60000);
+    HostState::advanceMillis(5 * 60000);
+    module.loop();
+    TEST_ASSERT_EQUAL(5, statusOf(lastTelegram(KoFAN_CH_ShadowDivergenceTime.asap())));
+    TEST_ASSERT_EQUAL(15, statusOf(lastTelegram(KoFAN_CH_ShadowDivergenceSteps.asap())));
+    // and with the change that ends the divergence
+    HostState::advanceMillis(5 * 60000);
+    receiveKo(module, KoFAN_CH_HumidityInside, 50.0f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_ShadowLevel.asap())->data[0]);
+    TEST_ASSERT_EQUAL(10, statusOf(lastTelegram(KoFAN_CH_ShadowDivergenceTime.asap())));
+    TEST_ASSERT_EQUAL(30, statusOf(lastTelegram(KoFAN_CH_ShadowDivergenceSteps.asap())));
+
+    // during the manual override nothing is counted
+    receiveKo(module, KoFAN_CH_Level, (uint8_t)2, DPT_Value_1_Ucount);
+    receiveKo(module, KoFAN_CH_HumidityInside, 70.0f, DPT_Value_Humidity);
+    HostState::advanceMillis(10 * 60000);
+    module.loop();
+    knx.sent.clear();
+    receiveKo(module, KoFAN_CH_HumidityInside, 50.0f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_ShadowLevel.asap())->data[0]);
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_ShadowDivergenceTime.asap()));
+    TEST_ASSERT_EQUAL(0, countTelegrams(KoFAN_CH_ShadowDivergenceSteps.asap()));
+    TEST_ASSERT_NULL(lastTelegram(KoFAN_CH_LevelFeedback.asap())); // the live fan stays on step 2
+}
+
+static std::vector<std::string> historyLines;
+static std::vector<uint8_t> historyBytes;
+
+void test_history_buckets() {
+    FanHistory history;
+    history.begin(0);
+    int16_t values[FanHistory::FineCount];
+
+    // humidity: mean of the telegrams, then the last value; step: highest in the bucket
+    history.set(FanHistory::Humidity, 500, 0);
+    history.set(FanHistory::Step, 1, 10000);
+    history.set(FanHistory::Step, 3, 20000);
+    history.set(FanHistory::Humidity, 520, 30000);
+    history.set(FanHistory::Step, 0, 40000);
+    history.advance(120000);
+    TEST_ASSERT_EQUAL(2, history.size(FanHistory::Fine));
+    history.read(FanHistory::Fine, FanHistory::Humidity, values);
+    TEST_ASSERT_EQUAL(510, values[0]);
+    TEST_ASSERT_EQUAL(520, values[1]);
+    history.read(FanHistory::Fine, FanHistory::Step, values);
+    TEST_ASSERT_EQUAL(3, values[0]);
+    TEST_ASSERT_EQUAL(0, values[1]);
+    history.read(FanHistory::Fine, FanHistory::Temperature, values);
+    TEST_ASSERT_EQUAL(FanHistory::NoValue, values[0]);
+
+    // a jump larger than one delta is spread over the following buckets
+    history.set(FanHistory::Temperature, 200, 120000);
+    history.set(FanHistory::Temperature, 600, 180000);
+    history.advance(420000);
+    history.read(FanHistory::Fine, FanHistory::Temperature, values);
+    const int16_t temperatures[] = {FanHistory::NoValue, FanHistory::NoValue, 200, 327, 454, 581, 600};
+    for (uint8_t i = 0; i < 7; i++)
+        TEST_ASSERT_EQUAL(temperatures[i], values[i]);
+
+    // ten fine buckets make a coarse one
+    TEST_ASSERT_EQUAL(0, history.size(FanHistory::Coarse));
+    history.advance(600000);
+    TEST_ASSERT_EQUAL(1, history.size(FanHistory::Coarse));
+    history.read(FanHistory::Coarse, FanHistory::Humidity, values);
+    TEST_ASSERT_EQUAL(519, values[0]);
+    history.read(FanHistory::Coarse, FanHistory::Step, values);
+    TEST_ASSERT_EQUAL(3, values[0]);
+
+    historyLines.clear();
+    history.writeCsv(FanHistory::Fine, [](const char* text) { historyLines.push_back(text); });
+    TEST_ASSERT_EQUAL(11, historyLines.size());
+    TEST_ASSERT_EQUAL_STRING("min,humidity,temperature,step", historyLines[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("-10,51.0,,3", historyLines[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("-7,52.0,32.7,0", historyLines[4].c_str());
+
+    // a restored checkpoint continues after a gap
+    historyBytes.clear();
+    history.writeCheckpoint([](uint8_t value) { historyBytes.push_back(value); });
+    TEST_ASSERT_EQUAL(FanHistory::CheckpointSize, historyBytes.size());
+    FanHistory restored;
+    TEST_ASSERT_TRUE(restored.readCheckpoint(historyBytes.data(), historyBytes.size(), 5000));
+    TEST_ASSERT_EQUAL(11, restored.size(FanHistory::Fine));
+    TEST_ASSERT_EQUAL(2, restored.size(FanHistory::Coarse));
+    restored.read(FanHistory::Fine, FanHistory::Temperature, values);
+    TEST_ASSERT_EQUAL(327, values[3]);
+    TEST_ASSERT_EQUAL(600, values[9]);
+    TEST_ASSERT_EQUAL(FanHistory::NoValue, values[10]);
+    historyBytes[0] = 0;
+    TEST_ASSERT_FALSE(restored.readCheckpoint(historyBytes.data(), historyBytes.size(), 5000));
+    TEST_ASSERT_EQUAL(0, restored.size(FanHistory::Fine));
+
+    // when the ring is full the oldest buckets leave and the base follows
+    history.advance(400 * 60000);
+    TEST_ASSERT_EQUAL(FanHistory::FineCount, history.size(FanHistory::Fine));
+    history.read(FanHistory::Fine, FanHistory::Temperature, values);
+    TEST_ASSERT_EQUAL(600, values[0]);
+    history.read(FanHistory::Fine, FanHistory::Humidity, values);
+    TEST_ASSERT_EQUAL(520, values[FanHistory::FineCount - 1]);
+}
+
+void test_module_history_console() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 1 << FAN_CH_OpModeShift); // manual, the fan stays off
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_HistoryEnable), 1);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_HistoryCheckpoint), 1);
+
+    std::vector<uint8_t> flash;
+    size_t rows = 0;
+    {
+        FanModule module;
+        module.setup(true);
+        module.processAfterStartupDelay();
+        receiveKo(module, KoFAN_CH_HumidityInside, 70.0f, DPT_Value_Humidity);
+        HostState::advanceMillis(2 * 60000);
+        module.loop();
+
+        TEST_ASSERT_TRUE(module.processCommand("fan hist 1", false));
+        TEST_ASSERT_EQUAL(3, openknx.logger.lines.size());
+        TEST_ASSERT_EQUAL_STRING("-2,70.0,,0", openknx.logger.lines[1].c_str());
+        TEST_ASSERT_EQUAL_STRING("-1,70.0,,0", openknx.logger.lines[2].c_str());
+        openknx.logger.lines.clear();
+        TEST_ASSERT_TRUE(module.processCommand("fan hist 2", false));
+        TEST_ASSERT_EQUAL_STRING("history of channel 2 is off", openknx.logger.lines[0].c_str());
+        TEST_ASSERT_FALSE(module.processCommand("fan status", false));
+
+        // checkpoint once per hour
+        TEST_ASSERT_TRUE(module.msUntilNextEvent() <= 58 * 60000);
+        HostState::advanceMillis(58 * 60000);
+        module.loop();
+        TEST_ASSERT_EQUAL(1, openknx.flash.saveRequests);
+        module.loop();
+        TEST_ASSERT_EQUAL(1, openknx.flash.saveRequests);
+
+        module.writeFlash();
+        flash = openknx.flash.written;
+        TEST_ASSERT_EQUAL(module.flashSize(), flash.size());
+        openknx.logger.lines.clear();
+        module.processCommand("fan hist 1", false);
+        rows = openknx.logger.lines.size() - 1;
+    }
+
+    FanModule restarted;
+    restarted.readFlash(flash.data(), flash.size());
+    restarted.setup(true);
+    HostState::advanceMillis(60000);
+    openknx.logger.lines.clear();
+    restarted.processCommand("fan hist 1", false);
+    TEST_ASSERT_EQUAL(rows + 2, openknx.logger.lines.size() - 1);
+    TEST_ASSERT_EQUAL_STRING("-3,70.0,,0", openknx.logger.lines[rows].c_str());
+    TEST_ASSERT_EQUAL_STRING("-2,,,", openknx.logger.lines[rows + 1].c_str());
+    TEST_ASSERT_EQUAL_STRING("-1,,,0", openknx.logger.lines[rows + 2].c_str());
+}
+
+void test_sensor_aggregate_incremental() {
+    SensorAggregate max;
+    max.configure(SensorAggregate::Max, 3, 0);
+    TEST_ASSERT_FALSE(max.valid());
+    TEST_ASSERT_TRUE(max.update(0, 55.0f, 0));
+    TEST_ASSERT_TRUE(max.update(1, 72.5f, 0));
+    TEST_ASSERT_FALSE(max.update(2, 60.0f, 0)); // below the maximum
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 72.5f, max.value());
+    TEST_ASSERT_TRUE(max.update(1, 58.0f, 0)); // the largest sensor drops, the next one takes over
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 60.0f, max.value());
+    TEST_ASSERT_FALSE(max.update(3, 90.0f, 0)); // beyond the configured sensors
+
+    SensorAggregate weighted;
+    weighted.configure(SensorAggregate::Weighted, 2, 0);
+    weighted.setWeight(0, 3);
+    weighted.update(0, 70.0f, 0);
+    weighted.update(1, 50.0f, 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 65.0f, weighted.value());
+    SensorAggregate mean;
+    mean.configure(SensorAggregate::Mean, 2, 0);
+    mean.setWeight(0, 3); // weights only count in the weighted mode
+    mean.update(0, 70.0f, 0);
+    mean.update(1, 50.0f, 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 60.0f, mean.value());
+
+    // a sensor without telegram leaves the aggregate until it sends again
+    SensorAggregate stale;
+    stale.configure(SensorAggregate::Max, 2, 10 * 60000);
+    stale.update(0, 80.0f, 0);
+    stale.update(1, 60.0f, 5 * 60000);
+    TEST_ASSERT_EQUAL(5 * 60000, stale.msUntilExpiry(5 * 60000));
+    TEST_ASSERT_FALSE(stale.expire(10 * 60000 - 1));
+    TEST_ASSERT_TRUE(stale.expire(10 * 60000));
+    TEST_ASSERT_EQUAL(1, stale.freshCount());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 60.0f, stale.value());
+    TEST_ASSERT_TRUE(stale.expire(15 * 60000));
+    TEST_ASSERT_FALSE(stale.valid());
+    TEST_ASSERT_EQUAL(UINT32_MAX, stale.msUntilExpiry(15 * 60000));
+    stale.update(0, 62.0f, 16 * 60000);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 62.0f, stale.value());
+
+    // running sums agree with a full recomputation over a long random sequence
+    const SensorAggregate::Mode modes[] = {SensorAggregate::Max, SensorAggregate::Mean, SensorAggregate::Weighted};
+    const uint8_t weights[] = {2, 5, 1};
+    for (SensorAggregate::Mode mode : modes) {
+        SensorAggregate aggregate;
+        aggregate.configure(mode, 3, 60000);
+        for (uint8_t i = 0; i < 3; i++)
+            aggregate.setWeight(i, weights[i]);
+        int32_t values[3] = {};
+        uint32_t times[3] = {};
+        bool seen[3] = {};
+        uint32_t seed = 12345;
+        uint32_t nowMs = 0;
+        for (uint32_t n = 0; n < 20000; n++) {
+            seed = seed * 1103515245 + 12345;
+            nowMs += (seed >> 8) % 20000;
+            uint8_t sensor = (seed >> 16) % 3;
+            int32_t value = 3000 + (seed >> 4) % 7000;
+            aggregate.expire(nowMs);
+            aggregate.update(sensor, value / 100.0f, nowMs);
+            values[sensor] = value;
+            times[sensor] = nowMs;
+            seen[sensor] = true;
+
+            int64_t sum = 0, weightSum = 0;
+            int32_t maxValue = INT32_MIN;
+            for (uint8_t i = 0; i < 3; i++) {
+                if (!seen[i] || nowMs - times[i] >= 60000)
+                    continue;
+                int32_t weight = mode == SensorAggregate::Weighted ? weights[i] : 1;
+                sum += (int64_t)values[i] * weight;
+                weightSum += weight;
+                if (values[i] > maxValue)
+                    maxValue = values[i];
+            }
+            int32_t expected = mode == SensorAggregate::Max ? maxValue : (int32_t)((sum + weightSum / 2) / weightSum);
+            if (lroundf(aggregate.value() * 100) != expected) {
+                TEST_ASSERT_EQUAL(expected, lroundf(aggregate.value() * 100));
+                break;
+            }
+        }
+    }
+}
+
+void test_module_humidity_sensors() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 65);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed), 4);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SensorCount), 2);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SensorAggregation), SensorAggregate::Max);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SensorStaleTime), 10);
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+
+    // the door sensor stays low, the shower sensor alone switches the fan on
+    receiveKo(module, KoFAN_CH_HumidityInside, 55.0f, DPT_Value_Humidity);
+    receiveKo(module, KoFAN_CH_HumidityInside2, 75.0f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(4, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+
+    // the door sensor keeps sending, the shower sensor falls silent and is excluded
+    for (int minute = 1; minute < 10; minute++) {
+        HostState::advanceMillis(60000);
+        module.loop();
+        receiveKo(module, KoFAN_CH_HumidityInside, 55.0f, DPT_Value_Humidity);
+    }
+    TEST_ASSERT_EQUAL(4, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+
+    // without further telegrams the expiry is a deadline of the tickless idle
+    uint32_t startMs = millis();
+    for (int i = 0; i < 100 && millis() - startMs < 60000; i++) {
+        uint32_t waitMs = module.msUntilNextEvent();
+        HostState::advanceMillis(waitMs < 60000 ? waitMs : 60000);
+        module.loop();
+    }
+    TEST_ASSERT_EQUAL(0, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+}
+
+void test_module_sensor_trend() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 90);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 85);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed), 4);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TrendRate), 15); // 1.5 %RH/min
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TrendMargin), 3);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_TrendSpeed), 5);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SensorCount), 3);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SensorAggregation), SensorAggregate::Max);
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+
+    // two quiet rooms send every 2 s, the bathroom rises 2.5 %RH/min and sends every 5 s
+    int boostSecond = -1;
+    for (int second = 0; second < 600 && boostSecond < 0; second++) {
+        HostState::advanceMillis(1000);
+        module.loop();
+        if (second % 2 == 0) {
+            receiveKo(module, KoFAN_CH_HumidityInside, 50.0f, DPT_Value_Humidity);
+            receiveKo(module, KoFAN_CH_HumidityInside3, 52.0f, DPT_Value_Humidity);
+        }
+        if (second % 5 == 0)
+            receiveKo(module, KoFAN_CH_HumidityInside2, 55.0f + second * 2.5f / 60, DPT_Value_Humidity);
+        const KnxTelegram* level = lastTelegram(KoFAN_CH_LevelFeedback.asap());
+        if (level && level->data[0] == 5)
+            boostSecond = second;
+    }
+    TEST_ASSERT_TRUE(boostSecond > 0 && boostSecond <= 120);
+}
+
+void test_dpt9_decoder_exhaustive() {
+    // every encoding against the generic KNX value conversion
+    uint32_t mismatches = 0;
+    for (uint32_t raw = 0; raw <= 0xFFFF; raw++) {
+        const uint8_t data[2] = {(uint8_t)(raw >> 8), (uint8_t)raw};
+        KNXValue generic = KnxDpt::decode(data, DPT_Value_Temp);
+        int32_t hundredths = 0;
+        bool valid = Dpt9Decoder::toHundredths(raw, hundredths);
+        if (raw == Dpt9Decoder::Invalid) {
+            TEST_ASSERT_FALSE(valid);
+            continue;
+        }
+        bool equal = valid && hundredths == llround((double)generic * 100);
+        // the former float path, exact up to 2^22 hundredths, far beyond any sensor range
+        if (labs(hundredths) < (1L << 22))
+            equal = equal && hundredths == lroundf((float)generic * 100) &&
+                    EnvValue::fromHundredths(hundredths).toFloat() == (float)generic;
+        if (!equal && mismatches++ == 0)
+            TEST_ASSERT_EQUAL((int32_t)llround((double)generic * 100), hundredths);
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+
+    // repeated raw bytes return the cached value, an invalid telegram has none
+    Dpt9Decoder decoder;
+    const uint8_t humidity[2] = {0x0C, 0xE2}; // 0.01 * 1250 * 2 = 25.00
+    const uint8_t invalid[2] = {0x7F, 0xFF};
+    int32_t hundredths = 0;
+    TEST_ASSERT_TRUE(decoder.decode(humidity, hundredths));
+    TEST_ASSERT_EQUAL(2500, hundredths);
+    hundredths = 0;
+    TEST_ASSERT_TRUE(decoder.decode(humidity, hundredths));
+    TEST_ASSERT_EQUAL(2500, hundredths);
+    TEST_ASSERT_FALSE(decoder.decode(invalid, hundredths));
+    TEST_ASSERT_TRUE(decoder.decode(humidity, hundredths));
+    TEST_ASSERT_EQUAL(2500, hundredths);
+}
+
+void test_module_dpt9_invalid_ignored() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 65);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed), 4);
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+
+    receiveKo(module, KoFAN_CH_HumidityInside, 55.0f, DPT_Value_Humidity);
+    size_t sent = countTelegrams(KoFAN_CH_LevelFeedback.asap());
+
+    // "invalid data" decodes to 6707.6 %RH in the generic path, the sensor keeps its last value
+    const uint8_t invalid[2] = {0x7F, 0xFF};
+    GroupObject& ko = KoFAN_CH_HumidityInside;
+    ko.receiveRaw(invalid, sizeof(invalid));
+    module.processInputKo(ko);
+    TEST_ASSERT_EQUAL(sent, countTelegrams(KoFAN_CH_LevelFeedback.asap()));
+
+    receiveKo(module, KoFAN_CH_HumidityInside, 75.0f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(4, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+}
+
+// first order room: settles at 70 %RH without fan and 3 %RH lower per step, 5 min time constant
+struct TuneRoom {
+    float humidity = 70.0f;
+
+    void advance(uint32_t ms, int16_t step) {
+        float settled = 70.0f - 3.0f * step;
+        humidity += (settled - humidity) * (1.0f - expf(-(float)ms / 300000.0f));
+    }
+};
+
+void test_auto_tune_identifies_room() {
+    FanAutoTune tune;
+    TuneRoom room;
+    uint32_t nowMs = 0;
+    tune.setHumidity(room.humidity);
+    tune.start(nowMs);
+    TEST_ASSERT_EQUAL(FanAutoTune::Running, tune.state());
+    TEST_ASSERT_EQUAL(0, tune.requestedStep());
+
+    uint8_t changes = 0;
+    while (tune.state() == FanAutoTune::Running && nowMs < 2 * 3600000) {
+        nowMs += 1000;
+        room.advance(1000, tune.requestedStep());
+        tune.setHumidity(room.humidity);
+        if (tune.loop(nowMs))
+            changes++;
+    }
+    TEST_ASSERT_EQUAL(FanAutoTune::Done, tune.state());
+    TEST_ASSERT_EQUAL(FanAutoTune::PhaseCount, changes);
+    TEST_ASSERT_EQUAL(FanAutoTune::PhaseCount * FanAutoTune::PhaseMs, nowMs);
+    // 3 %RH per step -> a third of a step per %RH
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f / 3, tune.gain());
+
+    // no humidity during a phase: failed, nothing to fit
+    FanAutoTune silent;
+    silent.start(0);
+    TEST_ASSERT_TRUE(silent.loop(FanAutoTune::PhaseMs));
+    TEST_ASSERT_EQUAL(FanAutoTune::Failed, silent.state());
+
+    // humidity that does not follow the fan is rejected
+    FanAutoTune flat;
+    flat.setHumidity(65.0f);
+    flat.start(0);
+    for (nowMs = 1000; flat.state() == FanAutoTune::Running; nowMs += 1000)
+        flat.loop(nowMs);
+    TEST_ASSERT_EQUAL(FanAutoTune::Failed, flat.state());
+}
+
+void test_speed_curve_lookup() {
+    FanSpeedCurve curve;
+    curve.addPoint(85, 3, 5);
+    curve.addPoint(65, 3, 2);
+    curve.addPoint(75, 3, 4);
+    curve.compile(5, false);
+
+    // rising: the step holds from one breakpoint to the next
+    TEST_ASSERT_EQUAL(0, curve.speed(-500, 0));
+    TEST_ASSERT_EQUAL(0, curve.speed(6499, 0));
+    TEST_ASSERT_EQUAL(2, curve.speed(6500, 0));
+    TEST_ASSERT_EQUAL(2, curve.speed(7499, 2));
+    TEST_ASSERT_EQUAL(4, curve.speed(7500, 2));
+    TEST_ASSERT_EQUAL(5, curve.speed(20000, 0));
+
+    // falling: a breakpoint is left its hysteresis below
+    TEST_ASSERT_EQUAL(4, curve.speed(7200, 4));
+    TEST_ASSERT_EQUAL(2, curve.speed(7199, 4));
+    TEST_ASSERT_EQUAL(2, curve.speed(6200, 2));
+    TEST_ASSERT_EQUAL(0, curve.speed(6199, 2));
+    TEST_ASSERT_EQUAL(5, curve.speed(8200, 5));
+    TEST_ASSERT_EQUAL(4, curve.speed(8199, 5));
+
+    // linear in the range of a continuous driver
+    curve.compile(100, true);
+    TEST_ASSERT_EQUAL(60, curve.speed(7000, 0));
+    TEST_ASSERT_EQUAL(72, curve.speed(7000, 80)); // falling curve, breakpoints at 62 and 72
+    TEST_ASSERT_EQUAL(65, curve.speed(7000, 65)); // between both curves the speed holds
+    TEST_ASSERT_EQUAL(100, curve.speed(9000, 0));
+
+    // without breakpoints the curve stays off
+    curve.clear();
+    curve.compile(5, false);
+    TEST_ASSERT_EQUAL(0, curve.speed(9000, 3));
+}
+
+void test_module_speed_curve() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ControlMode), 3 << FAN_CH_ControlModeShift); // curve
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 65);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 62);
+    const uint8_t points[][3] = {{65, 3, 2}, {75, 3, 4}, {85, 3, 5}};
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++)
+            knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_Curve1Value) + i * 3 + j, points[i][j]);
+    }
+
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+    const float humidity[] = {70, 80, 73, 71, 90, 60};
+    const uint8_t steps[] = {2, 4, 4, 2, 5, 0};
+    for (uint8_t i = 0; i < 6; i++) {
+        receiveKo(module, KoFAN_CH_HumidityInside, humidity[i], DPT_Value_Humidity);
+        TEST_ASSERT_EQUAL(steps[i], lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+    }
+}
+
+void test_predictor_energy_plan() {
+    // room without load: the excess over 50 %RH decays with 30 min at step 5
+    const uint32_t tauMs = 30 * 60000;
+    const uint32_t deadlineMs = 60 * 60000;
+    FanPredictor predictor;
+    float humidity = 50.0f;
+    uint32_t nowMs = 0;
+    // shower: 10 minutes without fan from 50 to 75 %RH, then the deadline starts
+    for (; nowMs <= 10 * 60000; nowMs += 60000) {
+        humidity = 50.0f + 2.5f * nowMs / 60000;
+        predictor.addSample(nowMs, lroundf(humidity * 100), 0, tauMs);
+    }
+    TEST_ASSERT_INT_WITHIN(50, 5000, predictor.floorHumidity()); // rises slowly while the fan is off
+    uint32_t startMs = nowMs - 60000;
+    predictor.start(startMs);
+    // already dry, no run
+    TEST_ASSERT_EQUAL(0, predictor.plan(startMs, 5900, 6000, deadlineMs, tauMs));
+    // target below the floor: as much air as possible
+    TEST_ASSERT_EQUAL(FanPredictor::StepCount, predictor.plan(startMs, 7500, 4900, deadlineMs, tauMs));
+
+    // closed loop down to 60 %RH; step 5 alone would need 27.5 min at power 125
+    double energy = 0;
+    int16_t step = 0;
+    int16_t firstStep = -1;
+    uint32_t reachedMs = 0;
+    for (nowMs = startMs; nowMs < startMs + 2 * deadlineMs && !reachedMs; nowMs += 1000) {
+        if ((nowMs - startMs) % 60000 == 0) {
+            predictor.addSample(nowMs, lroundf(humidity * 100), step, tauMs);
+            step = predictor.plan(nowMs, lroundf(humidity * 100), 6000, deadlineMs, tauMs);
+            if (firstStep < 0)
+                firstStep = step;
+        }
+        humidity -= (humidity - 50.0f) * step / FanPredictor::StepCount * 1000.0f / tauMs;
+        energy += FanPredictor::power(step) / 60.0;
+        if (humidity <= 60.0f)
+            reachedMs = nowMs - startMs;
+    }
+    // the moisture of the rise is still taken as load at first
+    TEST_ASSERT_EQUAL(FanPredictor::StepCount, firstStep);
+    TEST_ASSERT_TRUE(reachedMs > 0);
+    TEST_ASSERT_TRUE(reachedMs <= deadlineMs + deadlineMs / FanPredictor::Horizon);
+    TEST_ASSERT_TRUE(reachedMs > 30 * 60000); // slower than step 5
+    TEST_ASSERT_TRUE(energy < 0.75 * 125 * 27.5);
+}
+
+// heat recovery with fan 1 at step 4 on a device of the bus stand-in
+static size_t addSyncDevice(FanBus& bus, uint8_t role, uint8_t id, uint8_t offset) {
+    size_t device = bus.addDevice([role, id, offset]() {
+        uint8_t _channelIndex = 0;
+        knx.setParamByte(FAN_SyncRole, role << FAN_SyncRoleShift);
+        knx.setParamByte(FAN_SyncId, id);
+        knx.setParamByte(FAN_SyncPeriod, 60);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 1 << FAN_CH_OpModeShift);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SyncEnable), 1);
+        knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_SyncOffset), offset);
+    });
+    bus.with(device, [](FanModule& module) {
+        uint8_t _channelIndex = 0;
+        receiveKo(module, KoFAN_CH_Level, (uint8_t)4, DPT_Value_1_Ucount);
+    });
+    return device;
+}
+
+static bool busExhaust(FanBus& bus, size_t device) {
+    return bus.pwm(device, FAN1_S1_PWM_PIN) > 512;
+}
+
+void test_module_phase_sync_bus() {
+    resetHost();
+    FanBus bus;
+    bus.connect(KoFAN_HeatRecoverySync.asap());
+    size_t first = addSyncDevice(bus, FanPhaseSync::Candidate, 1, 0);
+    bus.run(17300);
+    size_t second = addSyncDevice(bus, FanPhaseSync::Candidate, 2, 0);
+    bus.run(23800);
+    size_t follower = addSyncDevice(bus, FanPhaseSync::Follower, 3, 50);
+    bus.setClockDrift(second, 100);
+    bus.setClockDrift(follower, -100);
+
+    // free running until the first candidate takes over: the fans started apart
+    uint32_t mismatches = 0;
+    while (bus.nowMs() < 350000) {
+        bus.run(1000);
+        mismatches += busExhaust(bus, first) != busExhaust(bus, second);
+    }
+    TEST_ASSERT_TRUE(mismatches > 0);
+    TEST_ASSERT_EQUAL(0, bus.telegrams().size());
+    bus.run(361000 - bus.nowMs());
+    TEST_ASSERT_EQUAL(1, bus.telegrams().size());
+    TEST_ASSERT_EQUAL(first, bus.telegrams()[0].device);
+    TEST_ASSERT_EQUAL(361000, bus.telegrams()[0].telegram.timeMs);
+
+    // locked: same direction on the second device, opposite with 50 % offset,
+    // sampled half a second off the edges as the drift shifts them by ms
+    bus.run(500);
+    mismatches = 0;
+    for (int i = 0; i < 1800; i++) {
+        bool exhaust = busExhaust(bus, first);
+        mismatches += busExhaust(bus, second) != exhaust;
+        mismatches += busExhaust(bus, follower) == exhaust;
+        bus.run(1000);
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT_EQUAL(16, bus.telegrams().size());
+
+    // the master goes silent, the second candidate continues its phase:
+    // the first device keeps its own grid off the bus
+    bus.setAttached(first, false);
+    size_t before = bus.telegrams().size();
+    for (int i = 0; i < 1800; i++) {
+        bool exhaust = busExhaust(bus, first);
+        mismatches += busExhaust(bus, second) != exhaust;
+        mismatches += busExhaust(bus, follower) == exhaust;
+        bus.run(1000);
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT_TRUE(bus.telegrams().size() > before);
+    for (size_t i = before; i < bus.telegrams().size(); i++)
+        TEST_ASSERT_EQUAL(second, bus.telegrams()[i].device);
+
+    // back on the bus the lower id wins again without a phase jump
+    bus.setAttached(first, true);
+    bus.run(240000);
+    before = bus.telegrams().size();
+    for (int i = 0; i < 1200; i++) {
+        bool exhaust = busExhaust(bus, first);
+        mismatches += busExhaust(bus, second) != exhaust;
+        mismatches += busExhaust(bus, follower) == exhaust;
+        bus.run(1000);
+    }
+    TEST_ASSERT_EQUAL(0, mismatches);
+    TEST_ASSERT_EQUAL(before + 10, bus.telegrams().size());
+    for (size_t i = before; i < bus.telegrams().size(); i++)
+        TEST_ASSERT_EQUAL(first, bus.telegrams()[i].device);
+}
+
+void test_module_auto_tune_flash() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ControlMode), 1 << FAN_CH_ControlModeShift); // adaptive
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 55);
+
+    std::vector<uint8_t> flash;
+    {
+        FanModule module;
+        module.setup(true);
+        module.processAfterStartupDelay();
+        TuneRoom room;
+        receiveKo(module, KoFAN_CH_HumidityInside, room.humidity, DPT_Value_Humidity);
+        receiveKo(module, KoFAN_CH_AutoTune, true, DPT_Start);
+        TEST_ASSERT_EQUAL(FanAutoTune::Running, lastTelegram(KoFAN_CH_AutoTuneStatus.asap())->data[0]);
+        TEST_ASSERT_EQUAL(Fan::Source_Tuning, lastTelegram(KoFAN_CH_ActiveSource.asap())->data[0]);
+
+        for (uint32_t s = 0; s < 3600; s += 10) {
+            room.advance(10000, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+            HostState::advanceMillis(10000);
+            receiveKo(module, KoFAN_CH_HumidityInside, room.humidity, DPT_Value_Humidity);
+            module.loop();
+        }
+        TEST_ASSERT_EQUAL(FanAutoTune::Done, lastTelegram(KoFAN_CH_AutoTuneStatus.asap())->data[0]);
+        TEST_ASSERT_EQUAL(1, openknx.flash.saveRequests);
+        TEST_ASSERT_TRUE(lastTelegram(KoFAN_CH_ActiveSource.asap())->data[0] != Fan::Source_Tuning);
+
+        module.writeFlash();
+        flash = openknx.flash.written;
+        TEST_ASSERT_EQUAL(module.flashSize(), flash.size());
+    }
+
+    // after a restart the stored gain drives the adaptive speed: 7.5 %RH above the
+    // threshold gives step 2 instead of 1 with the default gain
+    FanModule restarted;
+    restarted.readFlash(flash.data(), flash.size());
+    restarted.setup(true);
+    restarted.processAfterStartupDelay();
+    receiveKo(restarted, KoFAN_CH_HumidityInside, 67.5f, DPT_Value_Humidity);
+    TEST_ASSERT_EQUAL(2, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+}
+
+void test_module_auto_tune_absolute_mode() {
+    resetHost();
+    uint8_t _channelIndex = 0;
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift); // automatic
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ControlMode), 1 << FAN_CH_ControlModeShift); // adaptive
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn), 60);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff), 55);
+
+    // a gain per K dew point from flash stays stored but does not drive a relative channel
+    const float gain = 0.5f;
+    std::vector<uint8_t> flash(FAN_ChannelCount * 6, 0);
+    flash[0] = 2;
+    memcpy(flash.data() + 1, &gain, sizeof(gain));
+    flash[5] = Fan::HumiditySensorMode::Absolute;
+    {
+        FanModule module;
+        module.readFlash(flash.data(), flash.size());
+        module.setup(true);
+        module.processAfterStartupDelay();
+        // 7.5 %RH above the threshold: step 1 with the default gain, 4 with 0.5
+        receiveKo(module, KoFAN_CH_HumidityInside, 67.5f, DPT_Value_Humidity);
+        TEST_ASSERT_EQUAL(1, lastTelegram(KoFAN_CH_LevelFeedback.asap())->data[0]);
+        module.writeFlash();
+        float written = 0;
+        memcpy(&written, openknx.flash.written.data() + 1, sizeof(written));
+        TEST_ASSERT_EQUAL_FLOAT(gain, written);
+        TEST_ASSERT_EQUAL(Fan::HumiditySensorMode::Absolute, openknx.flash.written[5]);
+    }
+
+    // the identification needs the relative humidity, in absolute mode it fails right away
+    resetHost();
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_OpMode), 2 << FAN_CH_OpModeShift);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_ControlMode), 1 << FAN_CH_ControlModeShift);
+    knx.setParamByte(FAN_ParamCalcIndex(FAN_CH_HumSensMode), 1 << FAN_CH_HumSensModeShift);
+    FanModule module;
+    module.setup(true);
+    module.processAfterStartupDelay();
+    receiveKo(module, KoFAN_CH_AutoTune, true, DPT_Start);
+    TEST_ASSERT_EQUAL(FanAutoTune::Failed, lastTelegram(KoFAN_CH_AutoTuneStatus.asap())->data[0]);
+    const KnxTelegram* source = lastTelegram(KoFAN_CH_ActiveSource.asap());
+    TEST_ASSERT_TRUE(source == nullptr || source->data[0] != Fan::Source_Tuning);
+}
+
+void test_trace_roundtrip() {
+    const uint8_t params[] = {0x00, 0x40, 0x41};
+    const uint8_t humidity[] = {0x0C, 0x33};
+    const uint8_t step[] = {0x01};
+    uint8_t buffer[24];
+    FanTraceWriter writer(buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(writer.begin(params, sizeof(params), 5000));
+    TEST_ASSERT_TRUE(writer.record(5000, 2, humidity, sizeof(humidity)));
+    TEST_ASSERT_TRUE(writer.record(5000 + 200000, 300, step, sizeof(step)));
+    size_t complete = writer.size();
+    // buffer full: the partial record is dropped
+    TEST_ASSERT_FALSE(writer.record(300000, 2, humidity, sizeof(humidity)));
+    TEST_ASSERT_TRUE(writer.overflow());
+    TEST_ASSERT_EQUAL(complete, writer.size());
+
+    FanTraceReader reader(buffer, writer.size());
+    TEST_ASSERT_TRUE(reader.valid());
+    TEST_ASSERT_EQUAL(sizeof(params), reader.paramSize());
+    TEST_ASSERT_EQUAL(0x41, reader.params()[2]);
+
+    FanTrace::Record record;
+    TEST_ASSERT_TRUE(reader.next(record));
+    TEST_ASSERT_EQUAL(0, record.timeMs);
+    TEST_ASSERT_EQUAL(2, record.asap);
+    TEST_ASSERT_EQUAL(2, record.size);
+    TEST_ASSERT_EQUAL(0x33, record.data[1]);
+    TEST_ASSERT_TRUE(reader.next(record));
+    TEST_ASSERT_EQUAL(200000, record.timeMs);
+    TEST_ASSERT_EQUAL(300, record.asap);
+    TEST_ASSERT_EQUAL(1, record.data[0]);
+    TEST_ASSERT_FALSE(reader.next(record));
+
+    buffer[0] = 'X';
+    TEST_ASSERT_FALSE(FanTraceReader(buffer, writer.size()).valid());
+}
+
+void test_trace_replay_deterministic() {
+    // channel 1 automatic, threshold 65/60 %, run-on timer 120 s
+    uint8_t params[FAN_ParamBlockOffset + FAN_ChannelCount * FAN_ParamBlockSize] = {};
+    uint8_t _channelIndex = 0;
+    params[FAN_ParamCalcIndex(FAN_CH_OpMode)] = 2 << FAN_CH_OpModeShift;
+    params[FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOn)] = 65;
+    params[FAN_ParamCalcIndex(FAN_CH_ThresholdHumidityOff)] = 60;
+    params[FAN_ParamCalcIndex(FAN_CH_ThresholdSpeed)] = 4;
+    params[FAN_ParamCalcIndex(FAN_CH_TimerValue) + 3] = 120;
+
+    uint8_t buffer[512];
+    FanTraceWriter writer(buffer, sizeof(buffer));
+    writer.begin(params, sizeof(params), 0);
+    uint8_t data[2];
+    const float humidity[] = {55.0f, 70.0f, 72.5f, 58.0f};
+    for (uint8_t i = 0; i < 4; i++) {
+        KnxDpt::encode(humidity[i], DPT_Value_Humidity, data);
+        writer.record(60000 * (i + 1), KoFAN_CH_HumidityInside.asap(), data, 2);
+    }
+    data[0] = 1;
+    writer.record(300000, KoFAN_CH_TimerActivation.asap(), data, 1);
+
+    FanTraceReplay::Options options;
+    options.tailMs = 130000;
+    FanTraceReplay first;
+    TEST_ASSERT_TRUE(first.run(buffer, writer.size(), options));
+    TEST_ASSERT_EQUAL(5, first.stats().telegrams);
+    TEST_ASSERT_EQUAL(5, first.stats().latencyNs.size());
+
+    const std::string& output = first.output();
+    TEST_ASSERT_TRUE(output.find("120000 ko 9 04\n") != std::string::npos);
+    TEST_ASSERT_TRUE(output.find("240000 ko 9 00\n") != std::string::npos);
+    TEST_ASSERT_TRUE(output.find("300000 ko 15 01\n") != std::string::npos);
+    TEST_ASSERT_TRUE(output.find("420000 ko 15 00\n") != std::string::npos);
+
+    // scaled real time gives the same writes as the fast replay
+    FanTraceReplay second;
+    options.speed = 100000;
+    TEST_ASSERT_TRUE(second.run(buffer, writer.size(), options));
+    TEST_ASSERT_TRUE(output == second.output());
+}
+
+void test_tickless_idle_matches_polling() {
+    // channel 1 manual with heat recovery and run-on timer, channel 2 with
+    // schedule and auto-tune: every kind of deadline of the module
+    uint8_t params[FAN_ParamBlockOffset + FAN_ChannelCount * FAN_ParamBlockSize] = {};
+    uint8_t _channelIndex = 0;
+    params[FAN_ParamCalcIndex(FAN_CH_OpMode)] = 1 << FAN_CH_OpModeShift;
+    params[FAN_ParamCalcIndex(FAN_CH_TimerValue) + 3] = 90;
+    params[FAN_ParamCalcIndex(FAN_CH_StatusCompound)] = 1;
+    uint8_t data[3];
+    uint8_t buffer[512];
+    FanTraceWriter writer(buffer, sizeof(buffer));
+    uint16_t levelAsap = KoFAN_CH_Level.asap();
+    uint16_t timerAsap = KoFAN_CH_TimerActivation.asap();
+    _channelIndex = 1;
+    params[FAN_ParamCalcIndex(FAN_CH_OpMode)] = 1 << FAN_CH_OpModeShift;
+    params[FAN_ParamCalcIndex(FAN_CH_SchedActive)] = 1;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched1Day)] = FanSchedule::Daily;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched1Hour)] = 8;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched1Speed)] = 1;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched2Day)] = FanSchedule::Daily;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched2Hour)] = 8;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched2Minute)] = 2;
+    params[FAN_ParamCalcIndex(FAN_CH_Sched2Speed)] = 2;
+    writer.begin(params, sizeof(params), 0);
+
+    data[0] = (1 << 5) | 8; // Monday 08:00:10
+    data[1] = 0;
+    data[2] = 10;
+    writer.record(500, KoFAN_Time.asap(), data, 3);
+    data[0] = 3;
+    writer.record(1000, levelAsap, data, 1);
+    data[0] = 1;
+    writer.record(5000, timerAsap, data, 1);
+    KnxDpt::encode(66.0f, DPT_Value_Humidity, data);
+    writer.record(8000, KoFAN_CH_HumidityInside.asap(), data, 2);
+    data[0] = 1;
+    writer.record(200000, KoFAN_CH_AutoTune.asap(), data, 1);
+
+    FanTraceReplay::Options options;
+    options.tickMs = 1;
+    options.tailMs = 40 * 60000;
+    FanTraceReplay polled;
+    TEST_ASSERT_TRUE(polled.run(buffer, writer.size(), options));
+    options.tickless = true;
+    FanTraceReplay tickless;
+    TEST_ASSERT_TRUE(tickless.run(buffer, writer.size(), options));
+
+    // same writes at the same milliseconds, with a fraction of the loops
+    const std::string& output = polled.output();
+    TEST_ASSERT_TRUE(output == tickless.output());
+    TEST_ASSERT_TRUE(output.find("95000 ko ") != std::string::npos);  // end of the run-on timer
+    TEST_ASSERT_TRUE(output.find("110500 ko ") != std::string::npos); // schedule at 08:02
+    TEST_ASSERT_TRUE(polled.stats().loops > 2400000);
+    TEST_ASSERT_TRUE(tickless.stats().loops < 400);
+    TEST_ASSERT_TRUE(tickless.stats().sleptMs > 40 * 60000 - 100);
+}
+
+void test_fleet_matches_scalar_fan() {
+#ifdef FAN_FIXED_POINT
+    TEST_IGNORE_MESSAGE("fleet kernel models the float build");
+#else
+    // two months of the synthetic year, every mode, threads splitting the blocks
+    std::vector<FanFleet::Hour> hours = FanFleet::syntheticYear(24 * 60);
+    std::vector<FanFleet::Config> configs(4);
+    configs[0].name = "threshold";
+    configs[1].name = "adaptive";
+    configs[1].controlMode = Fan::ControlMode::Adaptive;
+    configs[1].controlGain = 0.4f;
+    configs[2].name = "absolute";
+    configs[2].sensorMode = Fan::HumiditySensorMode::Absolute;
+    configs[3].name = "absolute adaptive";
+    configs[3].sensorMode = Fan::HumiditySensorMode::Absolute;
+    configs[3].controlMode = Fan::ControlMode::Adaptive;
+    const uint32_t buildings = 1500; // second block is partial
+
+    FanFleet fleet(configs, buildings);
+    fleet.run(hours, 3);
+    for (size_t c = 0; c < configs.size(); c++) {
+        TEST_ASSERT_EQUAL(buildings, fleet.result(c).fans);
+        TEST_ASSERT_TRUE(fleet.result(c).runHours > 0);
+        for (uint32_t b = 0; b < buildings; b += 97) {
+            FanFleet::Metrics vector = fleet.metrics(c * buildings + b);
+            FanFleet::Metrics scalar = FanFleet::simulateScalar(configs[c], FanFleet::building(b), hours);
+            TEST_ASSERT_EQUAL(scalar.runHours, vector.runHours);
+            TEST_ASSERT_EQUAL(scalar.switches, vector.switches);
+            TEST_ASSERT_EQUAL(scalar.hoursAbove, vector.hoursAbove);
+        }
+    }
+#endif
+}
+
 int main(int argc, char **argv) {
     UNITY_BEGIN();
     RUN_TEST(test_fan_initialization);
     RUN_TEST(test_fan_speed_control);
     RUN_TEST(test_operating_mode_logic);
     RUN_TEST(test_automatic_mode_logic);
+    RUN_TEST(test_automatic_dwell_times);
+    RUN_TEST(test_dew_point_hysteresis);
     RUN_TEST(test_heat_recovery_timer);
+    RUN_TEST(test_heat_recovery_period_sequence);
+    RUN_TEST(test_phase_sync_election);
     RUN_TEST(test_threshold_crossing_detection);
     RUN_TEST(test_manual_override);
+    RUN_TEST(test_arbitration_interleaved_sources);
+    RUN_TEST(test_mode_machine_exhaustive);
+    RUN_TEST(test_schedule_next_switch);
+    RUN_TEST(test_schedule_priorities);
+    RUN_TEST(test_humidity_trend_latency);
+    RUN_TEST(test_humidity_trend_sampling_rate);
+    RUN_TEST(test_humidity_trend_ignores_noise);
+    RUN_TEST(test_timer_wheel_deadlines);
+    RUN_TEST(test_timer_wheel_periodic_and_cancel);
+    RUN_TEST(test_fan_timer_virtual_time);
+    RUN_TEST(test_fan_timer_extend_pause);
+    RUN_TEST(test_ec_fan_continuous_speed);
+    RUN_TEST(test_speed_scaling_between_drivers);
+    RUN_TEST(test_pwm_allocator_conflicts);
+    RUN_TEST(test_pwm_duty_follows_resolution);
+    RUN_TEST(test_dpt_encoding);
+    RUN_TEST(test_module_humidity_feedback);
+    RUN_TEST(test_module_timer_feedback);
+    RUN_TEST(test_module_timer_remaining);
+    RUN_TEST(test_module_time_ko_schedule);
+    RUN_TEST(test_module_compound_status);
+    RUN_TEST(test_shadow_divergence_statistics);
+    RUN_TEST(test_module_shadow_controller);
+    RUN_TEST(test_history_buckets);
+    RUN_TEST(test_module_history_console);
+    RUN_TEST(test_sensor_aggregate_incremental);
+    RUN_TEST(test_module_humidity_sensors);
+    RUN_TEST(test_module_sensor_trend);
+    RUN_TEST(test_dpt9_decoder_exhaustive);
+    RUN_TEST(test_module_dpt9_invalid_ignored);
+    RUN_TEST(test_module_phase_sync_bus);
+    RUN_TEST(test_auto_tune_identifies_room);
+    RUN_TEST(test_module_auto_tune_flash);
+    RUN_TEST(test_module_auto_tune_absolute_mode);
+    RUN_TEST(test_predictor_energy_plan);
+    RUN_TEST(test_speed_curve_lookup);
+    RUN_TEST(test_module_speed_curve);
+    RUN_TEST(test_trace_roundtrip);
+    RUN_TEST(test_trace_replay_deterministic);
+    RUN_TEST(test_fleet_matches_scalar_fan);
+    RUN_TEST(test_tickless_idle_matches_polling);
     UNITY_END();
     return 0;
 }